@@ -1,10 +1,40 @@
 import QtQuick 2.9
 import QtQuick.Controls 2.2
+import Evies 1.0
 
 ItemForm {
+    id: page
     property int current_index
+    property int current_id: -1
     property string current_label
+    property var space: current_id >= 0 ? spaceManager.FindSpace(current_id) : null
     label.text: current_label
+
+    // Availability for the next weeks, redrawn from the bitmap on bookings
+    AvailabilityCalendar {
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 25
+        height: 120
+        span: AvailabilityCalendar.Month
+        timer: page.space ? page.space.timer : null
+    }
+    // Bookings go to the daemon when the GUI is its client
+    property int bookingRequest: 0
+    bookButton.visible: bookingClient.connected
+    bookButton.onClicked: {
+        // .. Next whole hour, the daemon counts both ends inclusive
+        var start = Math.ceil(Date.now() / 3600000) * 3600
+        bookingRequest = bookingClient.Book(current_id, start, start + 3599)
+    }
+    Connections {
+        target: bookingClient
+        onBookingFinished: {
+            if (requestID !== page.bookingRequest) return
+            label.text = ok ? qsTr("Booked for %1 dirhams.").arg(price) : qsTr("That hour is already taken.")
+        }
+    }
     popButton.onClicked: {
         // console.log("clicked")
         stack.pop()
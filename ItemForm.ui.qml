@@ -9,6 +9,7 @@ Page {
     title: qsTr("Item " + current_index)
     // Export de_button & de_label
     property alias popButton: popButton
+    property alias bookButton: bookButton
     property alias label: label
 
     Label {
@@ -33,4 +34,14 @@ Page {
         anchors.top: parent.top
         anchors.topMargin: 25
     }
+
+    Button {
+        id: bookButton
+        height: 40
+        text: qsTr("Book next hour")
+        anchors.right: parent.right
+        anchors.rightMargin: 25
+        anchors.top: parent.top
+        anchors.topMargin: 25
+    }
 }
@@ -0,0 +1,207 @@
+#include <QObject>
+#include <QVector>
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+// User libraries
+#include "availabilitycalendar.h"
+#include "memoryusage.h"
+#include <algorithm>
+
+namespace space {
+    AvailabilityCalendar::AvailabilityCalendar(QQuickItem* parent) : QQuickItem(parent) {
+        setFlag(ItemHasContents, true);
+        MemoryUsage::TrackFacade(MemoryUsage::AvailabilityCalendarFacade, 1, sizeof(AvailabilityCalendar) + MemoryUsage::QQuickItemPrivateBytes);
+    }
+    AvailabilityCalendar::~AvailabilityCalendar() {
+        MemoryUsage::TrackFacade(MemoryUsage::AvailabilityCalendarFacade, -1, -(qint64)(sizeof(AvailabilityCalendar) + MemoryUsage::QQuickItemPrivateBytes));
+    }
+    // Setters
+    void AvailabilityCalendar::SetTimer(Time* p_timer) {
+        if (timer == p_timer) return;
+        timer = p_timer;
+        Relayout();
+        emit TimerChanged();
+    }
+    void AvailabilityCalendar::SetManager(SpaceManager* p_manager) {
+        if (manager == p_manager) return;
+        if (manager) disconnect(manager, nullptr, this, nullptr);
+        manager = p_manager;
+        // .. A replaced catalog brings new timers
+        if (manager) connect(manager, &SpaceManager::SpacesChanged, this, &AvailabilityCalendar::Relayout);
+        Relayout();
+        emit ManagerChanged();
+    }
+    void AvailabilityCalendar::SetSpan(Span p_span) {
+        if (span == p_span) return;
+        span = p_span;
+        Relayout();
+        emit SpanChanged();
+    }
+    void AvailabilityCalendar::SetFrom(const QDateTime& p_from) {
+        if (from == p_from) return;
+        from = p_from;
+        Relayout();
+        emit FromChanged();
+    }
+    void AvailabilityCalendar::SetFreeColor(const QColor& p_freeColor) {
+        if (freeColor == p_freeColor) return;
+        freeColor = p_freeColor;
+        MarkAll();
+        emit FreeColorChanged();
+    }
+    void AvailabilityCalendar::SetBookedColor(const QColor& p_bookedColor) {
+        if (bookedColor == p_bookedColor) return;
+        bookedColor = p_bookedColor;
+        MarkAll();
+        emit BookedColorChanged();
+    }
+
+    // Layout
+    int AvailabilityCalendar::SpanDays() const {
+        switch (span) {
+        case Month: return 31;
+        case Year: return 365;
+        default: return 7;
+        }
+    }
+    void AvailabilityCalendar::Relayout() {
+        for (const Lane& lane: lanes)
+            if (lane.timer) disconnect(lane.timer, nullptr, this, nullptr);
+        lanes.clear();
+        QVector<Time*> timers;
+        if (manager) {
+            for (Space* space_ptr: manager->GetSpaces()) timers.append(&space_ptr->GetTimer());
+            // .. Rows stay a few pixels high, long spans are bucketed
+            bucketHours = span == Year ? 24 : span == Month ? 6 : 1;
+        } else {
+            if (timer) timers.append(timer.data());
+            bucketHours = 1;
+        }
+        laneCells = SpanDays() * 24 / bucketHours;
+        for (int i = 0; i < timers.size(); i++) {
+            Lane lane;
+            lane.timer = timers[i];
+            lane.startHour = from.isValid() ? timers[i]->HourOf((time_t)from.toSecsSinceEpoch()) : 0;
+            lanes.append(lane);
+            connect(timers[i], &Time::WordsChanged, this, [this, i](int p_first, int p_last) { MarkWords(i, p_first, p_last); });
+        }
+        layoutDirty = true;
+        update();
+    }
+    void AvailabilityCalendar::MarkWords(int p_lane, int p_firstWord, int p_lastWord) {
+        Lane& lane = lanes[p_lane];
+        // Words to cells of this lane, hours before the lane start are off screen
+        long first = ((long)p_firstWord * 64 - lane.startHour);
+        long last = ((long)p_lastWord * 64 + 63 - lane.startHour);
+        if (last < 0 || first >= (long)laneCells * bucketHours) return;
+        int firstCell = (int)(std::max(first, 0L) / bucketHours);
+        int lastCell = (int)(std::min(last, (long)laneCells * bucketHours - 1) / bucketHours);
+        if (lane.dirtyFirst > lane.dirtyLast) {
+            lane.dirtyFirst = firstCell;
+            lane.dirtyLast = lastCell;
+        } else {
+            lane.dirtyFirst = std::min(lane.dirtyFirst, firstCell);
+            lane.dirtyLast = std::max(lane.dirtyLast, lastCell);
+        }
+        update();
+    }
+    void AvailabilityCalendar::MarkAll() {
+        for (Lane& lane: lanes) {
+            lane.dirtyFirst = 0;
+            lane.dirtyLast = laneCells - 1;
+        }
+        update();
+    }
+    QRectF AvailabilityCalendar::CellRect(int p_lane, int p_cell) const {
+        // Catalog mode: one row per lane, time runs left to right
+        if (manager) {
+            const qreal w = width() / laneCells, h = height() / lanes.size();
+            return QRectF(p_cell * w, p_lane * h, w, h);
+        }
+        // .. Single mode: one column per day, hours top to bottom
+        const qreal w = width() / SpanDays(), h = height() / 24;
+        return QRectF((p_cell / 24) * w, (p_cell % 24) * h, w, h);
+    }
+    QColor AvailabilityCalendar::CellColor(const Lane& p_lane, int p_cell) const {
+        long first = p_lane.startHour + (long)p_cell * bucketHours;
+        long last = first + bucketHours - 1;
+        if (!p_lane.timer || last < 0) return freeColor;
+        // Read the words in place, the GUI thread is blocked during sync
+        unsigned int booked = Time::CountHours(p_lane.timer->GetWords(), std::max(first, 0L), last);
+        const qreal t = (qreal)booked / bucketHours;
+        return QColor::fromRgbF(freeColor.redF() + (bookedColor.redF() - freeColor.redF()) * t,
+                                freeColor.greenF() + (bookedColor.greenF() - freeColor.greenF()) * t,
+                                freeColor.blueF() + (bookedColor.blueF() - freeColor.blueF()) * t);
+    }
+
+    // Scene graph
+    // .. Two triangles per cell, six vertices so no index type limit on large catalogs
+    QSGNode* AvailabilityCalendar::updatePaintNode(QSGNode* p_oldNode, UpdatePaintNodeData* p_data) {
+        Q_UNUSED(p_data);
+        QSGGeometryNode* node = static_cast<QSGGeometryNode*>(p_oldNode);
+        const int cells = lanes.size() * laneCells;
+        if (cells == 0 || width() <= 0 || height() <= 0) {
+            delete node;
+            layoutDirty = true;
+            return nullptr;
+        }
+        if (!node) {
+            node = new QSGGeometryNode();
+            QSGGeometry* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+            geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+            node->setGeometry(geometry);
+            node->setFlag(QSGNode::OwnsGeometry);
+            node->setMaterial(new QSGVertexColorMaterial());
+            node->setFlag(QSGNode::OwnsMaterial);
+            layoutDirty = true;
+        }
+        QSGGeometry* geometry = node->geometry();
+        if (layoutDirty) {
+            geometry->allocate(cells * 6);
+            QSGGeometry::ColoredPoint2D* vertices = geometry->vertexDataAsColoredPoint2D();
+            for (int lane = 0; lane < lanes.size(); lane++) {
+                for (int cell = 0; cell < laneCells; cell++) {
+                    // .. Colours follow below, every cell is recoloured after a relayout
+                    QRectF rect = CellRect(lane, cell).adjusted(0, 0, -0.5, -0.5);
+                    QSGGeometry::ColoredPoint2D* v = vertices + (lane * laneCells + cell) * 6;
+                    v[0].x = rect.left();  v[0].y = rect.top();
+                    v[1].x = rect.right(); v[1].y = rect.top();
+                    v[2].x = rect.left();  v[2].y = rect.bottom();
+                    v[3].x = rect.right(); v[3].y = rect.top();
+                    v[4].x = rect.right(); v[4].y = rect.bottom();
+                    v[5].x = rect.left();  v[5].y = rect.bottom();
+                }
+            }
+            for (Lane& lane: lanes) {
+                lane.dirtyFirst = 0;
+                lane.dirtyLast = laneCells - 1;
+            }
+            layoutDirty = false;
+        }
+        QSGGeometry::ColoredPoint2D* vertices = geometry->vertexDataAsColoredPoint2D();
+        for (int lane = 0; lane < lanes.size(); lane++) {
+            Lane& current = lanes[lane];
+            for (int cell = current.dirtyFirst; cell <= current.dirtyLast; cell++) {
+                const QColor color = CellColor(current, cell);
+                QSGGeometry::ColoredPoint2D* v = vertices + (lane * laneCells + cell) * 6;
+                for (int k = 0; k < 6; k++) {
+                    v[k].r = color.red();
+                    v[k].g = color.green();
+                    v[k].b = color.blue();
+                    v[k].a = 255;
+                }
+            }
+            current.dirtyFirst = 0;
+            current.dirtyLast = -1;
+        }
+        node->markDirty(QSGNode::DirtyGeometry);
+        return node;
+    }
+    void AvailabilityCalendar::geometryChanged(const QRectF& p_newGeometry, const QRectF& p_oldGeometry) {
+        QQuickItem::geometryChanged(p_newGeometry, p_oldGeometry);
+        if (p_newGeometry.size() == p_oldGeometry.size()) return;
+        layoutDirty = true;
+        update();
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef AVAILABILITYCALENDAR_H
+#define AVAILABILITYCALENDAR_H
+
+#include <QObject>
+#include <QVector>
+#include <QPointer>
+#include <QColor>
+#include <QDateTime>
+#include <QQuickItem>
+
+// User libraries
+#include "space.h"
+
+namespace space {
+    // Availability heatmap drawn straight from the hour bitmaps
+    // .. One geometry node of coloured quads, one quad per cell
+    // .. Single mode shows one timer as days by hours, catalog mode stacks
+    // .. every space of a manager as one row each, cells covering several hours
+    // .. Reservation changes recolour only the cells of the touched words
+    class AvailabilityCalendar : public QQuickItem {
+        Q_OBJECT
+        Q_PROPERTY(Time* timer READ GetTimer WRITE SetTimer NOTIFY TimerChanged)
+        Q_PROPERTY(SpaceManager* manager READ GetManager WRITE SetManager NOTIFY ManagerChanged)
+        Q_PROPERTY(Span span READ GetSpan WRITE SetSpan NOTIFY SpanChanged)
+        Q_PROPERTY(QDateTime from READ GetFrom WRITE SetFrom NOTIFY FromChanged)
+        Q_PROPERTY(QColor freeColor READ GetFreeColor WRITE SetFreeColor NOTIFY FreeColorChanged)
+        Q_PROPERTY(QColor bookedColor READ GetBookedColor WRITE SetBookedColor NOTIFY BookedColorChanged)
+    public:
+        enum Span { Week, Month, Year };
+        Q_ENUM(Span)
+    signals:
+        void TimerChanged();
+        void ManagerChanged();
+        void SpanChanged();
+        void FromChanged();
+        void FreeColorChanged();
+        void BookedColorChanged();
+    private:
+        QPointer<Time> timer;
+        QPointer<SpaceManager> manager;
+        Span span = Week;
+        QDateTime from;
+        QColor freeColor = QColor(0xe8, 0xf5, 0xe9);
+        QColor bookedColor = QColor(0xc6, 0x28, 0x28);
+
+        // One lane per timer, all lanes share the cell layout
+        // .. Cell i of a lane covers hours [start + i * bucketHours, start + (i + 1) * bucketHours)
+        struct Lane {
+            QPointer<Time> timer;
+            long startHour = 0;
+            // Cells to recolour on the next sync, empty when first > last
+            int dirtyFirst = 0, dirtyLast = -1;
+        };
+        QVector<Lane> lanes;
+        int laneCells = 0;
+        int bucketHours = 1;
+        // Positions or cell count changed, the geometry is rebuilt
+        bool layoutDirty = true;
+
+        int SpanDays() const;
+        void Relayout();
+        void MarkWords(int p_lane, int p_firstWord, int p_lastWord);
+        void MarkAll();
+        QRectF CellRect(int p_lane, int p_cell) const;
+        QColor CellColor(const Lane& p_lane, int p_cell) const;
+    protected:
+        QSGNode* updatePaintNode(QSGNode* p_oldNode, UpdatePaintNodeData* p_data) override;
+        void geometryChanged(const QRectF& p_newGeometry, const QRectF& p_oldGeometry) override;
+    public:
+        explicit AvailabilityCalendar(QQuickItem* parent = nullptr);
+        virtual ~AvailabilityCalendar();
+
+        // Setters
+        // .. Setting a manager switches to catalog mode, it wins over the timer
+        void SetTimer(Time* p_timer);
+        void SetManager(SpaceManager* p_manager);
+        void SetSpan(Span p_span);
+        void SetFrom(const QDateTime& p_from);
+        void SetFreeColor(const QColor& p_freeColor);
+        void SetBookedColor(const QColor& p_bookedColor);
+
+        // Getters
+        Time* GetTimer() const { return timer; }
+        SpaceManager* GetManager() const { return manager; }
+        Span GetSpan() const { return span; }
+        QDateTime GetFrom() const { return from; }
+        QColor GetFreeColor() const { return freeColor; }
+        QColor GetBookedColor() const { return bookedColor; }
+    };
+}
+
+#endif // AVAILABILITYCALENDAR_H
@@ -0,0 +1,167 @@
+#include <QObject>
+#include <QVector>
+#include <QSet>
+#include <QTimer>
+
+// User libraries
+#include "availabilityfeed.h"
+#include <algorithm>
+
+namespace space {
+    // Index
+    bool AvailabilityFeed::WordsOf(const space::Space* p_space, time_t p_from, time_t p_to, int& p_first, int& p_last) {
+        const Time& timer = p_space->GetTimer();
+        const long startHour = qMax(timer.HourOf(p_from), 0L), endHour = timer.HourOf(p_to - 1);
+        if (p_to <= p_from || endHour < startHour) return false;
+        p_first = (int)(startHour / 64);
+        p_last = (int)(endHour / 64);
+        return true;
+    }
+    void AvailabilityFeed::Index(quint64 p_watch, space::Space* p_space, bool p_add) {
+        const Watcher& watcher = watchers[p_watch];
+        int first, last;
+        if (!WordsOf(p_space, watcher.from, watcher.to, first, last)) return;
+        if (!p_add && !watched.contains(p_space)) return;
+        if (p_add && !watched.contains(p_space)) {
+            connect(&p_space->GetTimer(), &Time::WordsChanged, this, [this, p_space](int p_first, int p_last) {
+                Dispatch(p_space, p_first, p_last);
+            });
+            // .. Only the address is used, the space is half destroyed by then
+            connect(p_space, &QObject::destroyed, this, [this, p_space]() { Forget(p_space); });
+        }
+        Watched& entry = watched[p_space];
+        const QVector<unsigned long long>& times = p_space->GetTimer().GetWords();
+        for (int word = first; word <= last; word++) {
+            if (p_add) {
+                // .. First watcher on a word starts its shadow from the current bitmap
+                if (!entry.index.contains(word)) entry.shadow.insert(word, word < times.size() ? times[word] : 0);
+                entry.index[word].append(p_watch);
+                continue;
+            }
+            QVector<quint64>& bucket = entry.index[word];
+            bucket.removeOne(p_watch);
+            if (!bucket.isEmpty()) continue;
+            entry.index.remove(word);
+            entry.shadow.remove(word);
+        }
+        if (!entry.index.isEmpty()) return;
+        watched.remove(p_space);
+        disconnect(&p_space->GetTimer(), &Time::WordsChanged, this, nullptr);
+        disconnect(p_space, &QObject::destroyed, this, nullptr);
+    }
+    void AvailabilityFeed::Forget(space::Space* p_space) {
+        // .. Its timer is gone already, and with it that connection
+        QSet<quint64> watches;
+        for (const QVector<quint64>& bucket: watched.value(p_space).index)
+            for (quint64 watch: bucket) watches.insert(watch);
+        for (quint64 watch: watches) {
+            watchers[watch].spaces.removeOne(p_space);
+            if (pending.contains(watch)) pending[watch].remove(p_space);
+        }
+        watched.remove(p_space);
+    }
+
+    // Watches
+    quint64 AvailabilityFeed::Watch(const QVector<space::Space*>& p_spaces, time_t p_from, time_t p_to) {
+        const quint64 watch = nextWatch++;
+        Watcher& watcher = watchers[watch];
+        watcher.from = p_from;
+        watcher.to = p_to;
+        QSet<space::Space*> seen;
+        for (space::Space* space_ptr: p_spaces) {
+            if (!space_ptr || seen.contains(space_ptr)) continue;
+            seen.insert(space_ptr);
+            watcher.spaces.append(space_ptr);
+        }
+        for (space::Space* space_ptr: watcher.spaces) Index(watch, space_ptr, true);
+        return watch;
+    }
+    bool AvailabilityFeed::Unwatch(quint64 p_watch) {
+        if (!watchers.contains(p_watch)) return false;
+        for (space::Space* space_ptr: watchers[p_watch].spaces) Index(p_watch, space_ptr, false);
+        watchers.remove(p_watch);
+        pending.remove(p_watch);
+        return true;
+    }
+
+    // Changes
+    // .. Per changed word: the watchers on it, each masked to its own window
+    void AvailabilityFeed::Dispatch(space::Space* p_space, int p_first, int p_last) {
+        QHash<space::Space*, Watched>::iterator entry = watched.find(p_space);
+        if (entry == watched.end()) return;
+        const Time& timer = p_space->GetTimer();
+        const QVector<unsigned long long>& times = timer.GetWords();
+        bool gathered = false;
+        for (int word = p_first; word <= p_last; word++) {
+            QHash<int, QVector<quint64>>::const_iterator bucket = entry->index.constFind(word);
+            if (bucket == entry->index.constEnd()) continue;
+            unsigned long long& seen = entry->shadow[word];
+            const unsigned long long now = word < times.size() ? times[word] : 0;
+            const unsigned long long flipped = seen ^ now;
+            if (!flipped) continue;
+            seen = now;
+            for (quint64 watch: *bucket) {
+                const Watcher& watcher = watchers[watch];
+                const long startHour = qMax(timer.HourOf(watcher.from), 0L), endHour = timer.HourOf(watcher.to - 1);
+                const long low = qMax(startHour, (long)word * 64), high = qMin(endHour, (long)word * 64 + 63);
+                const unsigned long long inside = flipped & Time::WordMask(low % 64, high % 64);
+                if (!inside) continue;
+                // .. Flipped twice within the tick cancels out
+                pending[watch][p_space][word] ^= inside;
+                gathered = true;
+            }
+        }
+        if (gathered && !flushQueued) {
+            flushQueued = true;
+            QTimer::singleShot(0, this, &AvailabilityFeed::Flush);
+        }
+    }
+    void AvailabilityFeed::Flush() {
+        flushQueued = false;
+        QHash<quint64, QHash<space::Space*, QHash<int, unsigned long long>>> batch;
+        batch.swap(pending);
+        QList<quint64> watches = batch.keys();
+        std::sort(watches.begin(), watches.end());
+        for (quint64 watch: watches) {
+            const QHash<space::Space*, QHash<int, unsigned long long>>& spaces = batch[watch];
+            QVector<AvailabilityChange> changes;
+            for (space::Space* space_ptr: watchers.value(watch).spaces) {
+                QHash<space::Space*, QHash<int, unsigned long long>>::const_iterator flips = spaces.constFind(space_ptr);
+                // .. A receiver may have unwatched or deleted it meanwhile
+                if (flips == spaces.constEnd() || !watched.contains(space_ptr)) continue;
+                const Time& timer = space_ptr->GetTimer();
+                const QHash<int, unsigned long long> shadow = watched.value(space_ptr).shadow;
+                QList<int> words = flips->keys();
+                std::sort(words.begin(), words.end());
+                // Runs of flipped hours in the same state, merged across words
+                AvailabilityChange run;
+                long runEnd = -2;
+                for (int word: words) {
+                    const unsigned long long state = shadow.value(word);
+                    for (unsigned long long bits = flips->value(word); bits; bits &= bits - 1) {
+                        const int bit = qCountTrailingZeroBits(bits);
+                        const long hour = (long)word * 64 + bit;
+                        const bool booked = (state >> bit) & 1;
+                        if (hour == runEnd + 1 && booked == run.booked) {
+                            runEnd = hour;
+                            continue;
+                        }
+                        if (run.space) {
+                            run.to = timer.TimeOfHour(runEnd + 1);
+                            changes.append(run);
+                        }
+                        run.space = space_ptr;
+                        run.from = timer.TimeOfHour(hour);
+                        run.booked = booked;
+                        runEnd = hour;
+                    }
+                }
+                if (run.space) {
+                    run.to = timer.TimeOfHour(runEnd + 1);
+                    changes.append(run);
+                }
+            }
+            if (!changes.isEmpty()) emit Changed(watch, changes);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef AVAILABILITYFEED_H
+#define AVAILABILITYFEED_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+
+// User libraries
+#include "space.h"
+#include <ctime>
+
+namespace space {
+    // Hours of one space whose availability changed, [from, to)
+    struct AvailabilityChange {
+        space::Space* space = nullptr;
+        time_t from = 0, to = 0;
+        // Booked now, or freed
+        bool booked = false;
+    };
+
+    // Availability changes for consumers watching (spaces, window)
+    // .. Watchers are indexed by space and by the bitmap words their window covers,
+    // .. a change to words [first, last] of a timer only looks at the watchers on them
+    // .. The watched words of each space are shadowed, so a change is reduced to the
+    // .. exact hours that flipped, and only those inside a watcher's window reach it
+    // .. Changes are gathered per watcher and delivered once per event-loop tick;
+    // .. hours flipped back within the tick are not reported
+    class AvailabilityFeed : public QObject {
+        Q_OBJECT
+    signals:
+        // Ordered by space in watch order, then by time
+        void Changed(quint64 watch, const QVector<space::AvailabilityChange>& changes);
+    private:
+        struct Watcher {
+            QVector<space::Space*> spaces;
+            time_t from = 0, to = 0;
+        };
+        // Per space: watchers by word, in watch order, and the watched words as last seen
+        struct Watched {
+            QHash<int, QVector<quint64>> index;
+            QHash<int, unsigned long long> shadow;
+        };
+        QHash<quint64, Watcher> watchers;
+        QHash<space::Space*, Watched> watched;
+        // Flipped hours per watcher, space and word, since the last delivery
+        QHash<quint64, QHash<space::Space*, QHash<int, unsigned long long>>> pending;
+        quint64 nextWatch = 1;
+        bool flushQueued = false;
+
+        // Words of p_space's timer covering [p_from, p_to), false if none
+        static bool WordsOf(const space::Space* p_space, time_t p_from, time_t p_to, int& p_first, int& p_last);
+        void Index(quint64 p_watch, space::Space* p_space, bool p_add);
+        void Forget(space::Space* p_space);
+        void Dispatch(space::Space* p_space, int p_first, int p_last);
+    public:
+        explicit AvailabilityFeed(QObject* parent = nullptr) : QObject(parent) {}
+        virtual ~AvailabilityFeed() {}
+
+        // Watches hours [p_from, p_to) of p_spaces, returns the watch ID
+        // .. A destroyed space leaves its watches silently
+        quint64 Watch(const QVector<space::Space*>& p_spaces, time_t p_from, time_t p_to);
+        bool Unwatch(quint64 p_watch);
+        // Delivers the gathered changes now instead of on the next tick
+        void Flush();
+
+        int GetNumberOfWatches() const { return watchers.size(); }
+    };
+}
+
+#endif // AVAILABILITYFEED_H
@@ -0,0 +1,21 @@
+QT += testlib quick
+CONFIG += c++11 console
+CONFIG -= app_bundle
+TARGET = evies-bench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# Shared catalog, reservation and protocol sources
+include(../space.pri)
+
+# Runs headless on the offscreen platform with the software scene graph
+# .. Machine-readable results: ./evies-bench -o results.csv,csv
+# .. or -o results.xml,xml, one file per commit to compare
+# .. EVIES_BENCH_MAX_SPACES caps the largest catalog (default 1000000)
+SOURCES += main.cpp \
+    spacebenchmark.cpp \
+    ../spacebanner.cpp
+
+HEADERS += \
+    spacebenchmark.h \
+    ../spacebanner.h
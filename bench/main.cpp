@@ -0,0 +1,17 @@
+#include <QGuiApplication>
+#include <QQuickWindow>
+#include <QtTest>
+
+// User libraries
+#include "spacebenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    // Headless unless a platform is forced, software rendering works everywhere
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+    QGuiApplication app(argc, argv);
+    space::SpaceBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
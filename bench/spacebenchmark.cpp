@@ -0,0 +1,347 @@
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QDateTime>
+#include <QtTest>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQmlComponent>
+#include <QQuickWindow>
+#include <QQuickItem>
+
+// User libraries
+#include "spacebenchmark.h"
+#include "spacelistmodel.h"
+#include "spacebanner.h"
+#include "superspace.h"
+#include "groupbooking.h"
+#include "occupancy.h"
+#include "reservationstore.h"
+#include <random>
+
+namespace space {
+    // Fixed origin, results must not depend on the wall clock
+    static const time_t benchmarkOrigin = 1514764800;   // 2018-01-01 00:00 UTC
+    static const unsigned long yearHours = 365 * 24;
+
+    // A year of hours booked at random with the given ratio
+    // .. The hours from p_freeStart for p_freeLength are left free
+    static QVector<unsigned long long> RandomTimes(double p_fill, unsigned long p_freeStart, unsigned long p_freeLength) {
+        std::mt19937 generator(42);
+        std::bernoulli_distribution booked(p_fill);
+        QVector<unsigned long long> times;
+        for (unsigned long hour = 0; hour < yearHours; hour++)
+            if (booked(generator)) Time::SetHours(times, hour, hour);
+        if (p_freeLength > 0) Time::ClearHours(times, p_freeStart, p_freeStart + p_freeLength - 1);
+        return times;
+    }
+
+    // Same row layout as main.qml
+    static const char listQml[] =
+        "import QtQuick 2.9\n"
+        "import Evies 1.0\n"
+        "ListView {\n"
+        "    width: 600; height: 800\n"
+        "    model: spaceModel\n"
+        "    delegate: SpaceBanner {\n"
+        "        width: 600; height: 150\n"
+        "        summary: model.summary\n"
+        "        primaryTag: summary.outdoor ? \"Parks & view\" : \"Indoor venue\"\n"
+        "    }\n"
+        "}\n";
+
+    void SpaceBenchmark::initTestCase() {
+        if (qEnvironmentVariableIsSet("EVIES_BENCH_MAX_SPACES"))
+            maxSpaces = qEnvironmentVariableIntValue("EVIES_BENCH_MAX_SPACES");
+        qRegisterMetaType<SpaceSummary>();
+        qmlRegisterType<SpaceBanner>("Evies", 1, 0, "SpaceBanner");
+        manager = new SpaceManager();
+        manager->GetRandomizedSpaces(qMin(100000, maxSpaces));
+        catalog = new CatalogStore(manager);
+        queries = new SpaceQueryService(catalog);
+        search = new SearchIndex(catalog);
+    }
+    void SpaceBenchmark::cleanupTestCase() {
+        delete search;
+        delete queries;
+        delete catalog;
+        qDeleteAll(manager->GetSpaces());
+        delete manager;
+    }
+
+    // Reservations
+    void SpaceBenchmark::AddRemoveReservation_data() {
+        QTest::addColumn<int>("span");
+        QTest::addColumn<double>("fill");
+        for (int span: {1, 24, 168, 720})
+            for (double fill: {0.0, 0.5, 0.9})
+                QTest::newRow(qPrintable(QString("span %1h fill %2%").arg(span).arg(fill * 100))) << span << fill;
+    }
+    void SpaceBenchmark::AddRemoveReservation() {
+        QFETCH(int, span);
+        QFETCH(double, fill);
+        // .. Unaligned start, the range crosses word boundaries
+        const unsigned long start = 24 * 90 + 13;
+        Time timer(100, benchmarkOrigin);
+        timer.MergeTimes(RandomTimes(fill, start, span));
+        const time_t from = timer.TimeOfHour(start), to = timer.TimeOfHour(start + span - 1);
+        double price = 0;
+        QBENCHMARK {
+            timer.AddReservation(from, to, price);
+            timer.RemoveReservation(from, to);
+        }
+        QVERIFY(price > 0);
+    }
+    void SpaceBenchmark::ConflictingReservation_data() {
+        AddRemoveReservation_data();
+    }
+    void SpaceBenchmark::ConflictingReservation() {
+        QFETCH(int, span);
+        QFETCH(double, fill);
+        // .. Only the last hour is taken, the whole span is scanned before failing
+        const unsigned long start = 24 * 90 + 13;
+        Time timer(100, benchmarkOrigin);
+        QVector<unsigned long long> times = RandomTimes(fill, start, span);
+        Time::SetHours(times, start + span - 1, start + span - 1);
+        timer.MergeTimes(times);
+        const time_t from = timer.TimeOfHour(start), to = timer.TimeOfHour(start + span - 1);
+        double price = 0;
+        bool booked = false;
+        QBENCHMARK {
+            booked |= timer.AddReservation(from, to, price);
+        }
+        QVERIFY(!booked);
+    }
+    void SpaceBenchmark::CountBooked_data() {
+        QTest::addColumn<int>("span");
+        for (int span: {24, 720, 8000})
+            QTest::newRow(qPrintable(QString("span %1h").arg(span))) << span;
+    }
+    void SpaceBenchmark::CountBooked() {
+        QFETCH(int, span);
+        Time timer(100, benchmarkOrigin);
+        timer.MergeTimes(RandomTimes(0.5, 0, 0));
+        // .. Unaligned ends, one booking and release between counts keeps the index updates in
+        const time_t hour = timer.TimeOfHour(24 * 90 + 13);
+        double price = 0;
+        unsigned int booked = 0;
+        QBENCHMARK {
+            timer.RemoveReservation(hour, hour);
+            timer.AddReservation(hour, hour, price);
+            booked = timer.CountBooked(13, 13 + span - 1);
+        }
+        QCOMPARE(booked, Time::CountHours(timer.GetWords(), 13, 13 + span - 1));
+    }
+    void SpaceBenchmark::CommitReservation() {
+        ReservationStore store(manager);
+        Time& timer = manager->GetSpaces()[0]->GetTimer();
+        const time_t from = QDateTime::currentDateTime().addDays(400).toSecsSinceEpoch();
+        const ReservationSnapshot pinned = store.Open();
+        double price = 0;
+        QBENCHMARK {
+            timer.AddReservation(from, from + 3 * 3600, price);
+            timer.RemoveReservation(from, from + 3 * 3600);
+            store.Commit();
+            store.Collect();
+        }
+        QVERIFY(store.GetEpoch() > pinned.GetEpoch());
+    }
+
+    // Catalog
+    void SpaceBenchmark::BuildSpaces_data() {
+        QTest::addColumn<int>("spaces");
+        QTest::newRow("1k") << 1000;
+        QTest::newRow("100k") << 100000;
+        QTest::newRow("1M") << 1000000;
+    }
+    void SpaceBenchmark::BuildSpaces() {
+        QFETCH(int, spaces);
+        if (spaces > maxSpaces) QSKIP("Above EVIES_BENCH_MAX_SPACES");
+        SpaceManager built;
+        // .. Too large to repeat, measured once per row
+        QBENCHMARK_ONCE {
+            built.GetRandomizedSpaces(spaces);
+        }
+        QCOMPARE(built.GetSpaces().size(), spaces);
+        qDeleteAll(built.GetSpaces());
+    }
+    void SpaceBenchmark::BuildSnapshot_data() {
+        BuildSpaces_data();
+    }
+    void SpaceBenchmark::BuildSnapshot() {
+        QFETCH(int, spaces);
+        if (spaces > maxSpaces) QSKIP("Above EVIES_BENCH_MAX_SPACES");
+        SpaceManager built;
+        built.GetRandomizedSpaces(spaces);
+        {
+            CatalogStore store(&built);
+            QBENCHMARK {
+                store.Rebuild();
+            }
+            QCOMPARE(store.Pin()->GetSize(), spaces);
+        }
+        qDeleteAll(built.GetSpaces());
+    }
+
+    // Queries
+    void SpaceBenchmark::Query_data() {
+        QTest::addColumn<QVariantMap>("query");
+        const qint64 week = QDateTime::currentDateTime().addDays(7).toSecsSinceEpoch();
+        QVariantMap filter, sort, availability, combined;
+        filter.insert("minPeople", 200);
+        filter.insert("minScore", 2.5);
+        filter.insert("requiredFlags", SpaceRecord::Catering);
+        sort.insert("sortKey", "rank");
+        sort.insert("descending", true);
+        availability.insert("freeFrom", week);
+        availability.insert("freeTo", week + 4 * 3600);
+        combined = filter;
+        combined.unite(availability);
+        combined.insert("sortKey", "price");
+        combined.insert("limit", 50);
+        QTest::newRow("filter") << filter;
+        QTest::newRow("sort") << sort;
+        QTest::newRow("availability") << availability;
+        QTest::newRow("filter+availability+top50") << combined;
+    }
+    void SpaceBenchmark::Query() {
+        QFETCH(QVariantMap, query);
+        const SpaceQuery parsed = SpaceQuery::FromVariantMap(query);
+        int results = 0;
+        QBENCHMARK {
+            results = queries->Submit("benchmark", parsed).result().size();
+        }
+        QVERIFY(results >= 0);
+    }
+    void SpaceBenchmark::Complete_data() {
+        // .. Generated names are "Space<ID>", every prefix below is shared by many of them
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<int>("kind");
+        QTest::newRow("prefix 1") << "s" << (int)SearchIndex::PrefixMatch;
+        QTest::newRow("prefix 7") << "space52" << (int)SearchIndex::PrefixMatch;
+        QTest::newRow("tag") << "#outd" << (int)SearchIndex::PrefixMatch;
+        QTest::newRow("swapped") << "spcae521" << (int)SearchIndex::FuzzyMatch;
+        QTest::newRow("two typos") << "spcae52l3" << (int)SearchIndex::FuzzyMatch;
+        QTest::newRow("inside") << "ace52" << (int)SearchIndex::InfixMatch;
+    }
+    void SpaceBenchmark::Complete() {
+        QFETCH(QString, text);
+        QFETCH(int, kind);
+        QVector<SearchIndex::Match> matches;
+        QBENCHMARK {
+            matches = search->Complete(text, 10);
+        }
+        QVERIFY(!matches.isEmpty());
+        QCOMPARE((int)matches.first().kind, kind);
+    }
+    void SpaceBenchmark::ListModelUpdate() {
+        SpaceListModel model(catalog);
+        QVariantMap query;
+        query.insert("sortKey", "price");
+        query.insert("minScore", 1);
+        model.SetFilter(query);
+        const QVector<Space*>& spaces = manager->GetSpaces();
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<int> pick(0, spaces.size() - 1), price(100, 9999);
+        // .. Each round reprices one space and publishes it, the row moves by binary search
+        QBENCHMARK {
+            spaces[pick(generator)]->GetTimer().SetDirhamsPerHour(price(generator));
+            catalog->Flush();
+        }
+        QCOMPARE(model.GetCount(), model.rowCount());
+    }
+
+    // Reports
+    void SpaceBenchmark::RevenueReport_data() {
+        QTest::addColumn<bool>("snapshot");
+        QTest::newRow("live") << false;
+        QTest::newRow("snapshot") << true;
+    }
+    void SpaceBenchmark::RevenueReport() {
+        QFETCH(bool, snapshot);
+        OccupancyWindow window;
+        window.from = QDateTime::currentDateTime().toSecsSinceEpoch();
+        window.to = window.from + 90 * 24 * 3600;
+        ReservationStore store(manager);
+        Utilisation total;
+        QBENCHMARK {
+            total = snapshot ? OccupancyReport::Catalog(store.Open(), window) : OccupancyReport::Catalog(*manager, window);
+        }
+        QVERIFY(total.hours > 0);
+    }
+
+    // Group booking
+    void SpaceBenchmark::GroupSolve_data() {
+        QTest::addColumn<int>("rooms");
+        QTest::addColumn<int>("breakouts");
+        for (int rooms: {100, 300, 1000})
+            for (int breakouts: {4, 12})
+                QTest::newRow(qPrintable(QString("%1 rooms 1+%2").arg(rooms).arg(breakouts))) << rooms << breakouts;
+    }
+    void SpaceBenchmark::GroupSolve() {
+        QFETCH(int, rooms);
+        QFETCH(int, breakouts);
+        const QVector<Space*>& spaces = manager->GetSpaces();
+        if (rooms > spaces.size()) QSKIP("Above EVIES_BENCH_MAX_SPACES");
+        SuperSpace venue(1, "benchmark", 0, 0);
+        for (int i = 0; i < rooms; i++) venue.AddSpace(spaces[i]);
+        GroupRequest request;
+        request.from = QDateTime::currentDateTime().addDays(7).toSecsSinceEpoch();
+        request.to = request.from + 8 * 3600;
+        request.alternatives = 5;
+        GroupRequest::Room plenary, breakout;
+        plenary.minPeople = 150;
+        plenary.flags = SpaceRecord::Sound;
+        breakout.minPeople = 20;
+        breakout.flags = SpaceRecord::Projector;
+        request.rooms.append(plenary);
+        request.rooms.insert(request.rooms.size(), breakouts, breakout);
+        GroupBooking::Result result;
+        QBENCHMARK {
+            result = GroupBooking::Solve(venue, request);
+        }
+        QVERIFY(result.complete);
+    }
+
+    // QML
+    void SpaceBenchmark::DelegateInstantiation() {
+        SpaceListModel model(catalog);
+        QQmlEngine engine;
+        engine.rootContext()->setContextProperty("spaceModel", &model);
+        QQmlComponent component(&engine);
+        component.setData(listQml, QUrl());
+        QVERIFY2(component.isReady(), qPrintable(component.errorString()));
+        QQuickWindow window;
+        window.resize(600, 800);
+        // .. Creation plus the first frame of visible rows
+        QBENCHMARK {
+            QQuickItem* list = qobject_cast<QQuickItem*>(component.create());
+            list->setParentItem(window.contentItem());
+            window.grabWindow();
+            delete list;
+        }
+    }
+    void SpaceBenchmark::Scrolling() {
+        SpaceListModel model(catalog);
+        QQmlEngine engine;
+        engine.rootContext()->setContextProperty("spaceModel", &model);
+        QQmlComponent component(&engine);
+        component.setData(listQml, QUrl());
+        QVERIFY2(component.isReady(), qPrintable(component.errorString()));
+        QQuickWindow window;
+        window.resize(600, 800);
+        QScopedPointer<QQuickItem> list(qobject_cast<QQuickItem*>(component.create()));
+        list->setParentItem(window.contentItem());
+        window.grabWindow();
+        const qreal end = list->property("contentHeight").toReal() - list->height();
+        qreal y = 0;
+        // .. One page of rows per frame, rows are created and recycled on the way
+        QBENCHMARK {
+            for (int frame = 0; frame < 20; frame++) {
+                y = y + 800 > end ? 0 : y + 800;
+                list->setProperty("contentY", y);
+                window.grabWindow();
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef SPACEBENCHMARK_H
+#define SPACEBENCHMARK_H
+
+#include <QObject>
+#include <QVector>
+
+// User libraries
+#include "space.h"
+#include "catalogstore.h"
+#include "spacequery.h"
+#include "searchindex.h"
+
+namespace space {
+    // QtTest benchmarks for the hot paths
+    // .. Reservations on the hour bitmap, catalog construction, queries,
+    // .. incremental list updates and the QML list
+    class SpaceBenchmark : public QObject {
+        Q_OBJECT
+    private:
+        // Largest catalog to build, rows above it are skipped
+        int maxSpaces = 1000000;
+        // Shared catalog for the query and list benchmarks
+        SpaceManager* manager = nullptr;
+        CatalogStore* catalog = nullptr;
+        SpaceQueryService* queries = nullptr;
+        SearchIndex* search = nullptr;
+    private slots:
+        void initTestCase();
+        void cleanupTestCase();
+
+        // Reservations, by span length and fill ratio
+        void AddRemoveReservation_data();
+        void AddRemoveReservation();
+        void ConflictingReservation_data();
+        void ConflictingReservation();
+        // Booked hours in a window through the occupancy index, by window length
+        void CountBooked_data();
+        void CountBooked();
+        // One booking and release committed as versions while a snapshot pins the old ones
+        void CommitReservation();
+
+        // Catalog construction at 1k, 100k and 1M spaces
+        void BuildSpaces_data();
+        void BuildSpaces();
+        void BuildSnapshot_data();
+        void BuildSnapshot();
+
+        // Queries on the shared catalog
+        void Query_data();
+        void Query();
+        // Type-ahead, one keystroke: prefix, typo and inside a word
+        void Complete_data();
+        void Complete();
+        // One booking through the catalog into a sorted, filtered list model
+        void ListModelUpdate();
+
+        // Revenue over the shared catalog, live or through a reservation snapshot
+        void RevenueReport_data();
+        void RevenueReport();
+
+        // Plenary plus breakouts at one venue, by venue size
+        void GroupSolve_data();
+        void GroupSolve();
+
+        // QML list on the offscreen platform
+        void DelegateInstantiation();
+        void Scrolling();
+    };
+}
+
+#endif // SPACEBENCHMARK_H
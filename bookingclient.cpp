@@ -0,0 +1,150 @@
+#include <QObject>
+#include <QByteArray>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+// User libraries
+#include "bookingclient.h"
+
+namespace space {
+    // Connection
+    void BookingClient::ConnectToServer(const QString& p_address) {
+        Disconnect();
+        if (p_address.startsWith("tcp:")) {
+            QTcpSocket* tcp = new QTcpSocket(this);
+            tcp->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            connect(tcp, &QAbstractSocket::connected, this, &BookingClient::ConnectedChanged);
+            connect(tcp, &QAbstractSocket::disconnected, this, &BookingClient::ConnectedChanged);
+            tcp->connectToHost(QHostAddress::LocalHost, p_address.mid(4).toUShort());
+            socket = tcp;
+        } else {
+            QLocalSocket* local = new QLocalSocket(this);
+            connect(local, &QLocalSocket::connected, this, &BookingClient::ConnectedChanged);
+            connect(local, &QLocalSocket::disconnected, this, &BookingClient::ConnectedChanged);
+            local->connectToServer(p_address);
+            socket = local;
+        }
+        connect(socket, &QIODevice::readyRead, this, &BookingClient::Receive);
+    }
+    void BookingClient::Disconnect() {
+        if (!socket) return;
+        socket->close();
+        socket->deleteLater();
+        socket = nullptr;
+        buffer.clear();
+        pending.clear();
+        pendingHead = 0;
+        listing.clear();
+        listingSent = relist = false;
+        emit ConnectedChanged();
+    }
+    bool BookingClient::IsConnected() const {
+        if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket.data()))
+            return local->state() == QLocalSocket::ConnectedState;
+        if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket.data()))
+            return tcp->state() == QAbstractSocket::ConnectedState;
+        return false;
+    }
+
+    // Requests
+    quint32 BookingClient::Send(quint8 p_opcode, const QByteArray& p_payload) {
+        if (!socket) return 0;
+        QByteArray frame;
+        const quint32 requestID = nextRequestID++;
+        BookingProtocol::AppendFrame(frame, requestID, p_opcode, p_payload);
+        // .. Sockets buffer writes made before the connection is up
+        socket->write(frame);
+        pending.append(p_opcode);
+        return requestID;
+    }
+    int BookingClient::Book(unsigned int p_spaceID, qint64 p_startTime, qint64 p_endTime) {
+        return Send(BookingProtocol::Book, BookingWriter().U32(p_spaceID).I64(p_startTime).I64(p_endTime).GetData());
+    }
+    int BookingClient::Cancel(unsigned int p_spaceID, qint64 p_startTime, qint64 p_endTime) {
+        return Send(BookingProtocol::Cancel, BookingWriter().U32(p_spaceID).I64(p_startTime).I64(p_endTime).GetData());
+    }
+    int BookingClient::AddReview(unsigned int p_spaceID, const QString& p_review, float p_score) {
+        return Send(BookingProtocol::AddReview, BookingWriter().U32(p_spaceID).Str(p_review).F32(p_score).GetData());
+    }
+
+    // Catalog mirror
+    void BookingClient::Mirror(CatalogStore* p_catalog) {
+        catalog = p_catalog;
+        connect(this, &BookingClient::ConnectedChanged, this, [this]() {
+            if (IsConnected()) Refresh();
+        });
+        if (IsConnected()) Refresh();
+    }
+    void BookingClient::Refresh() {
+        if (!catalog || !socket) return;
+        // .. A listing under way starts over once done, its pages may predate the change
+        if (listingSent) {
+            relist = true;
+            return;
+        }
+        listing.clear();
+        listingSent = Send(BookingProtocol::ListSpaces, BookingWriter().U32(0).U32(ListPage).GetData()) != 0;
+    }
+    void BookingClient::ReceiveList(BookingReader& p_in) {
+        const quint32 count = p_in.U32();
+        for (quint32 i = 0; i < count && p_in.IsOk(); i++) {
+            SpaceRecord record;
+            record.ID = p_in.U32();
+            record.name = p_in.Str();
+            record.dirhamsPerHour = p_in.F64();
+            record.score = p_in.F32();
+            listing.append(record);
+        }
+        if (!p_in.IsOk()) {
+            listing.clear();
+            listingSent = relist = false;
+            return;
+        }
+        // A full page, more may follow
+        if (count == ListPage) {
+            Send(BookingProtocol::ListSpaces, BookingWriter().U32(listing.size()).U32(ListPage).GetData());
+            return;
+        }
+        listingSent = false;
+        if (relist) {
+            relist = false;
+            Refresh();
+            return;
+        }
+        if (catalog) catalog->Replace(listing);
+        listing.clear();
+    }
+
+    // Replies
+    void BookingClient::Receive() {
+        buffer.append(socket->readAll());
+        int offset = 0;
+        quint32 requestID;
+        quint8 status;
+        QByteArray payload;
+        bool error = false;
+        while (BookingProtocol::TakeFrame(buffer, offset, requestID, status, payload, error)) {
+            const quint8 opcode = pendingHead < pending.size() ? pending[pendingHead++] : 0xff;
+            emit Replied(requestID, status, payload);
+            BookingReader in(payload);
+            if (opcode == BookingProtocol::Book)
+                emit BookingFinished(requestID, status == BookingProtocol::Ok, status == BookingProtocol::Ok ? in.F64() : 0);
+            else if (opcode == BookingProtocol::AddReview) {
+                emit ReviewAdded(requestID, status == BookingProtocol::Ok, status == BookingProtocol::Ok ? in.F32() : 0);
+                // .. The score changed, the mirror follows
+                if (status == BookingProtocol::Ok) Refresh();
+            } else if (opcode == BookingProtocol::ListSpaces && listingSent) {
+                if (status == BookingProtocol::Ok) ReceiveList(in);
+                else listingSent = relist = false;
+            }
+        }
+        buffer.remove(0, offset);
+        // Drop answered opcodes once in a while instead of on every reply
+        if (pendingHead > 4096) {
+            pending.remove(0, pendingHead);
+            pendingHead = 0;
+        }
+        if (error) Disconnect();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef BOOKINGCLIENT_H
+#define BOOKINGCLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QIODevice>
+#include <QPointer>
+
+// User libraries
+#include "bookingprotocol.h"
+#include "catalogstore.h"
+
+namespace space {
+    // Client side of the booking daemon, usable from C++ and QML
+    // .. Requests are pipelined: Send never waits for earlier replies
+    class BookingClient : public QObject {
+        Q_OBJECT
+        Q_PROPERTY(bool connected READ IsConnected NOTIFY ConnectedChanged)
+    signals:
+        void ConnectedChanged();
+        // Every reply, raw
+        void Replied(quint32 requestID, quint8 status, const QByteArray& payload);
+        // QML friendly replies
+        void BookingFinished(int requestID, bool ok, double price);
+        void ReviewAdded(int requestID, bool ok, float score);
+    private:
+        QPointer<QIODevice> socket;
+        QByteArray buffer;
+        quint32 nextRequestID = 1;
+        // Opcodes of requests still waiting, replies arrive in order
+        QVector<quint8> pending;
+        int pendingHead = 0;
+        // Mirrored catalog, filled page by page from ListSpaces
+        enum { ListPage = 1024 };
+        QPointer<CatalogStore> catalog;
+        SpaceRecords listing;
+        bool listingSent = false;
+        bool relist = false;
+
+        void Receive();
+        void ReceiveList(BookingReader& p_in);
+    public:
+        explicit BookingClient(QObject* parent = nullptr) : QObject(parent) {}
+        virtual ~BookingClient() {}
+
+        // Local socket name, or "tcp:<port>" for the loopback TCP listener
+        Q_INVOKABLE void ConnectToServer(const QString& p_address);
+        Q_INVOKABLE void Disconnect();
+        bool IsConnected() const;
+
+        // Returns the request ID echoed by Replied, 0 when not connected
+        quint32 Send(quint8 p_opcode, const QByteArray& p_payload);
+        Q_INVOKABLE int Book(unsigned int p_spaceID, qint64 p_startTime, qint64 p_endTime);
+        Q_INVOKABLE int Cancel(unsigned int p_spaceID, qint64 p_startTime, qint64 p_endTime);
+        Q_INVOKABLE int AddReview(unsigned int p_spaceID, const QString& p_review, float p_score);
+
+        // Feeds p_catalog, a store without a manager, with the daemon's spaces
+        // .. Listed on every connection and after each accepted review, Refresh lists again on demand
+        // .. Records carry ID, name, price and score; bookings stay on the daemon
+        void Mirror(CatalogStore* p_catalog);
+        Q_INVOKABLE void Refresh();
+    };
+}
+
+#endif // BOOKINGCLIENT_H
@@ -0,0 +1,79 @@
+#include <QByteArray>
+#include <QString>
+#include <QtEndian>
+
+// User libraries
+#include "bookingprotocol.h"
+#include <cstring>
+
+namespace space {
+    // Frames
+    void BookingProtocol::AppendFrame(QByteArray& p_out, quint32 p_requestID, quint8 p_code, const QByteArray& p_payload) {
+        char header[HeaderSize];
+        qToLittleEndian<quint32>(quint32(p_payload.size() + 5), header);
+        qToLittleEndian<quint32>(p_requestID, header + 4);
+        header[8] = (char)p_code;
+        p_out.append(header, HeaderSize);
+        p_out.append(p_payload);
+    }
+    bool BookingProtocol::TakeFrame(const QByteArray& p_buffer, int& p_offset, quint32& p_requestID, quint8& p_code,
+                                    QByteArray& p_payload, bool& p_error) {
+        p_error = false;
+        if (p_buffer.size() - p_offset < HeaderSize) return false;
+        const char* header = p_buffer.constData() + p_offset;
+        const quint32 length = qFromLittleEndian<quint32>(header);
+        if (length < 5 || length > MaxFrameSize) {
+            p_error = true;
+            return false;
+        }
+        if ((quint32)(p_buffer.size() - p_offset - 4) < length) return false;
+        p_requestID = qFromLittleEndian<quint32>(header + 4);
+        p_code = (quint8)header[8];
+        p_payload = p_buffer.mid(p_offset + HeaderSize, length - 5);
+        p_offset += 4 + length;
+        return true;
+    }
+    int BookingProtocol::FrameSize(const QByteArray& p_buffer, int p_offset) {
+        if (p_buffer.size() - p_offset < 4) return 0;
+        const quint32 length = qFromLittleEndian<quint32>(p_buffer.constData() + p_offset);
+        return length < 5 || length > MaxFrameSize ? 0 : 4 + (int)length;
+    }
+
+    // Payloads
+    // .. Floats travel as their IEEE bit patterns
+    BookingWriter& BookingWriter::F32(float p_value) {
+        quint32 bits;
+        std::memcpy(&bits, &p_value, sizeof(bits));
+        return U32(bits);
+    }
+    BookingWriter& BookingWriter::F64(double p_value) {
+        quint64 bits;
+        std::memcpy(&bits, &p_value, sizeof(bits));
+        return U64(bits);
+    }
+    BookingWriter& BookingWriter::Str(const QString& p_value) {
+        const QByteArray utf8 = p_value.toUtf8();
+        U32(utf8.size());
+        data.append(utf8);
+        return *this;
+    }
+    float BookingReader::F32() {
+        quint32 bits = U32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    double BookingReader::F64() {
+        quint64 bits = U64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    QString BookingReader::Str() {
+        const quint32 length = U32();
+        if (!ok || position + (qint64)length > data.size()) { ok = false; return QString(); }
+        QString value = QString::fromUtf8(data.constData() + position, length);
+        position += length;
+        return value;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef BOOKINGPROTOCOL_H
+#define BOOKINGPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtEndian>
+
+// User libraries
+#include <ctime>
+
+namespace space {
+    // Compact binary protocol of the booking daemon
+    // .. Frame: quint32 length of the rest, quint32 request ID, quint8 opcode (status in replies), payload
+    // .. Integers and floats are little endian, strings are quint32 length + UTF-8
+    // .. Requests may be pipelined, replies come back in request order per connection
+    class BookingProtocol {
+    public:
+        enum Opcode : quint8 {
+            Ping       = 0,
+            Info       = 1,   // -> u64 catalog version, u32 space count
+            ListSpaces = 2,   // u32 offset, u32 limit -> u32 n, n x (u32 ID, str name, f64 price, f32 score)
+            Book       = 3,   // u32 space ID, i64 start, i64 end -> f64 price
+            Cancel     = 4,   // u32 space ID, i64 start, i64 end
+            BookBatch  = 5,   // u32 n, n x (u32, i64, i64) -> u32 n, n x (u8 status, f64 price)
+            GetTimes   = 6,   // u32 space ID -> i64 origin, u32 n, n x u64
+            AddReview  = 7,   // u32 space ID, str review, f32 score -> f32 new score
+            GetReviews = 8    // u32 space ID -> u32 n, n x str
+        };
+        enum Status : quint8 {
+            Ok         = 0,
+            Conflict   = 1,
+            NotFound   = 2,
+            Invalid    = 3,
+            Unknown    = 4
+        };
+        // Frame header is length + ID + code
+        enum { HeaderSize = 9, MaxFrameSize = 16 << 20 };
+
+        // Append one complete frame to p_out
+        static void AppendFrame(QByteArray& p_out, quint32 p_requestID, quint8 p_code, const QByteArray& p_payload);
+        // Take the frame starting at p_offset if it is complete, advancing p_offset
+        // .. p_error is set when the length field is out of range
+        static bool TakeFrame(const QByteArray& p_buffer, int& p_offset, quint32& p_requestID, quint8& p_code,
+                              QByteArray& p_payload, bool& p_error);
+        // Bytes of the frame starting at p_offset, header included, as its length field declares
+        // .. 0 until the length field is in, or when it is out of range
+        static int FrameSize(const QByteArray& p_buffer, int p_offset = 0);
+    };
+
+    // Little endian payload writer
+    class BookingWriter {
+    private:
+        QByteArray data;
+        template <typename T> void Put(T p_value) {
+            char bytes[sizeof(T)];
+            qToLittleEndian<T>(p_value, bytes);
+            data.append(bytes, sizeof(T));
+        }
+    public:
+        BookingWriter& U8(quint8 p_value) { data.append((char)p_value); return *this; }
+        BookingWriter& U32(quint32 p_value) { Put<quint32>(p_value); return *this; }
+        BookingWriter& U64(quint64 p_value) { Put<quint64>(p_value); return *this; }
+        BookingWriter& I64(qint64 p_value) { Put<qint64>(p_value); return *this; }
+        BookingWriter& F32(float p_value);
+        BookingWriter& F64(double p_value);
+        BookingWriter& Str(const QString& p_value);
+        const QByteArray& GetData() const { return data; }
+    };
+
+    // Little endian payload reader
+    // .. Reading past the end yields zeros and clears IsOk
+    class BookingReader {
+    private:
+        const QByteArray& data;
+        int position = 0;
+        bool ok = true;
+        template <typename T> T Get() {
+            if (position + (int)sizeof(T) > data.size()) { ok = false; return T(0); }
+            T value = qFromLittleEndian<T>(data.constData() + position);
+            position += sizeof(T);
+            return value;
+        }
+    public:
+        explicit BookingReader(const QByteArray& p_data) : data(p_data) {}
+        quint8 U8() { return Get<quint8>(); }
+        quint32 U32() { return Get<quint32>(); }
+        quint64 U64() { return Get<quint64>(); }
+        qint64 I64() { return Get<qint64>(); }
+        float F32();
+        double F64();
+        QString Str();
+        bool IsOk() const { return ok; }
+        bool AtEnd() const { return position >= data.size(); }
+    };
+}
+
+#endif // BOOKINGPROTOCOL_H
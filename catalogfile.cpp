@@ -0,0 +1,90 @@
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+
+// User libraries
+#include "catalogfile.h"
+#include "spacequery.h"
+#include "bookingprotocol.h"
+
+namespace space {
+    static const char magic[] = "EVIESCAT";
+
+    bool CatalogFile::Save(const SpaceManager& p_manager, QIODevice& p_out) {
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        BookingWriter header;
+        header.U32(Version).U32(spaces.size());
+        if (p_out.write(magic, 8) != 8 || p_out.write(header.GetData()) < 0) return false;
+        // .. One space at a time, large catalogs are never held twice in memory
+        for (const Space* space_ptr: spaces) {
+            const SpaceRecord record = SpaceRecord::FromSpace(*space_ptr);
+            const Dimensions& dims = space_ptr->GetDims();
+            BookingWriter writer;
+            writer.U32(record.ID).Str(record.name)
+                  .F32(dims.GetLength()).F32(dims.GetWidth()).F32(dims.GetHeight())
+                  .U32(record.numberOfPeople).U32(record.numberOfSeats).U32(record.flags)
+                  .F64(record.dirhamsPerHour).I64(record.originTime).U32(record.times.size());
+            for (unsigned long long word: record.times) writer.U64(word);
+            const QVector<QString> reviews = space_ptr->GetReview().GetReviews();
+            writer.F32(record.score).U32(reviews.size());
+            for (const QString& review: reviews) writer.Str(review);
+            if (p_out.write(writer.GetData()) < 0) return false;
+        }
+        return true;
+    }
+
+    bool CatalogFile::Load(QIODevice& p_in, QVector<Space*>& p_spaces) {
+        const QByteArray data = p_in.readAll();
+        if (!data.startsWith(magic)) return false;
+        const QByteArray body = data.mid(8);
+        BookingReader reader(body);
+        const quint32 version = reader.U32();
+        const quint32 count = reader.U32();
+        if (!reader.IsOk() || version != Version) return false;
+        QVector<Space*> spaces;
+        spaces.reserve(count);
+        for (quint32 i = 0; i < count && reader.IsOk(); i++) {
+            const quint32 ID = reader.U32();
+            const QString name = reader.Str();
+            const float length = reader.F32(), width = reader.F32(), height = reader.F32();
+            const quint32 people = reader.U32(), seats = reader.U32(), flags = reader.U32();
+            const double price = reader.F64();
+            const qint64 origin = reader.I64();
+            // .. A word count past the end of the data is malformed, not a huge allocation
+            const quint32 words = reader.U32();
+            if (!reader.IsOk() || words > (quint32)body.size() / 8) break;
+            QVector<unsigned long long> times(words);
+            for (quint32 j = 0; j < words; j++) times[j] = reader.U64();
+            const float score = reader.F32();
+            const quint32 reviewCount = reader.U32();
+            if (!reader.IsOk() || reviewCount > (quint32)body.size() / 4) break;
+            QVector<QString> reviews;
+            reviews.reserve(reviewCount);
+            for (quint32 j = 0; j < reviewCount; j++) reviews.append(reader.Str());
+            if (!reader.IsOk()) break;
+
+            Space* space_ptr = new Space(
+                ID, name, length, width, height, people,
+                seats, flags & SpaceRecord::Slanted, flags & SpaceRecord::Surround, flags & SpaceRecord::Comfy,
+                price,
+                flags & SpaceRecord::Outdoor,
+                flags & SpaceRecord::Catering,
+                flags & SpaceRecord::NaturalLight,
+                flags & SpaceRecord::ArtificialLight,
+                flags & SpaceRecord::Projector,
+                flags & SpaceRecord::Sound,
+                flags & SpaceRecord::Cameras);
+            Time& timer = space_ptr->GetTimer();
+            // .. Origins are whole hours on both sides
+            timer.MergeTimes(Time::ShiftHours(times, (long)((origin - (qint64)timer.GetOriginTime()) / 3600)));
+            space_ptr->GetReview().SetReviews(reviews, score);
+            spaces.append(space_ptr);
+        }
+        if (!reader.IsOk() || spaces.size() != (int)count) {
+            qDeleteAll(spaces);
+            return false;
+        }
+        p_spaces = spaces;
+        return true;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef CATALOGFILE_H
+#define CATALOGFILE_H
+
+#include <QObject>
+#include <QVector>
+#include <QIODevice>
+
+// User libraries
+#include "space.h"
+
+namespace space {
+    // Binary catalog file: spaces with their bookings and reviews
+    // .. "EVIESCAT", u32 version, u32 n, then n spaces, encoded like booking protocol payloads:
+    // .. u32 ID, str name, f32 length, width, height, u32 people, u32 seats, u32 flags (SpaceRecord::Flag),
+    // .. f64 price, i64 origin, u32 n, n x u64 words, f32 score, u32 n, n x str review
+    // .. Bookings are stored against their origin and moved onto the loaded timer's hours,
+    // .. hours before the new origin are dropped like on an iCalendar import
+    class CatalogFile {
+    public:
+        enum { Version = 1 };
+        static bool Save(const SpaceManager& p_manager, QIODevice& p_out);
+        // Spaces are created in the calling thread, nothing is returned from a malformed file
+        static bool Load(QIODevice& p_in, QVector<Space*>& p_spaces);
+    };
+}
+
+#endif // CATALOGFILE_H
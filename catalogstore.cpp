@@ -0,0 +1,237 @@
+#include <QObject>
+#include <QVector>
+#include <QSharedPointer>
+#include <QMutexLocker>
+#include <QTimer>
+
+// User libraries
+#include "catalogstore.h"
+#include "memoryusage.h"
+#include <algorithm>
+
+namespace space {
+    // Snapshots
+    SpaceRecords CatalogSnapshot::ToRecords() const {
+        SpaceRecords records;
+        records.reserve(size);
+        for (const QSharedPointer<const SpaceRecords>& shard: shards) records += *shard;
+        return records;
+    }
+
+    // Pins
+    CatalogPin::CatalogPin(const CatalogPin& p_other) : snapshot(p_other.snapshot) {
+        // .. Already pinned by p_other, cannot be reclaimed under us
+        if (snapshot) snapshot->pins.ref();
+    }
+    CatalogPin::~CatalogPin() {
+        if (snapshot) snapshot->pins.deref();
+    }
+
+    // Store
+    CatalogStore::CatalogStore(SpaceManager* p_manager, QObject* parent) : QObject(parent) {
+        manager = p_manager;
+        current.storeRelease(new CatalogSnapshot());
+        if (!manager) return;
+        connect(manager, &SpaceManager::SpacesChanged, this, &CatalogStore::Rebuild);
+        // .. A manager-wide update is published as one version right away, not on the next tick
+        connect(manager, &SpaceManager::SpacesUpdated, this, &CatalogStore::Flush);
+        Rebuild();
+    }
+    CatalogStore::~CatalogStore() {
+        // No reader may outlive the store
+        delete current.loadAcquire();
+        for (CatalogSnapshot* snapshot: retired) delete snapshot;
+    }
+    CatalogPin CatalogStore::Pin() const {
+        // Announce the pin before loading, so a writer that swapped
+        // .. meanwhile sees us and keeps the old version alive
+        pinning.fetchAndAddOrdered(1);
+        CatalogSnapshot* snapshot = current.loadAcquire();
+        snapshot->pins.ref();
+        pinning.fetchAndAddOrdered(-1);
+        return CatalogPin(snapshot);
+    }
+    quint64 CatalogStore::GetVersion() const {
+        return current.loadAcquire()->version;
+    }
+    void CatalogStore::Publish(CatalogSnapshot* p_next) {
+        p_next->version = nextVersion++;
+        CatalogSnapshot* previous = current.fetchAndStoreOrdered(p_next);
+        retired.append(previous);
+        Reclaim();
+        QueueReclaim();
+        emit Published(p_next->version);
+    }
+    void CatalogStore::QueueReclaim() {
+        // Readers still hold old versions, retry until they let go
+        if (retired.isEmpty() || reclaimQueued) return;
+        reclaimQueued = true;
+        QTimer::singleShot(100, this, [this]() {
+            QMutexLocker locker(&writeLock);
+            reclaimQueued = false;
+            Reclaim();
+            QueueReclaim();
+        });
+    }
+    void CatalogStore::Reclaim() {
+        // .. A reader between load and pin may hold any retired version
+        if (pinning.fetchAndAddOrdered(0) != 0) return;
+        for (int i = retired.size() - 1; i >= 0; i--) {
+            if (retired[i]->pins.loadAcquire() == 0) {
+                delete retired[i];
+                retired.remove(i);
+            }
+        }
+    }
+    void CatalogStore::Track() {
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        tracked.reserve(spaces.size());
+        for (int i = 0; i < spaces.size(); i++) {
+            space::Space* space_ptr = spaces[i];
+            tracked.append(space_ptr);
+            // Everything a SpaceRecord reads
+            auto mark = [this, i]() { MarkDirty(i); };
+            connect(space_ptr, &Space::NameChanged, this, mark);
+            connect(space_ptr, &Space::NumberOfPeopleChanged, this, mark);
+            connect(space_ptr, &Space::OutdoorChanged, this, mark);
+            connect(space_ptr, &Space::CateringChanged, this, mark);
+            connect(space_ptr, &Space::NaturalLightChanged, this, mark);
+            connect(space_ptr, &Space::ArtificialLightChanged, this, mark);
+            connect(space_ptr, &Space::ProjectorChanged, this, mark);
+            connect(space_ptr, &Space::SoundChanged, this, mark);
+            connect(space_ptr, &Space::CamerasChanged, this, mark);
+            connect(&space_ptr->GetDims(), &Dimensions::AreaChanged, this, mark);
+            connect(&space_ptr->GetSeats(), &Seating::NumberOfSeatsChanged, this, mark);
+            connect(&space_ptr->GetSeats(), &Seating::SlantedChanged, this, mark);
+            connect(&space_ptr->GetSeats(), &Seating::SurroundChanged, this, mark);
+            connect(&space_ptr->GetSeats(), &Seating::ComfyChanged, this, mark);
+            connect(&space_ptr->GetTimer(), &Time::TimesChanged, this, mark);
+            connect(&space_ptr->GetTimer(), &Time::DirhamsPerHourChanged, this, mark);
+            connect(&space_ptr->GetReview(), &Review::ReviewsChanged, this, mark);
+        }
+    }
+    void CatalogStore::Untrack() {
+        for (const QPointer<space::Space>& space_ptr: tracked) {
+            // .. Deleted spaces are disconnected already
+            if (!space_ptr) continue;
+            disconnect(space_ptr, nullptr, this, nullptr);
+            disconnect(&space_ptr->GetDims(), nullptr, this, nullptr);
+            disconnect(&space_ptr->GetSeats(), nullptr, this, nullptr);
+            disconnect(&space_ptr->GetTimer(), nullptr, this, nullptr);
+            disconnect(&space_ptr->GetReview(), nullptr, this, nullptr);
+        }
+        tracked.clear();
+    }
+    void CatalogStore::MarkDirty(int p_index) {
+        if (isDirty[p_index]) return;
+        isDirty[p_index] = true;
+        dirty.append(p_index);
+        // Coalesce a burst of changes into one version
+        if (!flushQueued) {
+            flushQueued = true;
+            QTimer::singleShot(0, this, &CatalogStore::Flush);
+        }
+    }
+    void CatalogStore::Rebuild() {
+        if (!manager) return;
+        EVIES_TIME_SCOPE(CatalogRebuildTimer);
+        QMutexLocker locker(&writeLock);
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        CatalogSnapshot* next = new CatalogSnapshot();
+        next->size = spaces.size();
+        for (int begin = 0; begin < spaces.size(); begin += CatalogSnapshot::ShardSize) {
+            const int end = qMin(begin + (int)CatalogSnapshot::ShardSize, spaces.size());
+            SpaceRecords* shard = new SpaceRecords();
+            shard->reserve(end - begin);
+            for (int i = begin; i < end; i++) shard->append(SpaceRecord::FromSpace(*spaces[i]));
+            next->shards.append(QSharedPointer<const SpaceRecords>(shard));
+        }
+        // Old spaces may be gone, start tracking from scratch
+        Untrack();
+        dirty.clear();
+        isDirty.fill(false, spaces.size());
+        Track();
+        Publish(next);
+        emit Rebuilt(next->version);
+    }
+    void CatalogStore::Flush() {
+        QMutexLocker locker(&writeLock);
+        flushQueued = false;
+        if (dirty.isEmpty()) return;
+        EVIES_TIME_SCOPE(CatalogFlushTimer);
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        QVector<int> changed;
+        changed.swap(dirty);
+        std::sort(changed.begin(), changed.end());
+        SpaceRecords records;
+        records.reserve(changed.size());
+        for (int index: changed) {
+            isDirty[index] = false;
+            records.append(SpaceRecord::FromSpace(*spaces[index]));
+        }
+        CatalogSnapshot* next = Amend(changed, records);
+        Publish(next);
+        emit RecordsChanged(next->version, changed);
+    }
+    CatalogSnapshot* CatalogStore::Amend(const QVector<int>& p_indexes, const SpaceRecords& p_records) const {
+        const CatalogSnapshot* previous = current.loadAcquire();
+        // Copy-on-write: share every shard, then replace the touched ones
+        CatalogSnapshot* next = new CatalogSnapshot();
+        next->size = previous->size;
+        next->shards = previous->shards;
+        QVector<SpaceRecords*> copies(next->shards.size(), nullptr);
+        for (int i = 0; i < p_indexes.size(); i++) {
+            const int shard = p_indexes[i] / CatalogSnapshot::ShardSize;
+            if (!copies[shard]) {
+                copies[shard] = new SpaceRecords(*next->shards[shard]);
+                next->shards[shard] = QSharedPointer<const SpaceRecords>(copies[shard]);
+            }
+            (*copies[shard])[p_indexes[i] % CatalogSnapshot::ShardSize] = p_records[i];
+        }
+        return next;
+    }
+    void CatalogStore::Replace(const SpaceRecords& p_records) {
+        EVIES_TIME_SCOPE(CatalogRebuildTimer);
+        QMutexLocker locker(&writeLock);
+        CatalogSnapshot* next = new CatalogSnapshot();
+        next->size = p_records.size();
+        for (int begin = 0; begin < p_records.size(); begin += CatalogSnapshot::ShardSize)
+            next->shards.append(QSharedPointer<const SpaceRecords>(
+                new SpaceRecords(p_records.mid(begin, CatalogSnapshot::ShardSize))));
+        Publish(next);
+        emit Rebuilt(next->version);
+    }
+    void CatalogStore::Patch(const QVector<int>& p_indexes, const SpaceRecords& p_records) {
+        if (p_indexes.isEmpty()) return;
+        EVIES_TIME_SCOPE(CatalogFlushTimer);
+        QMutexLocker locker(&writeLock);
+        CatalogSnapshot* next = Amend(p_indexes, p_records);
+        Publish(next);
+        emit RecordsChanged(next->version, p_indexes);
+    }
+
+    // Memory accounting
+    void CatalogStore::AccountMemory(MemoryUsage& p_usage) {
+        QMutexLocker locker(&writeLock);
+        auto account = [&p_usage](const CatalogSnapshot* p_snapshot) {
+            p_usage.AddObject(MemoryUsage::CatalogRecords, sizeof(CatalogSnapshot));
+            p_usage.AddVector(MemoryUsage::CatalogRecords, p_snapshot->shards);
+            for (const QSharedPointer<const SpaceRecords>& shard: p_snapshot->shards) {
+                if (!p_usage.AddVector(MemoryUsage::CatalogRecords, *shard)) continue;
+                // .. Shard object and its shared pointer control block
+                p_usage.AddObject(MemoryUsage::CatalogRecords, sizeof(SpaceRecords));
+                p_usage.AddObject(MemoryUsage::CatalogRecords, 2 * sizeof(int) + sizeof(void*));
+                for (const SpaceRecord& record: *shard) {
+                    p_usage.AddString(MemoryUsage::Strings, record.name);
+                    p_usage.AddVector(MemoryUsage::Availability, record.times);
+                }
+            }
+        };
+        account(current.loadAcquire());
+        for (const CatalogSnapshot* snapshot: retired) account(snapshot);
+        p_usage.AddVector(MemoryUsage::CatalogRecords, retired);
+        p_usage.AddVector(MemoryUsage::CatalogRecords, tracked);
+        p_usage.AddVector(MemoryUsage::CatalogRecords, dirty);
+        p_usage.AddVector(MemoryUsage::CatalogRecords, isDirty);
+    }
+}
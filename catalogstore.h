@@ -0,0 +1,124 @@
+#ifndef CATALOGSTORE_H
+#define CATALOGSTORE_H
+
+#include <QObject>
+#include <QVector>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QPointer>
+
+// User libraries
+#include "space.h"
+#include "spacequery.h"
+#include <utility>
+
+namespace space {
+    // Immutable version of the catalog
+    // .. Records are split into fixed-size shards, a write copies the touched shards only
+    // .. Unchanged shards are shared between versions
+    class CatalogSnapshot {
+        friend class CatalogStore;
+        friend class CatalogPin;
+    public:
+        enum { ShardSize = 1024 };
+        quint64 GetVersion() const { return version; }
+        int GetSize() const { return size; }
+        const SpaceRecord& At(int p_index) const { return shards[p_index / ShardSize]->at(p_index % ShardSize); }
+        SpaceRecords ToRecords() const;
+    private:
+        quint64 version = 0;
+        int size = 0;
+        QVector<QSharedPointer<const SpaceRecords>> shards;
+        // Readers currently holding this version
+        mutable QAtomicInt pins;
+    };
+
+    // Reader handle on one snapshot
+    // .. The snapshot stays alive and unchanged while any pin on it exists
+    class CatalogPin {
+        friend class CatalogStore;
+    public:
+        CatalogPin() : snapshot(nullptr) {}
+        CatalogPin(const CatalogPin& p_other);
+        CatalogPin(CatalogPin&& p_other) : snapshot(p_other.snapshot) { p_other.snapshot = nullptr; }
+        CatalogPin& operator=(CatalogPin p_other) { std::swap(snapshot, p_other.snapshot); return *this; }
+        ~CatalogPin();
+
+        bool IsNull() const { return snapshot == nullptr; }
+        const CatalogSnapshot* operator->() const { return snapshot; }
+        const CatalogSnapshot& operator*() const { return *snapshot; }
+    private:
+        // Takes over a pin already counted by the store
+        explicit CatalogPin(const CatalogSnapshot* p_snapshot) : snapshot(p_snapshot) {}
+        const CatalogSnapshot* snapshot;
+    };
+
+    // Versioned, read-mostly view of a SpaceManager (RCU style)
+    // .. Readers pin the current version without locking
+    // .. Writers copy the changed shards and publish a new version with one pointer swap
+    // .. Retired versions are freed by the writer side once no reader pins them
+    // .. A store without a manager is a mirror, fed records through Replace and Patch
+    class CatalogStore : public QObject {
+        Q_OBJECT
+    signals:
+        void Published(quint64 version);
+        // .. Every index may have changed, sent with Published after a Rebuild
+        void Rebuilt(quint64 version);
+        // .. Only these indexes changed, ascending, sent with Published after a Flush
+        void RecordsChanged(quint64 version, const QVector<int>& indexes);
+    private:
+        SpaceManager* manager;
+        QAtomicPointer<CatalogSnapshot> current;
+        // Readers between loading current and pinning it
+        // .. Reclamation waits for this to drain
+        mutable QAtomicInt pinning;
+        QVector<CatalogSnapshot*> retired;
+        // Spaces whose signals feed MarkDirty
+        QVector<QPointer<space::Space>> tracked;
+        quint64 nextVersion = 1;
+        // Serializes writers, never taken by readers
+        QMutex writeLock;
+        // Indexes of spaces changed since the last publish
+        QVector<int> dirty;
+        QVector<bool> isDirty;
+        bool flushQueued = false;
+        bool reclaimQueued = false;
+
+        void Publish(CatalogSnapshot* p_next);
+        // Reclaim again in 100 ms while retired versions are left, writer lock held
+        void QueueReclaim();
+        // New version sharing every shard with the current one except those holding p_indexes
+        CatalogSnapshot* Amend(const QVector<int>& p_indexes, const SpaceRecords& p_records) const;
+        void Track();
+        void Untrack();
+        void MarkDirty(int p_index);
+    public:
+        explicit CatalogStore(SpaceManager* p_manager, QObject* parent = nullptr);
+        virtual ~CatalogStore();
+
+        // Readers, any thread
+        CatalogPin Pin() const;
+        quint64 GetVersion() const;
+
+        // Writers
+        // .. Rebuild after the manager replaces its spaces
+        // .. Flush publishes pending per-space changes, queued automatically once per event loop tick
+        void Rebuild();
+        void Flush();
+        // Mirror writers, same signals as Rebuild and Flush
+        // .. p_indexes ascending, p_records[i] is the new record at p_indexes[i]
+        void Replace(const SpaceRecords& p_records);
+        void Patch(const QVector<int>& p_indexes, const SpaceRecords& p_records);
+        // Free retired versions nobody pins any more
+        void Reclaim();
+        int GetRetiredCount() const { return retired.size(); }
+
+        // Memory accounting
+        // .. Current and retired versions, shards shared between versions count once
+        void AccountMemory(MemoryUsage& p_usage);
+    };
+}
+
+#endif // CATALOGSTORE_H
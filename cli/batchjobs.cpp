@@ -0,0 +1,298 @@
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QtConcurrent>
+
+// User libraries
+#include "batchjobs.h"
+#include "spacequery.h"
+#include "recordschema.h"
+#include "parallel.h"
+#include <algorithm>
+
+namespace space {
+    // Output
+    static QByteArray CsvField(const QVariant& p_value) {
+        QByteArray field = p_value.toString().toUtf8();
+        if (field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r'))
+            field = '"' + field.replace("\"", "\"\"") + '"';
+        return field;
+    }
+    bool BatchTable::WriteCsv(QIODevice& p_out) const {
+        QByteArray line;
+        for (int i = 0; i < columns.size(); i++) line += (i ? "," : "") + CsvField(columns[i]);
+        if (p_out.write(line + "\n") < 0) return false;
+        for (const QVariantList& row: rows) {
+            line.clear();
+            for (int i = 0; i < row.size(); i++) line += (i ? "," : "") + CsvField(row[i]);
+            if (p_out.write(line + "\n") < 0) return false;
+        }
+        return true;
+    }
+    bool BatchTable::WriteJson(QIODevice& p_out) const {
+        // .. One row at a time, large results are never built as one document
+        if (p_out.write("[") < 0) return false;
+        for (int r = 0; r < rows.size(); r++) {
+            QJsonObject object;
+            for (int i = 0; i < columns.size() && i < rows[r].size(); i++)
+                object.insert(columns[i], QJsonValue::fromVariant(rows[r][i]));
+            if (p_out.write(r ? ",\n" : "\n") < 0 || p_out.write(QJsonDocument(object).toJson(QJsonDocument::Compact)) < 0)
+                return false;
+        }
+        return p_out.write("\n]\n") >= 0;
+    }
+
+    // Times
+    bool BatchJobs::ParseTime(const QString& p_value, time_t& p_time) {
+        bool isNumber = false;
+        const qint64 seconds = p_value.trimmed().toLongLong(&isNumber);
+        if (isNumber) {
+            p_time = (time_t)seconds;
+            return true;
+        }
+        QDateTime dateTime = QDateTime::fromString(p_value.trimmed(), Qt::ISODate);
+        if (!dateTime.isValid()) return false;
+        // .. No offset given is taken as UTC, like floating iCalendar times
+        if (dateTime.timeSpec() == Qt::LocalTime) dateTime.setTimeSpec(Qt::UTC);
+        p_time = (time_t)dateTime.toMSecsSinceEpoch() / 1000;
+        return true;
+    }
+    QString BatchJobs::FormatTime(time_t p_time) {
+        return QDateTime::fromMSecsSinceEpoch((qint64)p_time * 1000, Qt::UTC).toString(Qt::ISODate);
+    }
+    void BatchJobs::CountHours(const Time& p_timer, time_t p_from, time_t p_to, unsigned int& p_booked, unsigned int& p_hours) {
+        // .. Whole hours overlapping the window, clipped to the origin, booked ones from the occupancy index
+        p_hours = p_timer.CountBookable(p_from, p_to);
+        p_booked = p_hours ? p_timer.CountBookedBetween(p_from, p_to) : 0;
+    }
+
+    // Line-based jobs
+    // .. Lines are grouped by space with a stable sort, each group is one task,
+    // .. so the bookings of a space keep their file order
+    typedef QPair<int, int> LineRun;
+    static QVector<LineRun> GroupBySpace(const QVector<int>& p_spaceOfLine, QVector<int>& p_order) {
+        p_order.clear();
+        for (int line = 0; line < p_spaceOfLine.size(); line++)
+            if (p_spaceOfLine[line] >= 0) p_order.append(line);
+        std::stable_sort(p_order.begin(), p_order.end(), [&p_spaceOfLine](int a, int b) {
+            return p_spaceOfLine[a] < p_spaceOfLine[b];
+        });
+        QVector<LineRun> runs;
+        for (int i = 0; i < p_order.size(); i++) {
+            if (i == 0 || p_spaceOfLine[p_order[i]] != p_spaceOfLine[p_order[i - 1]]) runs.append(LineRun(i, i + 1));
+            else runs.last().second = i + 1;
+        }
+        return runs;
+    }
+    static QHash<unsigned int, int> IndexByID(const SpaceManager& p_manager) {
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        QHash<unsigned int, int> index;
+        index.reserve(spaces.size());
+        for (int i = 0; i < spaces.size(); i++) index.insert(spaces[i]->GetID(), i);
+        return index;
+    }
+
+    BatchTable BatchJobs::Book(SpaceManager& p_manager, QIODevice& p_in) {
+        struct Line { unsigned int ID = 0; time_t start = 0, end = 0; const char* status = "malformed"; double price = 0; };
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        const QHash<unsigned int, int> index = IndexByID(p_manager);
+        QVector<Line> lines;
+        QVector<int> spaceOfLine;
+        while (!p_in.atEnd()) {
+            const QList<QByteArray> fields = p_in.readLine().trimmed().split(',');
+            if (fields.size() == 1 && fields[0].isEmpty()) continue;
+            Line line;
+            int spaceIndex = -1;
+            bool isNumber = false;
+            if (fields.size() == 3) {
+                line.ID = fields[0].trimmed().toUInt(&isNumber);
+                if (isNumber && ParseTime(QString::fromUtf8(fields[1]), line.start)
+                             && ParseTime(QString::fromUtf8(fields[2]), line.end)) {
+                    spaceIndex = index.value(line.ID, -1);
+                    line.status = spaceIndex < 0 ? "unknown" : "invalid";
+                }
+            }
+            // .. A header line is only skipped at the top
+            if (lines.isEmpty() && !isNumber && fields.size() == 3) continue;
+            lines.append(line);
+            spaceOfLine.append(line.end <= line.start ? -1 : spaceIndex);
+        }
+        QVector<int> order;
+        QVector<LineRun> runs = GroupBySpace(spaceOfLine, order);
+        QtConcurrent::blockingMap(runs, [&](const LineRun& p_run) {
+            Space* space_ptr = spaces[spaceOfLine[order[p_run.first]]];
+            space_ptr->BeginUpdate();
+            for (int i = p_run.first; i < p_run.second; i++) {
+                Line& line = lines[order[i]];
+                // .. End is exclusive here, inclusive on the timer
+                const bool booked = space_ptr->GetTimer().AddReservation(line.start, line.end - 1, line.price);
+                line.status = booked ? "booked"
+                            : space_ptr->GetTimer().HourOf(line.start) < 0 ? "invalid" : "conflict";
+            }
+            space_ptr->EndUpdate();
+        });
+        BatchTable table;
+        table.columns = QStringList({ "row", "id", "start", "end", "status", "price" });
+        table.rows.reserve(lines.size());
+        for (int i = 0; i < lines.size(); i++)
+            table.rows.append(QVariantList({ i + 1, lines[i].ID, FormatTime(lines[i].start), FormatTime(lines[i].end),
+                                             lines[i].status, lines[i].price }));
+        return table;
+    }
+
+    BatchTable BatchJobs::Reprice(SpaceManager& p_manager, QIODevice* p_in, double p_scale) {
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        BatchTable table;
+        table.columns = QStringList({ "id", "name", "old", "new" });
+        if (!p_in) {
+            table.rows.resize(spaces.size());
+            ForEachChunk(spaces.size(), [&](int p_begin, int p_end) {
+                for (int i = p_begin; i < p_end; i++) {
+                    Time& timer = spaces[i]->GetTimer();
+                    const double old = timer.GetDirhamsPerHour();
+                    timer.SetDirhamsPerHour(old * p_scale);
+                    table.rows[i] = { spaces[i]->GetID(), spaces[i]->GetName(), old, timer.GetDirhamsPerHour() };
+                }
+            });
+            return table;
+        }
+        // .. Later lines for the same space win, like applying them in order
+        const QHash<unsigned int, int> index = IndexByID(p_manager);
+        QVector<double> prices, olds;
+        QVector<int> spaceOfLine;
+        while (!p_in->atEnd()) {
+            const QList<QByteArray> fields = p_in->readLine().trimmed().split(',');
+            bool isID = false, isPrice = false;
+            const unsigned int ID = fields.size() == 2 ? fields[0].trimmed().toUInt(&isID) : 0;
+            const double price = fields.size() == 2 ? fields[1].trimmed().toDouble(&isPrice) : 0;
+            if (!isID || !isPrice || price < 0) continue;
+            prices.append(price);
+            spaceOfLine.append(index.value(ID, -1));
+        }
+        olds.resize(prices.size());
+        QVector<int> order;
+        QVector<LineRun> runs = GroupBySpace(spaceOfLine, order);
+        QtConcurrent::blockingMap(runs, [&](const LineRun& p_run) {
+            Time& timer = spaces[spaceOfLine[order[p_run.first]]]->GetTimer();
+            for (int i = p_run.first; i < p_run.second; i++) {
+                olds[order[i]] = timer.GetDirhamsPerHour();
+                timer.SetDirhamsPerHour(prices[order[i]]);
+            }
+        });
+        for (int i = 0; i < order.size(); i++) {
+            const Space* space_ptr = spaces[spaceOfLine[order[i]]];
+            table.rows.append(QVariantList({ space_ptr->GetID(), space_ptr->GetName(), olds[order[i]], prices[order[i]] }));
+        }
+        return table;
+    }
+
+    // Reports
+    BatchTable BatchJobs::Availability(const SpaceManager& p_manager, time_t p_from, time_t p_to) {
+        BatchTable table;
+        table.columns = QStringList({ "id", "name", "booked", "free", "occupancy" });
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        table.rows.resize(spaces.size());
+        OccupancyReport::PrepareCounts(spaces);
+        ForEachChunk(spaces.size(), [&](int p_begin, int p_end) {
+            for (int i = p_begin; i < p_end; i++) {
+                unsigned int booked, hours;
+                CountHours(spaces[i]->GetTimer(), p_from, p_to, booked, hours);
+                table.rows[i] = { spaces[i]->GetID(), spaces[i]->GetName(), booked, hours - booked,
+                                  hours ? (double)booked / hours : 0.0 };
+            }
+        });
+        return table;
+    }
+
+    BatchTable BatchJobs::Occupancy(const SpaceManager& p_manager, time_t p_from, time_t p_to, int p_bucketHours) {
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        const time_t bucketSeconds = (time_t)qMax(p_bucketHours, 1) * 3600;
+        const int buckets = p_to > p_from ? (int)((p_to - p_from + bucketSeconds - 1) / bucketSeconds) : 0;
+        // .. One partial sum per chunk, added up in chunk order
+        QVector<QVector<quint64>> partials((spaces.size() + DefaultChunkSize - 1) / DefaultChunkSize);
+        OccupancyReport::PrepareCounts(spaces);
+        ForEachChunk(spaces.size(), [&](int p_begin, int p_end) {
+            QVector<quint64>& partial = partials[p_begin / DefaultChunkSize];
+            partial.fill(0, 2 * buckets);
+            for (int i = p_begin; i < p_end; i++) {
+                for (int b = 0; b < buckets; b++) {
+                    unsigned int booked, hours;
+                    const time_t from = p_from + b * bucketSeconds;
+                    CountHours(spaces[i]->GetTimer(), from, qMin(from + bucketSeconds, p_to), booked, hours);
+                    partial[2 * b] += booked;
+                    partial[2 * b + 1] += hours;
+                }
+            }
+        });
+        QVector<quint64> totals(2 * buckets, 0);
+        for (const QVector<quint64>& partial: partials)
+            for (int j = 0; j < partial.size(); j++) totals[j] += partial[j];
+        BatchTable table;
+        table.columns = QStringList({ "from", "to", "booked", "hours", "occupancy" });
+        for (int b = 0; b < buckets; b++) {
+            const quint64 booked = totals[2 * b], hours = totals[2 * b + 1];
+            const time_t from = p_from + b * bucketSeconds;
+            table.rows.append(QVariantList({ FormatTime(from), FormatTime(qMin(from + bucketSeconds, p_to)),
+                                             booked, hours, hours ? (double)booked / hours : 0.0 }));
+        }
+        return table;
+    }
+
+    BatchTable BatchJobs::Revenue(const SpaceManager& p_manager, const OccupancyWindow& p_window) {
+        BatchTable table;
+        table.columns = QStringList({ "id", "name", "booked", "hours", "utilisation", "revenue" });
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        const QVector<Utilisation> utilisations = OccupancyReport::PerSpace(spaces, p_window);
+        for (int i = 0; i < spaces.size(); i++) {
+            const Utilisation& utilisation = utilisations[i];
+            table.rows.append(QVariantList({ utilisation.ID, spaces[i]->GetName(), utilisation.booked, utilisation.hours,
+                                             utilisation.GetRate(), utilisation.revenue }));
+        }
+        const Utilisation total = OccupancyReport::Total(utilisations);
+        table.rows.append(QVariantList({ 0, "total", total.booked, total.hours, total.GetRate(), total.revenue }));
+        return table;
+    }
+
+    BatchTable BatchJobs::Reviews(const SpaceManager& p_manager) {
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        // .. Same rank as the catalog sort, ties keep catalog order
+        QVector<QPair<float, int>> ranked(spaces.size());
+        ForEachChunk(spaces.size(), [&](int p_begin, int p_end) {
+            for (int i = p_begin; i < p_end; i++) {
+                SpaceRecord record;
+                record.score = spaces[i]->GetReview().GetReviewScore();
+                record.numberOfReviews = spaces[i]->GetReview().GetNumberOfReviews();
+                ranked[i] = QPair<float, int>(record.GetRank(), i);
+            }
+        });
+        std::stable_sort(ranked.begin(), ranked.end(), [](const QPair<float, int>& a, const QPair<float, int>& b) {
+            return a.first > b.first;
+        });
+        BatchTable table;
+        table.columns = QStringList({ "rank", "id", "name", "reviews", "score", "bayesian" });
+        table.rows.reserve(ranked.size());
+        for (int r = 0; r < ranked.size(); r++) {
+            const Space* space_ptr = spaces[ranked[r].second];
+            table.rows.append(QVariantList({ r + 1, space_ptr->GetID(), space_ptr->GetName(),
+                                             space_ptr->GetReview().GetNumberOfReviews(),
+                                             space_ptr->GetReview().GetReviewScore(), ranked[r].first }));
+        }
+        return table;
+    }
+
+    BatchTable BatchJobs::List(const SpaceManager& p_manager) {
+        BatchTable table;
+        // .. Every record column, same names as the list model roles
+        table.columns = RecordSchema::Names();
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        table.rows.resize(spaces.size());
+        ForEachChunk(spaces.size(), [&](int p_begin, int p_end) {
+            for (int i = p_begin; i < p_end; i++) table.rows[i] = RecordSchema::ToVariantList(SpaceRecord::FromSpace(*spaces[i]));
+        });
+        return table;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef BATCHJOBS_H
+#define BATCHJOBS_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QIODevice>
+
+// User libraries
+#include "space.h"
+#include "occupancy.h"
+#include <ctime>
+
+namespace space {
+    // Rows of a batch job's result
+    struct BatchTable {
+        QStringList columns;
+        QVector<QVariantList> rows;
+
+        // RFC 4180 with a header line, fields quoted only when needed
+        bool WriteCsv(QIODevice& p_out) const;
+        // Array of one object per row, keyed by column
+        bool WriteJson(QIODevice& p_out) const;
+    };
+
+    // Bulk operations over every space of a manager, spread over the global thread pool
+    // .. Each space is only ever touched by one worker, and a job's rows come out
+    // .. in catalog order whatever the thread count
+    // .. Nothing may observe the spaces from another thread while a job runs,
+    // .. so no CatalogStore or model should be attached
+    // .. Windows are [p_from, p_to), hours before a timer's origin are not bookable and not counted
+    class BatchJobs {
+    public:
+        // "id,start,end" lines, times as ISO 8601 UTC or seconds since the epoch, end exclusive
+        // .. Bookings of one space are applied in file order
+        // .. Status per row: booked, conflict, invalid, unknown (no such space) or malformed
+        static BatchTable Book(SpaceManager& p_manager, QIODevice& p_in);
+        // "id,price" lines, or every space scaled by p_scale when p_in is null
+        static BatchTable Reprice(SpaceManager& p_manager, QIODevice* p_in, double p_scale);
+        // Booked and free hours of each space
+        static BatchTable Availability(const SpaceManager& p_manager, time_t p_from, time_t p_to);
+        // Catalog-wide booked share per bucket of p_bucketHours
+        static BatchTable Occupancy(const SpaceManager& p_manager, time_t p_from, time_t p_to, int p_bucketHours);
+        // Utilisation and revenue of each space, then the catalog total with ID 0
+        static BatchTable Revenue(const SpaceManager& p_manager, const OccupancyWindow& p_window);
+        // Review counts and scores, best Bayesian rank first
+        static BatchTable Reviews(const SpaceManager& p_manager);
+        static BatchTable List(const SpaceManager& p_manager);
+
+        // ISO 8601 UTC or seconds since the epoch
+        static bool ParseTime(const QString& p_value, time_t& p_time);
+        static QString FormatTime(time_t p_time);
+        // Booked and bookable hours of p_timer in [p_from, p_to)
+        static void CountHours(const Time& p_timer, time_t p_from, time_t p_to, unsigned int& p_booked, unsigned int& p_hours);
+    };
+}
+
+#endif // BATCHJOBS_H
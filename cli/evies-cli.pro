@@ -0,0 +1,22 @@
+QT -= gui
+QT += core concurrent
+CONFIG += c++11 console
+CONFIG -= app_bundle
+TARGET = evies-cli
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# Shared catalog, reservation and protocol sources
+include(../space.pri)
+
+# Headless batch jobs over a whole catalog, no QML involved
+# .. ./evies-cli occupancy --catalog spaces.cat --from 2024-01-01 --to 2024-02-01 --format json
+SOURCES += main.cpp \
+    batchjobs.cpp
+
+HEADERS += \
+    batchjobs.h
+
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,141 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+// User libraries
+#include "space.h"
+#include "catalogfile.h"
+#include "ical.h"
+#include "batchjobs.h"
+#include <iostream>
+#include <ctime>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("evies-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch analytics and bulk operations over an evies catalog");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "list, book <csv>, reprice [csv], availability, occupancy, revenue or reviews.");
+    parser.addPositionalArgument("input", "Bookings for book (\"id,start,end\"), prices for reprice (\"id,price\"), - for stdin.", "[input]");
+    QCommandLineOption catalogOption("catalog", "Load the catalog saved in <file>.", "file");
+    QCommandLineOption spacesOption("spaces", "Number of generated spaces when no catalog is given.", "count", "1000");
+    QCommandLineOption seedOption("seed", "Seed of the generated catalog.", "seed", "1");
+    QCommandLineOption importOption("import", "Merge the reservations of an iCalendar <file> first.", "file");
+    QCommandLineOption fromOption("from", "Window start, ISO 8601 UTC or epoch seconds (default now).", "time");
+    QCommandLineOption toOption("to", "Window end, exclusive (default 7 days after the start).", "time");
+    QCommandLineOption bucketOption("bucket", "Occupancy bucket in hours.", "hours", "24");
+    QCommandLineOption peakOption("peak", "Revenue over UTC hours <from-to> of each day only, e.g. 9-17.", "hours");
+    QCommandLineOption scaleOption("scale", "Reprice every space by <factor> when no price file is given.", "factor", "1");
+    QCommandLineOption formatOption("format", "Output format, csv or json.", "format", "csv");
+    QCommandLineOption outputOption("output", "Write the result to <file> instead of stdout.", "file");
+    QCommandLineOption saveOption("save", "Save the catalog to <file> after the command.", "file");
+    QCommandLineOption threadsOption("threads", "Worker threads, 0 for one per core.", "count", "0");
+    parser.addOptions({ catalogOption, spacesOption, seedOption, importOption, fromOption, toOption, bucketOption,
+                        peakOption, scaleOption, formatOption, outputOption, saveOption, threadsOption });
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    const QString command = arguments.value(0);
+    const QString format = parser.value(formatOption);
+    if (command.isEmpty() || (format != "csv" && format != "json")) parser.showHelp(1);
+    if (parser.value(threadsOption).toInt() > 0) QThreadPool::globalInstance()->setMaxThreadCount(parser.value(threadsOption).toInt());
+
+    time_t from = (time_t)(QDateTime::currentMSecsSinceEpoch() / 1000), to;
+    if (parser.isSet(fromOption) && !space::BatchJobs::ParseTime(parser.value(fromOption), from)) {
+        std::cerr << "Bad --from " << parser.value(fromOption).toStdString() << std::endl;
+        return 1;
+    }
+    to = from + 7 * 24 * 3600;
+    if (parser.isSet(toOption) && !space::BatchJobs::ParseTime(parser.value(toOption), to)) {
+        std::cerr << "Bad --to " << parser.value(toOption).toStdString() << std::endl;
+        return 1;
+    }
+
+    space::OccupancyWindow window;
+    window.from = from;
+    window.to = to;
+    if (parser.isSet(peakOption)) {
+        const QStringList hours = parser.value(peakOption).split('-');
+        bool isFrom = false, isTo = false;
+        if (hours.size() == 2) {
+            window.peakFrom = hours[0].toInt(&isFrom);
+            window.peakTo = hours[1].toInt(&isTo);
+        }
+        if (!isFrom || !isTo || window.peakFrom < 0 || window.peakTo > 24 || window.peakFrom >= window.peakTo) {
+            std::cerr << "Bad --peak " << parser.value(peakOption).toStdString() << std::endl;
+            return 1;
+        }
+    }
+
+    // Catalog
+    QElapsedTimer clock;
+    clock.start();
+    space::SpaceManager manager;
+    if (parser.isSet(catalogOption)) {
+        QFile file(parser.value(catalogOption));
+        QVector<space::Space*> spaces;
+        if (!file.open(QIODevice::ReadOnly) || !space::CatalogFile::Load(file, spaces)) {
+            std::cerr << "Cannot read catalog " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+        manager.SetSpaces(spaces);
+    } else {
+        manager.GetRandomizedSpaces(parser.value(spacesOption).toInt(), parser.value(seedOption).toULongLong());
+    }
+    if (parser.isSet(importOption)) {
+        QFile file(parser.value(importOption));
+        if (!file.open(QIODevice::ReadOnly) || space::ICalendar::Import(file, manager) < 0) {
+            std::cerr << "Cannot import " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+    }
+    std::cerr << "catalog: " << manager.GetSpaces().size() << " spaces in " << clock.restart() << " ms" << std::endl;
+
+    // Command
+    QFile input;
+    const QString inputName = arguments.value(1);
+    if (!inputName.isEmpty()) {
+        input.setFileName(inputName);
+        if (!(inputName == "-" ? input.open(stdin, QIODevice::ReadOnly) : input.open(QIODevice::ReadOnly))) {
+            std::cerr << "Cannot read " << inputName.toStdString() << std::endl;
+            return 1;
+        }
+    }
+    space::BatchTable table;
+    if (command == "list") table = space::BatchJobs::List(manager);
+    else if (command == "book" && input.isOpen()) table = space::BatchJobs::Book(manager, input);
+    else if (command == "reprice") table = space::BatchJobs::Reprice(manager, input.isOpen() ? &input : nullptr, parser.value(scaleOption).toDouble());
+    else if (command == "availability") table = space::BatchJobs::Availability(manager, from, to);
+    else if (command == "occupancy") table = space::BatchJobs::Occupancy(manager, from, to, parser.value(bucketOption).toInt());
+    else if (command == "revenue") table = space::BatchJobs::Revenue(manager, window);
+    else if (command == "reviews") table = space::BatchJobs::Reviews(manager);
+    else parser.showHelp(1);
+    std::cerr << command.toStdString() << ": " << table.rows.size() << " rows in " << clock.restart() << " ms on "
+              << QThreadPool::globalInstance()->maxThreadCount() << " threads" << std::endl;
+
+    // Output
+    QFile output(parser.value(outputOption));
+    const bool isOpen = parser.isSet(outputOption) ? output.open(QIODevice::WriteOnly) : output.open(stdout, QIODevice::WriteOnly);
+    if (!isOpen || !(format == "json" ? table.WriteJson(output) : table.WriteCsv(output))) {
+        std::cerr << "Cannot write " << (parser.isSet(outputOption) ? parser.value(outputOption).toStdString() : "stdout") << std::endl;
+        return 1;
+    }
+    output.close();
+    if (parser.isSet(saveOption)) {
+        QFile file(parser.value(saveOption));
+        if (!file.open(QIODevice::WriteOnly) || !space::CatalogFile::Save(manager, file)) {
+            std::cerr << "Cannot write catalog " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+    }
+    std::cerr << "output: " << clock.elapsed() << " ms" << std::endl;
+    return 0;
+}
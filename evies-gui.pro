@@ -1,5 +1,7 @@
-QT += quick
+QT += quick network
 CONFIG += c++11
+# QML is compiled ahead of time into the binary (Qt Quick Compiler)
+CONFIG += qtquickcompiler
 
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which as been marked deprecated (the exact warnings
@@ -12,8 +14,19 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Catalog, reservation and protocol sources
+include(space.pri)
+
 SOURCES += main.cpp \
-    space.cpp
+    bookingclient.cpp \
+    spacebanner.cpp \
+    availabilitycalendar.cpp \
+    startuptimeline.cpp
+
+HEADERS += bookingclient.h \
+    spacebanner.h \
+    availabilitycalendar.h \
+    startuptimeline.h
 
 RESOURCES += qml.qrc
 
@@ -28,7 +41,4 @@ qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
-HEADERS += \
-    space.h
-
 DISTFILES +=
@@ -0,0 +1,194 @@
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+// User libraries
+#include "groupbooking.h"
+#include "spacequery.h"
+#include "metrics.h"
+#include <algorithm>
+#include <limits>
+
+namespace space {
+    // SpaceRecord::Flag bits, Outdoor to Comfy
+    enum { FlagCount = 10 };
+
+    // Depth-first search state, rooms in search order
+    struct GroupSearch {
+        // Per room, member indexes cheapest first
+        QVector<QVector<int>> candidates;
+        // Same requirements as the room before, take candidates after its pick
+        QVector<bool> repeats;
+        QVector<double> prices;
+        QVector<quint64> used;
+        // Position in the room's list, per depth
+        QVector<int> picks;
+        int alternatives = 1;
+        // Best complete assignments, cheapest first
+        struct Found { double cost; QVector<int> members; };
+        QVector<Found> found;
+
+        qint64 budget = 0;
+        QElapsedTimer clock;
+        quint64 nodes = 0;
+        bool expired = false;
+
+        bool IsUsed(int p_member) const { return used[p_member / 64] & (1ULL << (p_member % 64)); }
+        void Use(int p_member, bool p_used) {
+            if (p_used) used[p_member / 64] |= 1ULL << (p_member % 64);
+            else used[p_member / 64] &= ~(1ULL << (p_member % 64));
+        }
+        double Threshold() const {
+            return found.size() < alternatives ? std::numeric_limits<double>::infinity() : found.last().cost;
+        }
+        // Cheapest unused candidates of every room from p_depth on, distinct within
+        // .. a run of identical rooms, as they share one list
+        // .. Different rooms may claim the same member here, so this never overestimates
+        double LowerBound(int p_depth) const {
+            double bound = 0;
+            for (int depth = p_depth; depth < candidates.size(); ) {
+                int run = 1;
+                while (depth + run < candidates.size() && repeats[depth + run]) run++;
+                const QVector<int>& list = candidates[depth];
+                int taken = 0;
+                for (int position = 0; position < list.size() && taken < run; position++) {
+                    if (IsUsed(list[position])) continue;
+                    bound += prices[list[position]];
+                    taken++;
+                }
+                if (taken < run) return std::numeric_limits<double>::infinity();
+                depth += run;
+            }
+            return bound;
+        }
+        void Search(int p_depth, double p_cost) {
+            if (expired) return;
+            // .. Reading the clock is not free, only every few hundred nodes
+            if ((++nodes & 255) == 0 && clock.elapsed() > budget) {
+                expired = true;
+                return;
+            }
+            if (p_depth == candidates.size()) {
+                Found next = { p_cost, QVector<int>() };
+                for (int depth = 0; depth < candidates.size(); depth++) next.members.append(candidates[depth][picks[depth]]);
+                int position = found.size();
+                while (position > 0 && found[position - 1].cost > p_cost) position--;
+                found.insert(position, next);
+                if (found.size() > alternatives) found.removeLast();
+                return;
+            }
+            const QVector<int>& list = candidates[p_depth];
+            const double rest = LowerBound(p_depth + 1);
+            for (int position = repeats[p_depth] ? picks[p_depth - 1] + 1 : 0; position < list.size(); position++) {
+                const int member = list[position];
+                if (IsUsed(member)) continue;
+                // .. Cheapest first, nothing further down the list can do better
+                if (p_cost + prices[member] + rest >= Threshold()) break;
+                picks[p_depth] = position;
+                Use(member, true);
+                Search(p_depth + 1, p_cost + prices[member]);
+                Use(member, false);
+                if (expired) return;
+            }
+        }
+    };
+
+    GroupBooking::Result GroupBooking::Solve(const SuperSpace& p_venue, const GroupRequest& p_request) {
+        EVIES_TIME_SCOPE(GroupSolveTimer);
+        Result result;
+        const QVector<space::Space*>& members = p_venue.GetSpaces();
+        const int rooms = p_request.rooms.size(), words = (members.size() + 63) / 64;
+        result.candidates.fill(0, rooms);
+        if (rooms == 0 || rooms > members.size() || p_request.to <= p_request.from) return result;
+        // .. Some hour has every room booked, no room is free for the whole window
+        if (!p_venue.HasFreeRoomEachHour(p_request.from, p_request.to)) return result;
+
+        // Member bitmaps: free for the whole window, and one per amenity flag
+        QVector<quint64> available(words, 0);
+        QVector<QVector<quint64>> amenities(FlagCount, QVector<quint64>(words, 0));
+        GroupSearch search;
+        search.prices.resize(members.size());
+        for (int i = 0; i < members.size(); i++) {
+            const Time& timer = members[i]->GetTimer();
+            const long startHour = timer.HourOf(p_request.from), endHour = timer.HourOf(p_request.to - 1);
+            if (startHour >= 0 && timer.IsFree(startHour, endHour)) available[i / 64] |= 1ULL << (i % 64);
+            const unsigned int flags = SpaceRecord::FlagsOf(*members[i]);
+            for (int flag = 0; flag < FlagCount; flag++)
+                if (flags & (1u << flag)) amenities[flag][i / 64] |= 1ULL << (i % 64);
+            search.prices[i] = timer.GetDirhamsPerHour();
+        }
+
+        // Candidates per room, cheapest first
+        QVector<QVector<int>> candidates(rooms);
+        for (int room = 0; room < rooms; room++) {
+            const GroupRequest::Room& wanted = p_request.rooms[room];
+            QVector<quint64> mask = available;
+            for (int flag = 0; flag < FlagCount; flag++) {
+                if (!(wanted.flags & (1u << flag))) continue;
+                for (int w = 0; w < words; w++) mask[w] &= amenities[flag][w];
+            }
+            for (int w = 0; w < words; w++) {
+                for (quint64 bits = mask[w]; bits; bits &= bits - 1) {
+                    const int i = w * 64 + qCountTrailingZeroBits(bits);
+                    if (members[i]->GetNumberOfPeople() >= wanted.minPeople) candidates[room].append(i);
+                }
+            }
+            std::stable_sort(candidates[room].begin(), candidates[room].end(), [&search](int a, int b) {
+                return search.prices[a] < search.prices[b];
+            });
+            result.candidates[room] = candidates[room].size();
+        }
+
+        // Fewest candidates first, identical rooms next to each other
+        QVector<int> order(rooms);
+        for (int room = 0; room < rooms; room++) order[room] = room;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            const GroupRequest::Room& x = p_request.rooms[a];
+            const GroupRequest::Room& y = p_request.rooms[b];
+            if (candidates[a].size() != candidates[b].size()) return candidates[a].size() < candidates[b].size();
+            if (x.minPeople != y.minPeople) return x.minPeople > y.minPeople;
+            return x.flags < y.flags;
+        });
+        for (int depth = 0; depth < rooms; depth++) {
+            const GroupRequest::Room& wanted = p_request.rooms[order[depth]];
+            search.candidates.append(candidates[order[depth]]);
+            search.repeats.append(depth > 0 && wanted.minPeople == p_request.rooms[order[depth - 1]].minPeople
+                                            && wanted.flags == p_request.rooms[order[depth - 1]].flags);
+        }
+        search.used.fill(0, words);
+        search.picks.fill(0, rooms);
+        search.alternatives = qMax(p_request.alternatives, 1);
+        search.budget = p_request.budget;
+        search.clock.start();
+        search.Search(0, 0);
+
+        result.complete = !search.expired;
+        result.nodes = search.nodes;
+        for (const GroupSearch::Found& found: search.found) {
+            GroupAllocation allocation;
+            allocation.spaces.resize(rooms);
+            for (int depth = 0; depth < rooms; depth++) allocation.spaces[order[depth]] = members[found.members[depth]];
+            allocation.dirhamsPerHour = found.cost;
+            result.allocations.append(allocation);
+        }
+        return result;
+    }
+
+    bool GroupBooking::Book(const GroupRequest& p_request, const GroupAllocation& p_allocation, double& p_price) {
+        p_price = 0;
+        for (int room = 0; room < p_allocation.spaces.size(); room++) {
+            double price;
+            // .. Window end is exclusive, reservations are inclusive
+            if (p_allocation.spaces[room]->GetTimer().AddReservation(p_request.from, p_request.to - 1, price)) {
+                p_price += price;
+                continue;
+            }
+            // Taken meanwhile, give back what was reserved
+            for (int booked = 0; booked < room; booked++)
+                p_allocation.spaces[booked]->GetTimer().RemoveReservation(p_request.from, p_request.to - 1);
+            p_price = 0;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef GROUPBOOKING_H
+#define GROUPBOOKING_H
+
+#include <QObject>
+#include <QVector>
+
+// User libraries
+#include "space.h"
+#include "superspace.h"
+#include <ctime>
+
+namespace space {
+    // Rooms wanted together at one venue, e.g. a plenary plus N breakouts
+    struct GroupRequest {
+        struct Room {
+            unsigned int minPeople = 0;
+            // SpaceRecord::Flag bits the room must have
+            unsigned int flags = 0;
+        };
+        QVector<Room> rooms;
+        // Every room for [from, to)
+        time_t from = 0, to = 0;
+        // Distinct allocations to return, cheapest first
+        int alternatives = 3;
+        // Search time in milliseconds, the best found so far is returned when it runs out
+        int budget = 250;
+    };
+    // One space per requested room, in request order
+    struct GroupAllocation {
+        QVector<space::Space*> spaces;
+        double dirhamsPerHour = 0;
+    };
+
+    // Cheapest assignment of distinct member spaces to the rooms of a request
+    // .. Members free for the whole window are one bitmap, intersected with the
+    // .. amenity bitmap of each room's flags, then the capacity is checked per candidate
+    // .. Branch-and-bound over the rooms with the fewest candidates first:
+    // .. each room's cheapest unused candidate bounds the rest, identical rooms only
+    // .. take candidates in list order so permutations are not searched twice
+    class GroupBooking {
+    public:
+        struct Result {
+            QVector<GroupAllocation> allocations;
+            // False if the budget ran out before the search was exhausted
+            bool complete = true;
+            quint64 nodes = 0;
+            // Members left for each room after the masks
+            QVector<int> candidates;
+        };
+        static Result Solve(const SuperSpace& p_venue, const GroupRequest& p_request);
+        // Reserves every room of p_allocation or none, p_price is the total
+        static bool Book(const GroupRequest& p_request, const GroupAllocation& p_allocation, double& p_price);
+    };
+}
+
+#endif // GROUPBOOKING_H
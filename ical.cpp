@@ -0,0 +1,240 @@
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+#include <QtAlgorithms>
+
+// User libraries
+#include "ical.h"
+#include <cstring>
+#include <ctime>
+
+namespace space {
+    static bool ReadDigits(const char* p_value, int p_count, unsigned int& p_result) {
+        p_result = 0;
+        for (int i = 0; i < p_count; i++) {
+            if (p_value[i] < '0' || p_value[i] > '9') return false;
+            p_result = p_result * 10 + (p_value[i] - '0');
+        }
+        return true;
+    }
+    // Escape TEXT values (RFC 5545 3.3.11)
+    static QByteArray EscapeText(const QString& p_text) {
+        QByteArray escaped;
+        for (char c: p_text.toUtf8()) {
+            if (c == '\\' || c == ';' || c == ',') escaped.append('\\');
+            if (c == '\n') { escaped.append("\\n"); continue; }
+            escaped.append(c);
+        }
+        return escaped;
+    }
+
+    // UTC date-time conversion
+    bool ICalendar::ParseDateTime(const char* p_value, int p_length, time_t& p_time) {
+        unsigned int year, month, day, hour = 0, minute = 0, second = 0;
+        if (p_length != 8 && p_length != 15 && !(p_length == 16 && p_value[15] == 'Z')) return false;
+        if (!ReadDigits(p_value, 4, year) || !ReadDigits(p_value + 4, 2, month) || !ReadDigits(p_value + 6, 2, day))
+            return false;
+        if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+        // .. DATE values stop here and mean midnight
+        if (p_length >= 15) {
+            if (p_value[8] != 'T') return false;
+            if (!ReadDigits(p_value + 9, 2, hour) || !ReadDigits(p_value + 11, 2, minute) || !ReadDigits(p_value + 13, 2, second))
+                return false;
+        }
+        p_time = (time_t)Time::DaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+        return true;
+    }
+    int ICalendar::FormatDateTime(time_t p_time, char* p_buffer) {
+        long days = (long)(p_time / 86400), seconds = (long)(p_time % 86400);
+        if (seconds < 0) { seconds += 86400; days--; }
+        long year;
+        unsigned int month, day;
+        Time::CivilFromDays(days, year, month, day);
+        unsigned int fields[6] = { (unsigned int)year, month, day,
+                                   (unsigned int)(seconds / 3600), (unsigned int)(seconds / 60 % 60), (unsigned int)(seconds % 60) };
+        const int widths[6] = { 4, 2, 2, 2, 2, 2 };
+        int n = 0;
+        for (int f = 0; f < 6; f++) {
+            if (f == 3) p_buffer[n++] = 'T';
+            for (int i = widths[f] - 1; i >= 0; i--) {
+                p_buffer[n + i] = '0' + fields[f] % 10;
+                fields[f] /= 10;
+            }
+            n += widths[f];
+        }
+        p_buffer[n++] = 'Z';
+        return n;
+    }
+
+    // Reading
+    bool ICalendar::ReadEvent(QIODevice& p_in, time_t& p_start, time_t& p_end, long& p_spaceID, bool& p_valid) {
+        char line[1024];
+        qint64 n;
+        bool inEvent = false, hasStart = false, hasEnd = false;
+        p_spaceID = -1;
+        p_valid = true;
+        while ((n = p_in.readLine(line, sizeof(line))) > 0) {
+            // .. An overlong line is dropped whole, its tail must not parse as a property line
+            if (line[n - 1] != '\n' && n == (qint64)sizeof(line) - 1) {
+                while ((n = p_in.readLine(line, sizeof(line))) > 0 && line[n - 1] != '\n') {}
+                continue;
+            }
+            while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) n--;
+            line[n] = 0;
+            // .. Folded continuation lines never carry the properties we read
+            if (n == 0 || line[0] == ' ' || line[0] == '\t') continue;
+            if (!inEvent) {
+                if (n == 12 && std::memcmp(line, "BEGIN:VEVENT", 12) == 0) inEvent = true;
+                continue;
+            }
+            if (n == 10 && std::memcmp(line, "END:VEVENT", 10) == 0) {
+                if (!hasStart) p_valid = false;
+                // .. No DTEND means a one hour event
+                if (!hasEnd) p_end = p_start + 3600;
+                return true;
+            }
+            // Value follows the first ':' after any parameters
+            const char* colon = static_cast<const char*>(std::memchr(line, ':', n));
+            if (!colon) continue;
+            const char* value = colon + 1;
+            int valueLength = (int)(line + n - value);
+            // .. Local times of a named zone are not converted, better refused than booked as UTC
+            line[colon - line] = 0;
+            const bool zoned = std::strstr(line, ";TZID=") != nullptr;
+            line[colon - line] = ':';
+            if (std::strncmp(line, "DTSTART", 7) == 0 && (line[7] == ':' || line[7] == ';')) {
+                hasStart = !zoned && ParseDateTime(value, valueLength, p_start);
+                if (!hasStart) p_valid = false;
+            } else if (std::strncmp(line, "DTEND", 5) == 0 && (line[5] == ':' || line[5] == ';')) {
+                hasEnd = !zoned && ParseDateTime(value, valueLength, p_end);
+                if (!hasEnd) p_valid = false;
+            } else if (std::strncmp(line, "X-EVIES-SPACE:", 14) == 0) {
+                unsigned int id;
+                if (valueLength > 0 && valueLength <= 9 && ReadDigits(value, valueLength, id)) p_spaceID = id;
+            }
+        }
+        return false;
+    }
+    bool ICalendar::ToHours(const Time& p_timer, time_t p_start, time_t p_end, unsigned long& p_startHour, unsigned long& p_endHour) {
+        const time_t origin = p_timer.GetOriginTime();
+        // .. Hours before the origin cannot be booked
+        if (p_start < origin) p_start = origin;
+        if (p_end <= p_start) return false;
+        p_startHour = (unsigned long)((p_start - origin) / 3600);
+        // .. DTEND is exclusive, a partial last hour is still booked
+        p_endHour = (unsigned long)((p_end - origin + 3599) / 3600) - 1;
+        return true;
+    }
+    int ICalendar::Import(QIODevice& p_in, Time& p_timer) {
+        QVector<unsigned long long> merged;
+        time_t start, end;
+        long spaceID;
+        bool valid;
+        unsigned long startHour, endHour;
+        int count = 0;
+        while (ReadEvent(p_in, start, end, spaceID, valid)) {
+            if (!valid) return -1;
+            if (ToHours(p_timer, start, end, startHour, endHour))
+                Time::SetHours(merged, startHour, endHour);
+            count++;
+        }
+        if (!merged.isEmpty()) p_timer.MergeTimes(merged);
+        return count;
+    }
+    int ICalendar::Import(QIODevice& p_in, SpaceManager& p_manager) {
+        const QVector<space::Space*>& spaces = p_manager.GetSpaces();
+        QHash<unsigned int, int> indexOfID;
+        for (int i = 0; i < spaces.size(); i++) indexOfID.insert(spaces[i]->GetID(), i);
+        // One merge buffer per touched space
+        QVector<QVector<unsigned long long>> merged(spaces.size());
+        time_t start, end;
+        long spaceID;
+        bool valid;
+        unsigned long startHour, endHour;
+        int count = 0;
+        while (ReadEvent(p_in, start, end, spaceID, valid)) {
+            if (!valid) return -1;
+            if (spaceID < 0 || !indexOfID.contains((unsigned int)spaceID)) continue;
+            int index = indexOfID.value((unsigned int)spaceID);
+            if (ToHours(spaces[index]->GetTimer(), start, end, startHour, endHour))
+                Time::SetHours(merged[index], startHour, endHour);
+            count++;
+        }
+        for (int i = 0; i < spaces.size(); i++)
+            if (!merged[i].isEmpty()) spaces[i]->GetTimer().MergeTimes(merged[i]);
+        return count;
+    }
+
+    // Writing
+    void ICalendar::WriteHeader(QIODevice& p_out) {
+        p_out.write("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//evies//reservations//EN\r\n");
+    }
+    void ICalendar::WriteFooter(QIODevice& p_out) {
+        p_out.write("END:VCALENDAR\r\n");
+    }
+    int ICalendar::WriteEvents(const Time& p_timer, QIODevice& p_out, const QByteArray& p_summary, const QByteArray& p_spaceID) {
+        const QVector<unsigned long long> times = p_timer.GetTimes();
+        char stamp[16], dateTime[16];
+        FormatDateTime(time(NULL), stamp);
+        QByteArray buffer;
+        buffer.reserve(1 << 16);
+        int count = 0;
+        // Emit [startHour, endHour] as one VEVENT
+        auto writeRun = [&](unsigned long p_startHour, unsigned long p_endHour) {
+            buffer.append("BEGIN:VEVENT\r\nUID:");
+            if (!p_spaceID.isEmpty()) { buffer.append(p_spaceID); buffer.append('-'); }
+            buffer.append(QByteArray::number((qint64)p_startHour));
+            buffer.append("@evies\r\nDTSTAMP:");
+            buffer.append(stamp, 16);
+            buffer.append("\r\nDTSTART:");
+            buffer.append(dateTime, FormatDateTime(p_timer.TimeOfHour(p_startHour), dateTime));
+            buffer.append("\r\nDTEND:");
+            buffer.append(dateTime, FormatDateTime(p_timer.TimeOfHour(p_endHour + 1), dateTime));
+            if (!p_summary.isEmpty()) { buffer.append("\r\nSUMMARY:"); buffer.append(p_summary); }
+            if (!p_spaceID.isEmpty()) { buffer.append("\r\nX-EVIES-SPACE:"); buffer.append(p_spaceID); }
+            buffer.append("\r\nEND:VEVENT\r\n");
+            count++;
+            if (buffer.size() > (1 << 16) - 512) {
+                p_out.write(buffer);
+                buffer.clear();
+            }
+        };
+        // Alternate between searching for the next set bit (run start)
+        // .. and the next clear bit (run end), whole words are skipped at once
+        long runStart = -1;
+        for (int j = 0; j < times.size(); j++) {
+            unsigned int bit = 0;
+            while (bit < 64) {
+                unsigned long long rest = (runStart < 0 ? times[j] : ~times[j]) & (~0ULL << bit);
+                if (!rest) break;
+                bit = qCountTrailingZeroBits(rest);
+                if (runStart < 0) runStart = (long)j * 64 + bit;
+                else {
+                    writeRun(runStart, (unsigned long)j * 64 + bit - 1);
+                    runStart = -1;
+                }
+            }
+        }
+        if (runStart >= 0) writeRun(runStart, (unsigned long)times.size() * 64 - 1);
+        if (!buffer.isEmpty()) p_out.write(buffer);
+        return count;
+    }
+    int ICalendar::Export(const Time& p_timer, QIODevice& p_out, const QString& p_summary) {
+        WriteHeader(p_out);
+        int count = WriteEvents(p_timer, p_out, EscapeText(p_summary), QByteArray());
+        WriteFooter(p_out);
+        return count;
+    }
+    int ICalendar::Export(const SpaceManager& p_manager, QIODevice& p_out) {
+        int count = 0;
+        WriteHeader(p_out);
+        for (const space::Space* space_ptr: p_manager.GetSpaces())
+            count += WriteEvents(space_ptr->GetTimer(), p_out, EscapeText(space_ptr->GetName()),
+                                 QByteArray::number((qint64)space_ptr->GetID()));
+        WriteFooter(p_out);
+        return count;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ICAL_H
+#define ICAL_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QIODevice>
+
+// User libraries
+#include "space.h"
+#include <ctime>
+
+namespace space {
+    // Streaming iCalendar (RFC 5545) reader and writer for reservations
+    // .. Only VEVENT DTSTART / DTEND are interpreted, other properties are skipped
+    // .. Times are read and written as UTC, floating times are taken as UTC too
+    // .. Times with a TZID parameter are not converted, their event is malformed
+    // .. Events are merged into the hour bitmaps word by word, never through AddReservation
+    class ICalendar {
+    public:
+        // Per space
+        // .. Returns the number of events read / written, -1 on malformed input
+        static int Import(QIODevice& p_in, Time& p_timer);
+        static int Export(const Time& p_timer, QIODevice& p_out, const QString& p_summary = QString());
+
+        // Per catalog
+        // .. Each VEVENT carries X-EVIES-SPACE with the space ID
+        // .. Events for unknown IDs are skipped on import
+        static int Import(QIODevice& p_in, SpaceManager& p_manager);
+        static int Export(const SpaceManager& p_manager, QIODevice& p_out);
+
+        // UTC date-time conversion for "YYYYMMDD[THHMMSS[Z]]" values, any other length is malformed
+        static bool ParseDateTime(const char* p_value, int p_length, time_t& p_time);
+        static int FormatDateTime(time_t p_time, char* p_buffer);
+    private:
+        // Read the next VEVENT, returns false at the end of the stream
+        // .. p_spaceID is -1 when the event has no X-EVIES-SPACE
+        static bool ReadEvent(QIODevice& p_in, time_t& p_start, time_t& p_end, long& p_spaceID, bool& p_valid);
+        // Convert [start, end) to inclusive hours of a timer, false if nothing remains after clipping
+        static bool ToHours(const Time& p_timer, time_t p_start, time_t p_end, unsigned long& p_startHour, unsigned long& p_endHour);
+        static void WriteHeader(QIODevice& p_out);
+        static void WriteFooter(QIODevice& p_out);
+        // Walk runs of set bits and write one VEVENT per run
+        static int WriteEvents(const Time& p_timer, QIODevice& p_out, const QByteArray& p_summary, const QByteArray& p_spaceID);
+    };
+}
+
+#endif // ICAL_H
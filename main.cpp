@@ -1,76 +1,195 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQmlEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QFutureWatcher>
+#include <QSharedPointer>
 #include <QObject>
 #include <QString>
+#include <QFile>
+#include <QtConcurrent/QtConcurrent>
 #include <qqml.h>
 
 // User libraries
 #include "space.h"
-#include <stdlib.h>     /* srand, rand */
-#include <time.h>       /* time */
+#include "spacequery.h"
+#include "catalogstore.h"
+#include "spacelistmodel.h"
+#include "bookingclient.h"
+#include "spacebanner.h"
+#include "availabilitycalendar.h"
+#include "startuptimeline.h"
+#include "workload.h"
+#include "metrics.h"
+#include "memoryusage.h"
+#include "waitlist.h"
+#include "sharedcatalog.h"
+#include "searchindex.h"
 #include <iostream>
 #include <vector>
 #include <string>
 
-QVector<space::Space*> GetRandomizedSpaces(int n){
-    QVector<space::Space*> returnObjects;
-    std::srand(time(NULL));
-    for (int i = 0; i < n; i++) {
-        returnObjects.push_back(
-            new space::Space{
-                i,                                      // ID
-                QString::fromStdString("Space"          // name
-                    + std::to_string(i)),
-
-                                                        // For dimensions
-                rand() % 90 + 10,                       // length
-                rand() % 45 + 5,                        // width
-                rand() % 10 + 2,                        // height
-
-                rand() % 990 + 10,                      // number of people
-
-                                                        // For seats
-                rand() % 490 + 10,                      // number of seats
-                (bool)(rand() % 2),                     // slanted?
-                (bool)(rand() % 2),                     // surround?
-                (bool)(rand() % 2),                     // comfy?
-
-                                                        // For timer
-                rand() % 9900 + 100,                    // price
-
-                (bool)(rand() % 2),                     // outdoor?
-                (bool)(rand() % 2),                     // catering?
-                (bool)(rand() % 2),                     // naturalLight?
-                (bool)(rand() % 2),                     // artificialLight?
-                (bool)(rand() % 2),                     // sound?
-                (bool)(rand() % 2),                     // projector?
-                (bool)(rand() % 2)                      // camera?
-            }
-        );
-        returnObjects.back()->GetReview().AddReview("Very bad, not good", rand() % 5);
-        returnObjects.back()->GetReview().AddReview("Okay ish", rand() % 5);
+// Print the catalog from a worker thread
+// .. Only reads the pinned snapshot, never the live QObjects
+void DumpSpaces(space::CatalogPin p_snapshot) {
+    for (int i = 0; i < p_snapshot->GetSize(); i++) {
+        const space::SpaceRecord& record = p_snapshot->At(i);
+        std::cout << "ID: " << record.ID << "\nName: " << record.name.toStdString() << "\nArea: " << record.area << " m^2" << std::endl;
+        std::cout << "Reviews: " << record.numberOfReviews << std::endl;
+        std::cout << "Review score: " << record.score << std::endl << std::endl;
     }
-    return returnObjects;
 }
 
 int main(int argc, char *argv[])
 {
+    // Cold start until both the first frame and the catalog are in
+    space::StartupTimeline timeline(QStringList{"first frame", "catalog ready"});
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
     QGuiApplication app(argc, argv);
+    timeline.Mark("application");
+
+    // Hot-path timers and counters for QML, --trace <file> captures a Chrome trace until exit
+    // .. A running kiosk can also capture through metrics.StartCapture() / metrics.SaveTrace(path)
+    space::MetricsMonitor metrics;
+    const int traceArgument = app.arguments().indexOf("--trace");
+    const QString tracePath = traceArgument > 0 && traceArgument + 1 < app.arguments().size() ? app.arguments().at(traceArgument + 1) : QString();
+    if (!tracePath.isEmpty()) metrics.StartCapture();
+
+    // Kiosks on one host can share a catalog: --publish <file> maps this one out for the others,
+    // .. --attach <file> mirrors the one published there instead of building spaces
+    // .. An attached kiosk lists and searches, pages that need live spaces stay with the publisher
+    const int publishArgument = app.arguments().indexOf("--publish");
+    const QString publishPath = publishArgument > 0 && publishArgument + 1 < app.arguments().size() ? app.arguments().at(publishArgument + 1) : QString();
+    const int attachArgument = app.arguments().indexOf("--attach");
+    const QString attachPath = attachArgument > 0 && attachArgument + 1 < app.arguments().size() ? app.arguments().at(attachArgument + 1) : QString();
+
+    // Optional booking daemon, --server <local name | tcp:port>
+    // .. The GUI is then its client: the list mirrors the daemon's spaces and bookings go to it
+    // .. through bookingClient, pages that need live spaces stay with the daemon
+    const int serverArgument = app.arguments().indexOf("--server");
+    const QString serverAddress = serverArgument > 0 && serverArgument + 1 < app.arguments().size() ? app.arguments().at(serverArgument + 1) : QString();
+    // .. Spaces are built here only when neither a publisher nor a daemon holds them
+    const bool localCatalog = attachPath.isEmpty() && serverAddress.isEmpty();
+
+    // Build the catalog on a worker while the engine compiles and loads QML
+    // .. The spaces are handed over to the GUI thread before they are published
+    QThread* guiThread = app.thread();
+    QFuture<QVector<space::Space*>> catalogLoad;
+    if (localCatalog) catalogLoad = QtConcurrent::run([guiThread]() {
+        return space::Workload::MakeSpaces(20, 1, guiThread);
+    });
+
+    space::SpaceManager manager;
+    // Spaces reach QML parentless through FindSpace, the engine would otherwise collect them
+    QObject::connect(&manager, &space::SpaceManager::SpacesChanged, &app, [&manager]() {
+        for (space::Space* space_ptr: manager.GetSpaces())
+            QQmlEngine::setObjectOwnership(space_ptr, QQmlEngine::CppOwnership);
+    });
+    // Readers work on versioned snapshots, bookings publish new versions
+    space::CatalogStore catalog(localCatalog ? &manager : nullptr);
+    space::SharedCatalogWriter sharedWriter(&catalog);
+    space::SharedCatalogReader sharedReader;
+    // Catalog queries run on a worker pool, QML gets results through signals
+    space::SpaceQueryService spaceQuery(&catalog);
+    // The main list, kept filtered and sorted incrementally
+    space::SpaceListModel spaceModel(&catalog);
+    // Type-ahead over names and tags, answered on the GUI thread per keystroke
+    space::SearchIndex searchIndex(&catalog);
+
+    // Memory by subsystem for QML and logs
+    // .. --memory-dump <seconds> logs it periodically, --memory-budget <MiB> warns above the budget
+    space::MemoryMonitor memory(&manager, &catalog);
+    memory.Watch(&spaceModel);
+    const int dumpArgument = app.arguments().indexOf("--memory-dump");
+    if (dumpArgument > 0 && dumpArgument + 1 < app.arguments().size())
+        memory.SetInterval(app.arguments().at(dumpArgument + 1).toInt() * 1000);
+    const int budgetArgument = app.arguments().indexOf("--memory-budget");
+    if (budgetArgument > 0 && budgetArgument + 1 < app.arguments().size())
+        memory.SetBudget(app.arguments().at(budgetArgument + 1).toLongLong() * 1024 * 1024);
+
+    space::BookingClient bookingClient;
+    if (!serverAddress.isEmpty()) bookingClient.ConnectToServer(serverAddress);
+
+    // Requests for taken hours wait here and are booked when the hours are freed
+    space::Waitlist waitlist;
+
+    // List rows drawn straight into the scene graph, one SpaceSummary value per row
+    qRegisterMetaType<space::SpaceSummary>();
+    qmlRegisterType<space::SpaceBanner>("Evies", 1, 0, "SpaceBanner");
+    // Heatmap pages hold live spaces and timers
+    qmlRegisterType<space::AvailabilityCalendar>("Evies", 1, 0, "AvailabilityCalendar");
+    qmlRegisterUncreatableType<space::Space>("Evies", 1, 0, "Space", "Spaces come from the catalog");
+    qmlRegisterUncreatableType<space::Time>("Evies", 1, 0, "Time", "Timers belong to spaces");
 
     QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("spaceManager", &manager);
+    engine.rootContext()->setContextProperty("catalog", &catalog);
+    engine.rootContext()->setContextProperty("spaceQuery", &spaceQuery);
+    engine.rootContext()->setContextProperty("spaceModel", &spaceModel);
+    engine.rootContext()->setContextProperty("searchIndex", &searchIndex);
+    engine.rootContext()->setContextProperty("bookingClient", &bookingClient);
+    engine.rootContext()->setContextProperty("metrics", &metrics);
+    engine.rootContext()->setContextProperty("memory", &memory);
+    engine.rootContext()->setContextProperty("waitlist", &waitlist);
     engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
     if (engine.rootObjects().isEmpty())
         return -1;
+    timeline.Mark("qml loaded");
 
-    QVector<space::Space*> randomSpaces = GetRandomizedSpaces(20);
-    for (auto space_ptr = randomSpaces.begin(); space_ptr != randomSpaces.end(); space_ptr++) {
-        std::cout << "ID: " << (*space_ptr)->GetID() << "\nName: " << (*space_ptr)->GetName().toStdString() << "\nArea: " << (*space_ptr)->GetDims().GetArea() << " m^2" << std::endl;
-        for (QString i: (*space_ptr)->GetReview().GetReviews()) {
-            std::cout << i.toStdString() << std::endl;
-        }
-        std::cout << "Review score: " << (*space_ptr)->GetReview().GetReviewScore() << std::endl << std::endl;
+    // frameSwapped comes from the render thread, the mark is queued back here
+    QQuickWindow* window = qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    if (window) {
+        QSharedPointer<QMetaObject::Connection> firstFrame(new QMetaObject::Connection());
+        *firstFrame = QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&timeline, firstFrame]() {
+            QObject::disconnect(*firstFrame);
+            timeline.Mark("first frame");
+        });
     }
-    return app.exec();
+
+    // Publishing the spaces rebuilds the snapshot, the list model reloads from it
+    // .. --dump prints the catalog from a worker once it is there
+    QFuture<void> dump;
+    QFutureWatcher<QVector<space::Space*>> catalogWatcher;
+    QObject::connect(&catalogWatcher, &QFutureWatcherBase::finished, &app, [&]() {
+        manager.SetSpaces(catalogWatcher.result());
+        timeline.Mark("catalog ready");
+        memory.Refresh();
+        if (app.arguments().contains("--dump"))
+            dump = QtConcurrent::run(&DumpSpaces, catalog.Pin());
+        if (!publishPath.isEmpty() && !sharedWriter.Open(publishPath))
+            std::cerr << "Cannot publish the catalog to " << publishPath.toStdString() << std::endl;
+    });
+    if (localCatalog) {
+        catalogWatcher.setFuture(catalogLoad);
+    } else if (attachPath.isEmpty()) {
+        // The daemon's listing fills the mirror, the first one marks it ready
+        QSharedPointer<QMetaObject::Connection> firstList(new QMetaObject::Connection());
+        *firstList = QObject::connect(&catalog, &space::CatalogStore::Rebuilt, &app, [&timeline, &memory, firstList]() {
+            QObject::disconnect(*firstList);
+            timeline.Mark("catalog ready");
+            memory.Refresh();
+        });
+        bookingClient.Mirror(&catalog);
+    } else {
+        // The mirror fills up once the publisher has written the file, the first sync marks it ready
+        QSharedPointer<QMetaObject::Connection> firstSync(new QMetaObject::Connection());
+        *firstSync = QObject::connect(&sharedReader, &space::SharedCatalogReader::Updated, &app, [&timeline, &memory, firstSync]() {
+            QObject::disconnect(*firstSync);
+            timeline.Mark("catalog ready");
+            memory.Refresh();
+        });
+        // .. A missing file is retried by the poller
+        sharedReader.Attach(attachPath);
+        sharedReader.Mirror(&catalog);
+    }
+
+    int result = app.exec();
+    // The loader and the dump must be done before the catalog goes away
+    catalogLoad.waitForFinished();
+    dump.waitForFinished();
+    if (!tracePath.isEmpty() && !metrics.SaveTrace(tracePath))
+        std::cerr << "Cannot write trace " << tracePath.toStdString() << std::endl;
+    return result;
 }
@@ -1,5 +1,6 @@
 import QtQuick 2.9
 import QtQuick.Controls 2.2
+import Evies 1.0
 // import "qrc:/TextBanner"
 
 ApplicationWindow {
@@ -20,23 +21,46 @@ ApplicationWindow {
         anchors.fill: parent
     }
 
+    // Secondary pages compile and incubate in the background after the first frame
+    // .. The first push then finds Item.qml in the component cache
+    Loader {
+        id: itemPreload
+        asynchronous: true
+        active: false
+        visible: false
+        source: "Item.qml"
+    }
+    Connections {
+        id: preloadTrigger
+        target: window
+        onFrameSwapped: {
+            preloadTrigger.enabled = false
+            itemPreload.active = true
+        }
+    }
+
     Component {
         id: mainView
         ScrollView {
             anchors.fill: parent
 
             ListView {
+                id: spaceList
                 width: parent.width
-                model: 20
-                delegate: TextBanner {
-                    name.text:  "Space " + (index + 1)
-                    area.text: index * 10 + " m²"
-                    dirhamsPerHour.text: (index + 1) * 150 + " Dhs"
-                    review.text: index / 4 + " - " + index + " reviews"
-                    frontpane.onClicked: {
-                        stack.push("Item.qml", {current_index: index, current_label: qsTr("You are looking at " + name.text + " .")})
+                // Filtered and sorted in place, bookings and reviews move single rows
+                model: spaceModel
+                // Native rows, labels are rasterized once and shared between rows
+                delegate: SpaceBanner {
+                    width: spaceList.width
+                    height: 150
+                    // One value per row, the full Space is only fetched by Item.qml
+                    summary: model.summary
+                    primaryTag: summary.outdoor ? qsTr("Parks & view") : qsTr("Indoor venue")
+                    onClicked: {
+                        stack.push("Item.qml", {current_index: index, current_id: summary.ID, current_label: qsTr("You are looking at " + name + " .")})
                     }
                 }
+                Component.onCompleted: spaceModel.SetFilter({ sortKey: "rank", descending: true })
 //                delegate: ItemDelegate {
 //                    text: "Item " + (index + 1)
 //                    width: parent.width
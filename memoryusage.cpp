@@ -0,0 +1,121 @@
+#include <QObject>
+#include <QString>
+#include <QAtomicInt>
+#include <QDebug>
+
+// User libraries
+#include "memoryusage.h"
+#include "space.h"
+#include "catalogstore.h"
+#include "spacelistmodel.h"
+
+namespace space {
+    static const char* const categoryNames[MemoryUsage::CategoryCount] = {
+        "objects", "availability", "reviews", "strings", "catalogRecords", "models", "qmlFacades"
+    };
+    static const char* const facadeNames[MemoryUsage::FacadeCount] = {
+        "spaceBanners", "availabilityCalendars", "bannerLabels"
+    };
+    static QAtomicInt facadeCounts[MemoryUsage::FacadeCount];
+    static QAtomicInteger<qint64> facadeBytes[MemoryUsage::FacadeCount];
+
+    // Facades
+    void MemoryUsage::TrackFacade(Facade p_facade, int p_count, qint64 p_bytes) {
+        facadeCounts[p_facade].fetchAndAddRelaxed(p_count);
+        facadeBytes[p_facade].fetchAndAddRelaxed(p_bytes);
+    }
+    void MemoryUsage::AddFacades() {
+        for (int facade = 0; facade < FacadeCount; facade++) {
+            const int count = facadeCounts[facade].load();
+            facades[facade] += count;
+            bytes[QmlFacades] += facadeBytes[facade].load();
+            blocks[QmlFacades] += count;
+        }
+    }
+
+    // Results
+    qint64 MemoryUsage::GetTotal() const {
+        qint64 total = 0;
+        for (int category = 0; category < CategoryCount; category++) total += bytes[category];
+        return total;
+    }
+    const char* MemoryUsage::NameOf(Category p_category) { return categoryNames[p_category]; }
+    const char* MemoryUsage::NameOf(Facade p_facade) { return facadeNames[p_facade]; }
+    QString MemoryUsage::Report() const {
+        const qint64 total = GetTotal();
+        QString report = QString("Memory, %1 spaces, %2 KiB, %3 B/space")
+                .arg(spaces).arg(total / 1024).arg(spaces ? total / spaces : 0);
+        for (int category = 0; category < CategoryCount; category++)
+            report += QString("\n  %1 %2 KiB  %3 B/space  %4 blocks")
+                    .arg(categoryNames[category], -16).arg(bytes[category] / 1024, 9)
+                    .arg(GetPerSpace((Category)category), 9, 'f', 1).arg(blocks[category], 9);
+        for (int facade = 0; facade < FacadeCount; facade++)
+            report += QString("\n  %1 %2 live").arg(facadeNames[facade], -22).arg(facades[facade], 9);
+        return report;
+    }
+    QVariantMap MemoryUsage::ToVariantMap() const {
+        QVariantMap map, categories, perSpace, live;
+        for (int category = 0; category < CategoryCount; category++) {
+            categories.insert(categoryNames[category], bytes[category]);
+            perSpace.insert(categoryNames[category], GetPerSpace((Category)category));
+        }
+        for (int facade = 0; facade < FacadeCount; facade++)
+            live.insert(facadeNames[facade], facades[facade]);
+        const qint64 total = GetTotal();
+        map.insert("total", total);
+        map.insert("spaces", spaces);
+        map.insert("totalPerSpace", spaces ? (double)total / spaces : 0.0);
+        map.insert("categories", categories);
+        map.insert("perSpace", perSpace);
+        map.insert("facades", live);
+        return map;
+    }
+
+    // Monitor
+    MemoryMonitor::MemoryMonitor(SpaceManager* p_manager, CatalogStore* p_catalog, QObject* parent) : QObject(parent) {
+        manager = p_manager;
+        catalog = p_catalog;
+        connect(&dump, &QTimer::timeout, this, [this]() {
+            const MemoryUsage usage = Collect();
+            Update(usage);
+            qInfo().noquote() << usage.Report();
+        });
+    }
+    void MemoryMonitor::SetBudget(qint64 p_budget) {
+        if (p_budget == budget) return;
+        budget = p_budget;
+        overBudget = false;
+        emit BudgetChanged();
+    }
+    void MemoryMonitor::SetInterval(int p_interval) {
+        if (p_interval == GetInterval()) return;
+        if (p_interval > 0) dump.start(p_interval);
+        else dump.stop();
+        emit IntervalChanged();
+    }
+    MemoryUsage MemoryMonitor::Collect() const {
+        MemoryUsage usage;
+        if (manager) manager->AccountMemory(usage);
+        if (catalog) catalog->AccountMemory(usage);
+        models.removeAll(QPointer<SpaceListModel>());
+        for (const QPointer<SpaceListModel>& model: models) model->AccountMemory(usage);
+        usage.AddFacades();
+        return usage;
+    }
+    void MemoryMonitor::Refresh() {
+        Update(Collect());
+    }
+    void MemoryMonitor::Update(const MemoryUsage& p_usage) {
+        report = p_usage.ToVariantMap();
+        total = p_usage.GetTotal();
+        emit Updated();
+        // Warn on the way over only, again once back under
+        const bool over = budget > 0 && total > budget;
+        if (over && !overBudget) {
+            qWarning("Memory budget exceeded: %lld KiB of %lld KiB, %d spaces",
+                     (long long)(total / 1024), (long long)(budget / 1024), p_usage.spaces);
+            emit BudgetExceeded(total, budget);
+        }
+        overBudget = over;
+    }
+}
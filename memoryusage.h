@@ -0,0 +1,158 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QSet>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantMap>
+#include <QArrayData>
+
+namespace space {
+    class SpaceManager;
+    class CatalogStore;
+    class SpaceListModel;
+
+    // Estimated bytes held by each subsystem
+    // .. Filled by the AccountMemory hooks of the manager, catalog and models
+    // .. Implicitly shared buffers are counted once, on the first holder visited,
+    // .. so a bitmap shared by a timer and its catalog record is not counted twice
+    // .. Heap blocks are rounded like malloc, Qt private data uses fixed estimates
+    class MemoryUsage {
+    public:
+        enum Category {
+            // QObjects of the spaces and the manager's pointer list
+            Objects,
+            // Hour bitmaps, live and in snapshots
+            Availability,
+            // Review lists and texts
+            Reviews,
+            // Names and tags
+            Strings,
+            // Catalog snapshots and their shards
+            CatalogRecords,
+            // List model indexes
+            Models,
+            // Live QML items and their textures
+            QmlFacades,
+            CategoryCount
+        };
+        // Items drawn by QML, counted by their constructors and destructors
+        enum Facade {
+            SpaceBannerFacade,
+            AvailabilityCalendarFacade,
+            BannerLabelFacade,
+            FacadeCount
+        };
+        // Size estimates for private data sizeof cannot see
+        enum {
+            QObjectPrivateBytes = 120,
+            QQuickItemPrivateBytes = 640
+        };
+
+        qint64 bytes[CategoryCount] = {};
+        // Distinct heap blocks behind the bytes
+        qint64 blocks[CategoryCount] = {};
+        int spaces = 0;
+        int facades[FacadeCount] = {};
+
+        // Malloc block for p_bytes of payload
+        static qint64 HeapBytes(qint64 p_bytes) { return (p_bytes + 8 + 15) & ~(qint64)15; }
+
+        // Hooks
+        // .. AddVector and AddString return false for a buffer already counted
+        void AddObject(Category p_category, qint64 p_bytes) {
+            bytes[p_category] += HeapBytes(p_bytes);
+            blocks[p_category]++;
+        }
+        void AddQObject(Category p_category, qint64 p_bytes) {
+            AddObject(p_category, p_bytes);
+            AddObject(p_category, QObjectPrivateBytes);
+        }
+        template <typename T> bool AddVector(Category p_category, const QVector<T>& p_vector) {
+            if (p_vector.capacity() == 0 || !Claim(p_vector.constData())) return false;
+            AddObject(p_category, sizeof(QArrayData) + p_vector.capacity() * sizeof(T));
+            return true;
+        }
+        bool AddString(Category p_category, const QString& p_string) {
+            if (p_string.capacity() == 0 || !Claim(p_string.constData())) return false;
+            AddObject(p_category, sizeof(QArrayData) + (p_string.capacity() + 1) * sizeof(QChar));
+            return true;
+        }
+        // Adds the live facades
+        void AddFacades();
+
+        // Results
+        qint64 GetTotal() const;
+        double GetPerSpace(Category p_category) const { return spaces ? (double)bytes[p_category] / spaces : 0; }
+        static const char* NameOf(Category p_category);
+        static const char* NameOf(Facade p_facade);
+        // Totals and per-space averages, one line per category
+        QString Report() const;
+        QVariantMap ToVariantMap() const;
+
+        // Facade constructors and destructors, any thread
+        // .. p_count and p_bytes are deltas
+        static void TrackFacade(Facade p_facade, int p_count, qint64 p_bytes);
+    private:
+        QSet<const void*> seen;
+        bool Claim(const void* p_buffer) {
+            if (seen.contains(p_buffer)) return false;
+            seen.insert(p_buffer);
+            return true;
+        }
+    };
+
+    // Memory report for QML and logs
+    // .. Collects on the GUI thread, every interval milliseconds or on Refresh
+    // .. Logs the report each interval, and warns once each time the total
+    // .. goes over the budget (0 for none)
+    class MemoryMonitor : public QObject {
+        Q_OBJECT
+        Q_PROPERTY(QVariantMap report READ GetReport NOTIFY Updated)
+        Q_PROPERTY(qint64 total READ GetTotal NOTIFY Updated)
+        Q_PROPERTY(qint64 budget READ GetBudget WRITE SetBudget NOTIFY BudgetChanged)
+        Q_PROPERTY(int interval READ GetInterval WRITE SetInterval NOTIFY IntervalChanged)
+    signals:
+        void Updated();
+        void BudgetChanged();
+        void IntervalChanged();
+        void BudgetExceeded(qint64 total, qint64 budget);
+    private:
+        SpaceManager* manager;
+        CatalogStore* catalog;
+        // .. Destroyed models are dropped by the next Collect
+        mutable QVector<QPointer<SpaceListModel>> models;
+        QVariantMap report;
+        qint64 total = 0;
+        qint64 budget = 0;
+        bool overBudget = false;
+        QTimer dump;
+        void Update(const MemoryUsage& p_usage);
+    public:
+        explicit MemoryMonitor(SpaceManager* p_manager, CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~MemoryMonitor() {}
+
+        // Also count a list model's indexes, once however often it is watched
+        void Watch(SpaceListModel* p_model) {
+            if (p_model && !models.contains(p_model)) models.append(p_model);
+        }
+
+        // Setters
+        void SetBudget(qint64 p_budget);
+        void SetInterval(int p_interval);
+
+        // Getters
+        QVariantMap GetReport() const { return report; }
+        qint64 GetTotal() const { return total; }
+        qint64 GetBudget() const { return budget; }
+        int GetInterval() const { return dump.isActive() ? dump.interval() : 0; }
+
+        MemoryUsage Collect() const;
+        Q_INVOKABLE void Refresh();
+    };
+}
+
+#endif // MEMORYUSAGE_H
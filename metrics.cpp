@@ -0,0 +1,304 @@
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QThread>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QtAlgorithms>
+
+// User libraries
+#include "metrics.h"
+#include <chrono>
+
+namespace space {
+    static const char* const timerNames[Metrics::TimerCount] = {
+        "AddReservation", "RemoveReservation", "AddSeries", "AddReview",
+        "SetSpaces", "FindSpace", "ManagerUpdate",
+        "CatalogRebuild", "CatalogFlush",
+        "ModelReload", "ModelUpdate", "ModelResort", "ModelRefilter",
+        "GroupSolve", "SearchComplete", "ReservationCommit"
+    };
+    static const char* const counterNames[Metrics::CounterCount] = {
+        "reservationsBooked", "reservationConflicts", "reservationsInvalid", "reservationsRemoved",
+        "reviewsAdded",
+        "modelRowsInserted", "modelRowsRemoved", "modelRowsMoved", "modelResets",
+        "waitlistGranted", "waitlistExpired",
+        "sharedCatalogRetries"
+    };
+
+    // One complete event of a capture
+    // .. Timer in the top byte of packed, duration below it
+    struct TraceSlot {
+        QAtomicInteger<qint64> start;
+        QAtomicInteger<quint64> packed;
+    };
+
+    // Everything one thread records
+    // .. Only the owning thread writes, so updates are a relaxed load and store,
+    // .. the atomics only keep concurrent readers well defined
+    // .. Buffers are never freed, a thread that exits hands its buffer to the next new one
+    struct ThreadBuffer {
+        QAtomicInteger<quint64> buckets[Metrics::TimerCount][Metrics::BucketCount];
+        QAtomicInteger<quint64> sums[Metrics::TimerCount];
+        QAtomicInteger<quint64> maxima[Metrics::TimerCount];
+        QAtomicInteger<quint64> counters[Metrics::CounterCount];
+        // Capture ring, allocated by the owner on its first captured event
+        QAtomicPointer<TraceSlot> trace;
+        QAtomicInteger<quint64> traceHead;
+        // Track in the trace, and the name of the thread that first owned it
+        int track = 0;
+        QByteArray name;
+        QAtomicInt inUse;
+        ThreadBuffer* next = nullptr;
+    };
+    static QAtomicPointer<ThreadBuffer> buffers;
+    static QAtomicInt bufferCount;
+    static QAtomicInt capturing;
+    static QAtomicInteger<qint64> captureStart;
+
+    static inline void Add(QAtomicInteger<quint64>& p_value, quint64 p_amount) {
+        p_value.store(p_value.load() + p_amount);
+    }
+
+    // Buffers
+    static ThreadBuffer* Claim() {
+        for (ThreadBuffer* buffer = buffers.loadAcquire(); buffer; buffer = buffer->next)
+            if (buffer->inUse.testAndSetAcquire(0, 1)) return buffer;
+        ThreadBuffer* buffer = new ThreadBuffer();
+        buffer->inUse.store(1);
+        buffer->track = bufferCount.fetchAndAddRelaxed(1) + 1;
+        const QString name = QThread::currentThread()->objectName();
+        buffer->name = name.isEmpty() ? QString("thread %1").arg(buffer->track).toUtf8() : name.toUtf8();
+        ThreadBuffer* head;
+        do {
+            head = buffers.loadAcquire();
+            buffer->next = head;
+        } while (!buffers.testAndSetRelease(head, buffer));
+        return buffer;
+    }
+    // .. Released when the thread exits
+    struct BufferClaim {
+        ThreadBuffer* buffer = nullptr;
+        ~BufferClaim() { if (buffer) buffer->inUse.storeRelease(0); }
+    };
+    static thread_local BufferClaim localClaim;
+    static inline ThreadBuffer& LocalBuffer() {
+        if (Q_UNLIKELY(!localClaim.buffer)) localClaim.buffer = Claim();
+        return *localClaim.buffer;
+    }
+
+    // Buckets
+    // .. Below 2^(SubBucketBits + 1) the value is its bucket, above it the
+    // .. bucket is the exponent and the top SubBucketBits bits after the leading one
+    int Metrics::BucketOf(quint64 p_nanoseconds) {
+        if (p_nanoseconds >> MaxExponent) return BucketCount - 1;
+        const int msb = 63 - qCountLeadingZeroBits(p_nanoseconds | 1);
+        const int shift = qMax(0, msb - SubBucketBits);
+        return (shift << SubBucketBits) + (int)(p_nanoseconds >> shift);
+    }
+    quint64 Metrics::BucketLow(int p_bucket) {
+        if (p_bucket < (2 << SubBucketBits)) return p_bucket;
+        const int shift = (p_bucket >> SubBucketBits) - 1;
+        return (quint64)(p_bucket - (shift << SubBucketBits)) << shift;
+    }
+    quint64 Metrics::BucketHigh(int p_bucket) {
+        const int shift = p_bucket < (2 << SubBucketBits) ? 0 : (p_bucket >> SubBucketBits) - 1;
+        return BucketLow(p_bucket) + (1ULL << shift) - 1;
+    }
+    quint64 Metrics::Histogram::Percentile(double p_quantile) const {
+        if (count == 0) return 0;
+        const quint64 rank = qMax((quint64)1, (quint64)(p_quantile * count + 0.5));
+        quint64 seen = 0;
+        for (int i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) return qMin(BucketHigh(i), max);
+        }
+        return max;
+    }
+
+    const char* Metrics::NameOf(Timer p_timer) { return timerNames[p_timer]; }
+    const char* Metrics::NameOf(Counter p_counter) { return counterNames[p_counter]; }
+
+    // Recording
+    qint64 Metrics::Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    void Metrics::Record(Timer p_timer, qint64 p_start, qint64 p_end) {
+        ThreadBuffer& buffer = LocalBuffer();
+        const quint64 duration = p_end > p_start ? p_end - p_start : 0;
+        Add(buffer.buckets[p_timer][BucketOf(duration)], 1);
+        Add(buffer.sums[p_timer], duration);
+        if (duration > buffer.maxima[p_timer].load()) buffer.maxima[p_timer].store(duration);
+        if (!capturing.load()) return;
+        TraceSlot* trace = buffer.trace.load();
+        if (Q_UNLIKELY(!trace)) {
+            trace = new TraceSlot[TraceCapacity];
+            buffer.trace.storeRelease(trace);
+        }
+        const quint64 head = buffer.traceHead.load();
+        TraceSlot& slot = trace[head % TraceCapacity];
+        slot.start.store(p_start);
+        slot.packed.store(((quint64)p_timer << 56) | qMin(duration, (1ULL << 56) - 1));
+        // .. Publishes the slot to WriteChromeTrace
+        buffer.traceHead.storeRelease(head + 1);
+    }
+    void Metrics::Count(Counter p_counter, quint64 p_amount) {
+        Add(LocalBuffer().counters[p_counter], p_amount);
+    }
+
+    // Reading
+    Metrics::Snapshot Metrics::Collect() {
+        Snapshot snapshot;
+        for (int timer = 0; timer < TimerCount; timer++) snapshot.timers[timer].buckets.fill(0, BucketCount);
+        for (ThreadBuffer* buffer = buffers.loadAcquire(); buffer; buffer = buffer->next) {
+            for (int timer = 0; timer < TimerCount; timer++) {
+                Histogram& histogram = snapshot.timers[timer];
+                for (int i = 0; i < BucketCount; i++) {
+                    const quint64 count = buffer->buckets[timer][i].load();
+                    histogram.buckets[i] += count;
+                    histogram.count += count;
+                }
+                histogram.sum += buffer->sums[timer].load();
+                histogram.max = qMax(histogram.max, (quint64)buffer->maxima[timer].load());
+            }
+            for (int counter = 0; counter < CounterCount; counter++)
+                snapshot.counters[counter] += buffer->counters[counter].load();
+        }
+        return snapshot;
+    }
+    QString Metrics::Report() {
+        const Snapshot snapshot = Collect();
+        QString report = "Metrics (us)";
+        for (int timer = 0; timer < TimerCount; timer++) {
+            const Histogram& histogram = snapshot.timers[timer];
+            if (histogram.count == 0) continue;
+            report += QString("\n  %1 %2  mean %3  p50 %4  p99 %5  max %6")
+                    .arg(timerNames[timer], -22).arg(histogram.count, 9)
+                    .arg(histogram.Mean() / 1000, 0, 'f', 2)
+                    .arg(histogram.Percentile(0.5) / 1000.0, 0, 'f', 2)
+                    .arg(histogram.Percentile(0.99) / 1000.0, 0, 'f', 2)
+                    .arg(histogram.max / 1000.0, 0, 'f', 2);
+        }
+        for (int counter = 0; counter < CounterCount; counter++)
+            if (snapshot.counters[counter])
+                report += QString("\n  %1 %2").arg(counterNames[counter], -22).arg(snapshot.counters[counter], 9);
+        return report;
+    }
+
+    // Capture
+    void Metrics::StartCapture() {
+        captureStart.store(Now());
+        capturing.storeRelease(1);
+    }
+    void Metrics::StopCapture() {
+        capturing.storeRelease(0);
+    }
+    bool Metrics::IsCapturing() {
+        return capturing.load() != 0;
+    }
+    void Metrics::WriteChromeTrace(QIODevice& p_device) {
+        const qint64 origin = captureStart.load();
+        QByteArray buffer;
+        buffer.reserve(1 << 16);
+        buffer += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        auto separate = [&]() {
+            if (!first) buffer += ",\n";
+            first = false;
+        };
+        for (ThreadBuffer* thread = buffers.loadAcquire(); thread; thread = thread->next) {
+            const TraceSlot* trace = thread->trace.loadAcquire();
+            if (!trace) continue;
+            const QByteArray track = QByteArray::number(thread->track);
+            separate();
+            buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + track
+                    + ",\"args\":{\"name\":\"" + thread->name + "\"}}";
+            // .. Oldest event still in the ring first
+            const quint64 head = thread->traceHead.loadAcquire();
+            for (quint64 i = head > TraceCapacity ? head - TraceCapacity : 0; i < head; i++) {
+                const TraceSlot& slot = trace[i % TraceCapacity];
+                const qint64 start = slot.start.load();
+                const quint64 packed = slot.packed.load();
+                if (start < origin) continue;
+                separate();
+                buffer += "{\"name\":\"";
+                buffer += timerNames[qMin((int)(packed >> 56), (int)TimerCount - 1)];
+                buffer += "\",\"cat\":\"evies\",\"ph\":\"X\",\"pid\":1,\"tid\":" + track;
+                buffer += ",\"ts\":" + QByteArray::number((start - origin) / 1000.0, 'f', 3);
+                buffer += ",\"dur\":" + QByteArray::number((packed & ((1ULL << 56) - 1)) / 1000.0, 'f', 3) + "}";
+                if (buffer.size() >= (1 << 16) - 256) {
+                    p_device.write(buffer);
+                    buffer.clear();
+                }
+            }
+        }
+        // Counter totals at the end of the capture
+        const Snapshot snapshot = Collect();
+        separate();
+        buffer += "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":"
+                + QByteArray::number((Now() - origin) / 1000.0, 'f', 3) + ",\"args\":{";
+        for (int counter = 0; counter < CounterCount; counter++) {
+            if (counter > 0) buffer += ',';
+            buffer += QByteArray("\"") + counterNames[counter] + "\":" + QByteArray::number(snapshot.counters[counter]);
+        }
+        buffer += "}}\n]}\n";
+        p_device.write(buffer);
+    }
+
+    // Metrics for QML
+    MetricsMonitor::MetricsMonitor(QObject* parent) : QObject(parent) {
+        connect(&refresh, &QTimer::timeout, this, &MetricsMonitor::Refresh);
+        SetInterval(1000);
+    }
+    void MetricsMonitor::SetInterval(int p_interval) {
+        if (p_interval == GetInterval()) return;
+        if (p_interval > 0) refresh.start(p_interval);
+        else refresh.stop();
+        emit IntervalChanged();
+    }
+    bool MetricsMonitor::IsEnabled() const {
+#ifndef EVIES_NO_METRICS
+        return true;
+#else
+        return false;
+#endif
+    }
+    void MetricsMonitor::Refresh() {
+        const Metrics::Snapshot snapshot = Metrics::Collect();
+        timers.clear();
+        for (int timer = 0; timer < Metrics::TimerCount; timer++) {
+            const Metrics::Histogram& histogram = snapshot.timers[timer];
+            QVariantMap row;
+            row.insert("name", timerNames[timer]);
+            row.insert("count", histogram.count);
+            row.insert("mean", histogram.Mean() / 1000);
+            row.insert("p50", histogram.Percentile(0.5) / 1000.0);
+            row.insert("p90", histogram.Percentile(0.9) / 1000.0);
+            row.insert("p99", histogram.Percentile(0.99) / 1000.0);
+            row.insert("max", histogram.max / 1000.0);
+            timers.append(row);
+        }
+        counters.clear();
+        for (int counter = 0; counter < Metrics::CounterCount; counter++)
+            counters.insert(counterNames[counter], snapshot.counters[counter]);
+        emit Updated();
+    }
+    void MetricsMonitor::StartCapture() {
+        const bool was = Metrics::IsCapturing();
+        Metrics::StartCapture();
+        if (!was) emit CapturingChanged();
+    }
+    void MetricsMonitor::StopCapture() {
+        if (!Metrics::IsCapturing()) return;
+        Metrics::StopCapture();
+        emit CapturingChanged();
+    }
+    bool MetricsMonitor::SaveTrace(const QString& p_path) {
+        StopCapture();
+        QFile file(p_path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+        Metrics::WriteChromeTrace(file);
+        return true;
+    }
+}
@@ -0,0 +1,174 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVariantList>
+#include <QTimer>
+#include <QIODevice>
+
+namespace space {
+    // Hot-path instrumentation
+    // .. Timers and counters are fixed enums, recording one is an array index
+    // .. Each thread records into its own buffer with plain relaxed stores,
+    // .. readers add the buffers up without stopping the writers
+    // .. DEFINES += EVIES_NO_METRICS compiles the EVIES_ macros below away,
+    // .. the reading side stays and reports zeros
+    class Metrics {
+    public:
+        enum Timer {
+            AddReservationTimer,
+            RemoveReservationTimer,
+            AddSeriesTimer,
+            AddReviewTimer,
+            SetSpacesTimer,
+            FindSpaceTimer,
+            ManagerUpdateTimer,
+            CatalogRebuildTimer,
+            CatalogFlushTimer,
+            ModelReloadTimer,
+            ModelUpdateTimer,
+            ModelResortTimer,
+            ModelRefilterTimer,
+            GroupSolveTimer,
+            SearchCompleteTimer,
+            ReservationCommitTimer,
+            TimerCount
+        };
+        enum Counter {
+            ReservationsBooked,
+            ReservationConflicts,
+            ReservationsInvalid,
+            ReservationsRemoved,
+            ReviewsAdded,
+            ModelRowsInserted,
+            ModelRowsRemoved,
+            ModelRowsMoved,
+            ModelResets,
+            WaitlistGranted,
+            WaitlistExpired,
+            SharedCatalogRetries,
+            CounterCount
+        };
+
+        // Log-linear buckets over nanoseconds, HDR style
+        // .. 16 buckets per power of two (about 6% error), exact below 32 ns
+        // .. Spans of 2^40 ns (18 minutes) and more share the last bucket
+        enum {
+            SubBucketBits = 4,
+            MaxExponent = 40,
+            BucketCount = (MaxExponent - SubBucketBits + 1) << SubBucketBits
+        };
+        static int BucketOf(quint64 p_nanoseconds);
+        static quint64 BucketLow(int p_bucket);
+        static quint64 BucketHigh(int p_bucket);
+
+        // One timer merged over every thread
+        struct Histogram {
+            quint64 count = 0, sum = 0, max = 0;
+            QVector<quint64> buckets;
+            double Mean() const { return count ? (double)sum / count : 0; }
+            // .. Upper edge of the bucket holding the quantile, in nanoseconds
+            quint64 Percentile(double p_quantile) const;
+        };
+        struct Snapshot {
+            Histogram timers[TimerCount];
+            quint64 counters[CounterCount] = {};
+        };
+
+        static const char* NameOf(Timer p_timer);
+        static const char* NameOf(Counter p_counter);
+
+        // Recording, any thread
+        // .. Monotonic nanoseconds
+        static qint64 Now();
+        static void Record(Timer p_timer, qint64 p_start, qint64 p_end);
+        static void Count(Counter p_counter, quint64 p_amount = 1);
+
+        // Reading, any thread
+        // .. Totals since start, counts of exited threads included
+        static Snapshot Collect();
+        // .. One line per timer and counter that has seen anything
+        static QString Report();
+
+        // Chrome trace capture
+        // .. While capturing, every timed scope is also kept as a complete event
+        // .. in its thread's ring of the last TraceCapacity events
+        enum { TraceCapacity = 1 << 14 };
+        static void StartCapture();
+        static void StopCapture();
+        static bool IsCapturing();
+        // .. Events since the last StartCapture as Chrome trace JSON, for chrome://tracing or Perfetto
+        // .. Stop first, events overwritten during the write would be missing
+        static void WriteChromeTrace(QIODevice& p_device);
+    };
+
+    // Times the enclosing scope
+    class ScopedTimer {
+    private:
+        Metrics::Timer timer;
+        qint64 start;
+    public:
+        explicit ScopedTimer(Metrics::Timer p_timer) : timer(p_timer), start(Metrics::Now()) {}
+        ~ScopedTimer() { Metrics::Record(timer, start, Metrics::Now()); }
+    };
+
+    // Metrics for QML
+    // .. Re-collected every interval milliseconds, 0 only on Refresh
+    // .. Timer rows are maps of name, count, and mean/p50/p90/p99/max in microseconds
+    class MetricsMonitor : public QObject {
+        Q_OBJECT
+        Q_PROPERTY(QVariantList timers READ GetTimers NOTIFY Updated)
+        Q_PROPERTY(QVariantMap counters READ GetCounters NOTIFY Updated)
+        Q_PROPERTY(int interval READ GetInterval WRITE SetInterval NOTIFY IntervalChanged)
+        Q_PROPERTY(bool capturing READ IsCapturing NOTIFY CapturingChanged)
+        Q_PROPERTY(bool enabled READ IsEnabled CONSTANT)
+    signals:
+        void Updated();
+        void IntervalChanged();
+        void CapturingChanged();
+    private:
+        QVariantList timers;
+        QVariantMap counters;
+        QTimer refresh;
+    public:
+        explicit MetricsMonitor(QObject* parent = nullptr);
+        virtual ~MetricsMonitor() {}
+
+        // Setters
+        void SetInterval(int p_interval);
+
+        // Getters
+        QVariantList GetTimers() const { return timers; }
+        QVariantMap GetCounters() const { return counters; }
+        int GetInterval() const { return refresh.isActive() ? refresh.interval() : 0; }
+        bool IsCapturing() const { return Metrics::IsCapturing(); }
+        // False in EVIES_NO_METRICS builds
+        bool IsEnabled() const;
+
+        Q_INVOKABLE void Refresh();
+        Q_INVOKABLE void StartCapture();
+        Q_INVOKABLE void StopCapture();
+        // Stops the capture and writes it, false if the file cannot be written
+        Q_INVOKABLE bool SaveTrace(const QString& p_path);
+    };
+}
+
+// Recording macros
+// .. EVIES_TIME_SCOPE(AddReservationTimer) times the rest of the scope
+#ifndef EVIES_NO_METRICS
+#define EVIES_METRICS_JOIN2(a, b) a##b
+#define EVIES_METRICS_JOIN(a, b) EVIES_METRICS_JOIN2(a, b)
+#define EVIES_TIME_SCOPE(timer) space::ScopedTimer EVIES_METRICS_JOIN(eviesScopedTimer, __LINE__)(space::Metrics::timer)
+#define EVIES_COUNT(counter) space::Metrics::Count(space::Metrics::counter)
+#define EVIES_COUNT_N(counter, amount) space::Metrics::Count(space::Metrics::counter, (amount))
+#else
+#define EVIES_TIME_SCOPE(timer) ((void)0)
+#define EVIES_COUNT(counter) ((void)0)
+#define EVIES_COUNT_N(counter, amount) ((void)0)
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,72 @@
+#include <QObject>
+#include <QVector>
+
+// User libraries
+#include "occupancy.h"
+#include "parallel.h"
+
+namespace space {
+    QVariantMap Utilisation::ToVariantMap() const {
+        QVariantMap map;
+        map["ID"] = ID;
+        map["booked"] = booked;
+        map["hours"] = hours;
+        map["rate"] = GetRate();
+        map["revenue"] = revenue;
+        return map;
+    }
+
+    // Same counts over a live Time or a ReservationView
+    template <typename Timer> static Utilisation Measure(unsigned int p_ID, const Timer& p_timer, const OccupancyWindow& p_window) {
+        Utilisation utilisation;
+        utilisation.ID = p_ID;
+        if (p_window.IsWholeDay()) {
+            utilisation.hours = p_timer.CountBookable(p_window.from, p_window.to);
+            utilisation.booked = p_timer.CountBookedBetween(p_window.from, p_window.to);
+        } else if (p_window.peakFrom < p_window.peakTo) {
+            // .. One peak slice per UTC day overlapping the window
+            const time_t day = 24 * 3600;
+            time_t midnight = p_window.from - ((p_window.from % day) + day) % day;
+            for (; midnight < p_window.to; midnight += day) {
+                const time_t from = qMax(midnight + p_window.peakFrom * 3600, p_window.from);
+                const time_t to = qMin(midnight + p_window.peakTo * 3600, p_window.to);
+                utilisation.hours += p_timer.CountBookable(from, to);
+                utilisation.booked += p_timer.CountBookedBetween(from, to);
+            }
+        }
+        utilisation.revenue = utilisation.booked * p_timer.GetDirhamsPerHour();
+        return utilisation;
+    }
+    // Calls p_measure(i) for i in [0, p_count) on the global thread pool
+    template <typename Measurer> static QVector<Utilisation> MeasureAll(int p_count, Measurer p_measure) {
+        QVector<Utilisation> utilisations(p_count);
+        ForEachChunk(p_count, [&](int p_begin, int p_end) {
+            for (int i = p_begin; i < p_end; i++) utilisations[i] = p_measure(i);
+        });
+        return utilisations;
+    }
+
+    Utilisation OccupancyReport::ForSpace(const Space& p_space, const OccupancyWindow& p_window) {
+        return Measure(p_space.GetID(), p_space.GetTimer(), p_window);
+    }
+    Utilisation OccupancyReport::ForSpace(const ReservationView& p_space, const OccupancyWindow& p_window) {
+        return Measure(p_space.GetID(), p_space, p_window);
+    }
+
+    void OccupancyReport::PrepareCounts(const QVector<Space*>& p_spaces) {
+        for (const Space* space_ptr: p_spaces) space_ptr->GetTimer().PrepareCounts();
+    }
+    QVector<Utilisation> OccupancyReport::PerSpace(const QVector<Space*>& p_spaces, const OccupancyWindow& p_window) {
+        PrepareCounts(p_spaces);
+        return MeasureAll(p_spaces.size(), [&](int i) { return ForSpace(*p_spaces[i], p_window); });
+    }
+    QVector<Utilisation> OccupancyReport::PerSpace(const ReservationSnapshot& p_snapshot, const OccupancyWindow& p_window) {
+        return MeasureAll(p_snapshot.GetSize(), [&](int i) { return ForSpace(p_snapshot.At(i), p_window); });
+    }
+
+    Utilisation OccupancyReport::Total(const QVector<Utilisation>& p_utilisations) {
+        Utilisation total;
+        for (const Utilisation& utilisation: p_utilisations) total += utilisation;
+        return total;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <QObject>
+#include <QVector>
+#include <QVariantMap>
+
+// User libraries
+#include "space.h"
+#include "superspace.h"
+#include "reservationstore.h"
+
+namespace space {
+    // Window of an occupancy report, [from, to)
+    struct OccupancyWindow {
+        time_t from = 0, to = 0;
+        // Peak hours only, UTC hours of day [peakFrom, peakTo), the whole day by default
+        int peakFrom = 0, peakTo = 24;
+        bool IsWholeDay() const { return peakFrom <= 0 && peakTo >= 24; }
+    };
+
+    // Booked and bookable hours of one space, or of a group when ID is 0
+    struct Utilisation {
+        unsigned int ID = 0;
+        quint64 booked = 0, hours = 0;
+        // Booked hours at the current price, bookings do not remember theirs
+        double revenue = 0;
+        double GetRate() const { return hours ? (double)booked / hours : 0; }
+        Utilisation& operator+=(const Utilisation& p_other) {
+            booked += p_other.booked;
+            hours += p_other.hours;
+            revenue += p_other.revenue;
+            return *this;
+        }
+        QVariantMap ToVariantMap() const;
+    };
+
+    // Utilisation and revenue analytics over the occupancy index of each timer
+    // .. A space costs O(log n) per window, or per day of the window with peak hours
+    // .. Catalog reports run on the global thread pool, one chunk of spaces per worker
+    // .. Over live spaces nothing may book from another thread meanwhile; over a
+    // .. ReservationSnapshot bookings carry on and the report sees one epoch throughout
+    class OccupancyReport {
+    public:
+        static Utilisation ForSpace(const Space& p_space, const OccupancyWindow& p_window);
+        static Utilisation ForSpace(const ReservationView& p_space, const OccupancyWindow& p_window);
+        // Builds each timer's occupancy index on the calling thread, so workers counting
+        // .. live spaces afterwards only read them
+        static void PrepareCounts(const QVector<Space*>& p_spaces);
+        // One entry per space, in order
+        static QVector<Utilisation> PerSpace(const QVector<Space*>& p_spaces, const OccupancyWindow& p_window);
+        static QVector<Utilisation> PerSpace(const ReservationSnapshot& p_snapshot, const OccupancyWindow& p_window);
+        static Utilisation Total(const QVector<Utilisation>& p_utilisations);
+        static Utilisation Catalog(const SpaceManager& p_manager, const OccupancyWindow& p_window) {
+            return Total(PerSpace(p_manager.GetSpaces(), p_window));
+        }
+        static Utilisation Catalog(const ReservationSnapshot& p_snapshot, const OccupancyWindow& p_window) {
+            return Total(PerSpace(p_snapshot, p_window));
+        }
+        static Utilisation Venue(const SuperSpace& p_venue, const OccupancyWindow& p_window) {
+            return Total(PerSpace(p_venue.GetSpaces(), p_window));
+        }
+    };
+}
+
+#endif // OCCUPANCY_H
@@ -0,0 +1,22 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+namespace space {
+    enum { DefaultChunkSize = 1024 };
+
+    // Runs p_body(begin, end) over chunks of [0, p_count) on the global thread pool, blocking
+    // .. Chunks start at multiples of p_chunkSize, so begin / p_chunkSize numbers them
+    // .. blockingMap over chunk starts, Qt 5 cannot deduce a lambda's result for mapped()
+    template <typename Body> void ForEachChunk(int p_count, Body p_body, int p_chunkSize = DefaultChunkSize) {
+        QVector<int> chunks;
+        for (int begin = 0; begin < p_count; begin += p_chunkSize) chunks.append(begin);
+        QtConcurrent::blockingMap(chunks, [p_count, p_chunkSize, &p_body](int p_begin) {
+            p_body(p_begin, qMin(p_begin + p_chunkSize, p_count));
+        });
+    }
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,157 @@
+#ifndef RECORDSCHEMA_H
+#define RECORDSCHEMA_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVariantList>
+
+// User libraries
+#include "spacequery.h"
+#include <type_traits>
+
+namespace space {
+    // Compile-time description of SpaceRecord
+    // .. One type per column with its name and an inlined read, RecordSchema lists them in order
+    // .. Model roles, variant maps, batch columns and comparators are expanded from that
+    // .. list, reading a column is one call through a fixed table, never a QMetaProperty lookup
+    // .. Adding a column is one EVIES_RECORD_FIELD line and one entry in RecordSchema
+    namespace fields {
+#define EVIES_RECORD_FIELD(p_type, p_field, p_name, p_read) \
+        struct p_field { \
+            typedef p_type Type; \
+            static const char* Key() { return p_name; } \
+            static Type Get(const SpaceRecord& p_record) { return p_read; } \
+        };
+        EVIES_RECORD_FIELD(unsigned int, ID, "ID", p_record.ID)
+        EVIES_RECORD_FIELD(QString, Name, "name", p_record.name)
+        EVIES_RECORD_FIELD(float, Area, "area", p_record.area)
+        EVIES_RECORD_FIELD(unsigned int, NumberOfPeople, "numberOfPeople", p_record.numberOfPeople)
+        EVIES_RECORD_FIELD(unsigned int, NumberOfSeats, "numberOfSeats", p_record.numberOfSeats)
+        EVIES_RECORD_FIELD(double, DirhamsPerHour, "dirhamsPerHour", p_record.dirhamsPerHour)
+        EVIES_RECORD_FIELD(float, Score, "score", p_record.score)
+        EVIES_RECORD_FIELD(unsigned int, NumberOfReviews, "numberOfReviews", p_record.numberOfReviews)
+        EVIES_RECORD_FIELD(unsigned int, Flags, "flags", p_record.flags)
+        EVIES_RECORD_FIELD(bool, Outdoor, "outdoor", (p_record.flags & SpaceRecord::Outdoor) != 0)
+        EVIES_RECORD_FIELD(bool, Catering, "catering", (p_record.flags & SpaceRecord::Catering) != 0)
+        EVIES_RECORD_FIELD(QString, Tags, "tags", p_record.GetTags())
+        EVIES_RECORD_FIELD(float, Rank, "rank", p_record.GetRank())
+#undef EVIES_RECORD_FIELD
+    }
+
+    // Position of Field in Fields, a compile error if it is not there
+    template <typename Field, typename... Fields> struct FieldIndex;
+    template <typename Field, typename... Rest> struct FieldIndex<Field, Field, Rest...> {
+        enum { Value = 0 };
+    };
+    template <typename Field, typename First, typename... Rest> struct FieldIndex<Field, First, Rest...> {
+        enum { Value = 1 + FieldIndex<Field, Rest...>::Value };
+    };
+
+    template <typename... Fields> class RecordColumns {
+        // Per-field operations, one instance per column in the tables below
+        static double Number(bool p_value) { return p_value; }
+        static double Number(unsigned int p_value) { return p_value; }
+        static double Number(double p_value) { return p_value; }
+        static double Number(const QString&) { return 0; }
+        template <typename Field> static QVariant ReadField(const SpaceRecord& p_record) {
+            return QVariant::fromValue(Field::Get(p_record));
+        }
+        template <typename Field> static double NumberField(const SpaceRecord& p_record) {
+            return Number(Field::Get(p_record));
+        }
+        template <typename T> static int CompareValues(const T& x, const T& y) { return x < y ? -1 : y < x ? 1 : 0; }
+        static int CompareValues(const QString& x, const QString& y) { return CompareText(x, y); }
+        template <typename Field> static int CompareField(const SpaceRecord& a, const SpaceRecord& b) {
+            return CompareValues(Field::Get(a), Field::Get(b));
+        }
+        template <typename Field> static bool IsTextField() { return std::is_same<typename Field::Type, QString>::value; }
+    public:
+        enum { Count = sizeof...(Fields) };
+        // Column of Field, a constant expression
+        template <typename Field> struct Column {
+            enum { Value = FieldIndex<Field, Fields...>::Value };
+        };
+
+        static const char* NameOf(int p_column) {
+            static const char* const names[] = { Fields::Key()... };
+            return names[p_column];
+        }
+        // -1 for an unknown name
+        static int ColumnOf(const QString& p_name) {
+            for (int column = 0; column < Count; column++)
+                if (p_name == QLatin1String(NameOf(column))) return column;
+            return -1;
+        }
+        static QStringList Names() {
+            QStringList names;
+            for (int column = 0; column < Count; column++) names.append(QLatin1String(NameOf(column)));
+            return names;
+        }
+        static bool IsText(int p_column) {
+            static const bool texts[] = { IsTextField<Fields>()... };
+            return texts[p_column];
+        }
+
+        static QVariant Read(const SpaceRecord& p_record, int p_column) {
+            static QVariant (*const readers[])(const SpaceRecord&) = { &ReadField<Fields>... };
+            return readers[p_column](p_record);
+        }
+        // Numeric columns as double, text columns as 0, without a QVariant
+        static double NumberOf(const SpaceRecord& p_record, int p_column) {
+            static double (*const readers[])(const SpaceRecord&) = { &NumberField<Fields>... };
+            return readers[p_column](p_record);
+        }
+        // Text column order, case-insensitive, shared by queries and list models
+        static int CompareText(const QString& a, const QString& b) { return QString::compare(a, b, Qt::CaseInsensitive); }
+        // Typed three-way comparison of one column, text by CompareText
+        static int Compare(const SpaceRecord& a, const SpaceRecord& b, int p_column) {
+            static int (*const comparers[])(const SpaceRecord&, const SpaceRecord&) = { &CompareField<Fields>... };
+            return comparers[p_column](a, b);
+        }
+
+        static QVariantMap ToVariantMap(const SpaceRecord& p_record) {
+            QVariantMap map;
+            for (int column = 0; column < Count; column++) map.insert(QLatin1String(NameOf(column)), Read(p_record, column));
+            return map;
+        }
+        static QVariantList ToVariantList(const SpaceRecord& p_record) {
+            QVariantList values;
+            values.reserve(Count);
+            for (int column = 0; column < Count; column++) values.append(Read(p_record, column));
+            return values;
+        }
+    };
+
+    typedef RecordColumns<
+        fields::ID,
+        fields::Name,
+        fields::Area,
+        fields::NumberOfPeople,
+        fields::NumberOfSeats,
+        fields::DirhamsPerHour,
+        fields::Score,
+        fields::NumberOfReviews,
+        fields::Flags,
+        fields::Outdoor,
+        fields::Catering,
+        fields::Tags,
+        fields::Rank
+    > RecordSchema;
+
+    // Column a query sorts by, ID when unsorted
+    inline int SortColumnOf(SpaceQuery::SortKey p_key) {
+        switch (p_key) {
+        case SpaceQuery::ByName: return RecordSchema::Column<fields::Name>::Value;
+        case SpaceQuery::ByArea: return RecordSchema::Column<fields::Area>::Value;
+        case SpaceQuery::ByPrice: return RecordSchema::Column<fields::DirhamsPerHour>::Value;
+        case SpaceQuery::ByScore: return RecordSchema::Column<fields::Score>::Value;
+        case SpaceQuery::ByRank: return RecordSchema::Column<fields::Rank>::Value;
+        default: return RecordSchema::Column<fields::ID>::Value;
+        }
+    }
+}
+
+#endif // RECORDSCHEMA_H
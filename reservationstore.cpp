@@ -0,0 +1,304 @@
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QMutexLocker>
+
+// User libraries
+#include "reservationstore.h"
+#include "metrics.h"
+#include <cmath>
+
+namespace space {
+    // View
+    unsigned long long ReservationView::Word(int p_word) const {
+        if (p_word < 0 || p_word >= version->words) return 0;
+        return version->pages[p_word / ReservationPage::Words]->words[p_word % ReservationPage::Words];
+    }
+    long ReservationView::HourOf(const time_t& p_time) const {
+        return (long)std::floor(std::difftime(p_time, originTime) / (60 * 60));
+    }
+    unsigned int ReservationView::CountBooked(unsigned long p_startHour, unsigned long p_endHour) const {
+        if (p_endHour < p_startHour || p_startHour / 64 >= (unsigned long)version->words) return 0;
+        const unsigned long lastHour = (unsigned long)version->words * 64 - 1;
+        if (p_endHour > lastHour) p_endHour = lastHour;
+        const int startWord = p_startHour / 64, endWord = p_endHour / 64;
+        if (startWord == endWord)
+            return qPopulationCount((quint64)(Word(startWord) & Time::WordMask(p_startHour % 64, p_endHour % 64)));
+        unsigned int booked = qPopulationCount((quint64)(Word(startWord) & Time::WordMask(p_startHour % 64, 63)))
+                            + qPopulationCount((quint64)(Word(endWord) & Time::WordMask(0, p_endHour % 64)));
+        // .. Inner words, whole pages by their count
+        for (int j = startWord + 1; j < endWord;) {
+            if (j % ReservationPage::Words == 0 && j + ReservationPage::Words <= endWord) {
+                booked += version->pages[j / ReservationPage::Words]->booked;
+                j += ReservationPage::Words;
+            } else {
+                booked += qPopulationCount((quint64)Word(j++));
+            }
+        }
+        return booked;
+    }
+    unsigned int ReservationView::CountBookedBetween(const time_t& p_from, const time_t& p_to) const {
+        const long startHour = qMax(HourOf(p_from), 0L), endHour = HourOf(p_to - 1);
+        if (p_to <= p_from || endHour < startHour) return 0;
+        return CountBooked(startHour, endHour);
+    }
+    unsigned int ReservationView::CountBookable(const time_t& p_from, const time_t& p_to) const {
+        const long startHour = qMax(HourOf(p_from), 0L), endHour = HourOf(p_to - 1);
+        if (p_to <= p_from || endHour < startHour) return 0;
+        return endHour - startHour + 1;
+    }
+    bool ReservationView::IsFree(const time_t& p_from, const time_t& p_to) const {
+        return CountBookedBetween(p_from, p_to) == 0;
+    }
+
+    // Layout
+    ReservationLayout::~ReservationLayout() {
+        for (Chain* chain: chains) {
+            ReservationVersion* version = chain->head.load();
+            while (version) {
+                ReservationVersion* older = version->older.load();
+                delete version;
+                version = older;
+            }
+            delete chain;
+        }
+    }
+
+    // Snapshot
+    ReservationSnapshot::ReservationSnapshot(const ReservationSnapshot& p_other)
+        : store(p_other.store), layout(p_other.layout), epoch(p_other.epoch) {
+        // .. Already pinned by p_other, cannot be collected under us
+        if (!store) return;
+        QMutexLocker locker(&store->pinLock);
+        store->pins[epoch]++;
+    }
+    ReservationSnapshot::~ReservationSnapshot() {
+        if (store) store->Release(epoch);
+    }
+    ReservationView ReservationSnapshot::At(int p_index) const {
+        const ReservationLayout::Chain* chain = layout->chains[p_index];
+        // Newest version at or before the epoch, the collector keeps it while we pin
+        const ReservationVersion* version = chain->head.loadAcquire();
+        while (version->epoch > epoch) version = version->older.loadAcquire();
+        return ReservationView(version, chain->originTime);
+    }
+
+    // Store
+    ReservationStore::ReservationStore(SpaceManager* p_manager, QObject* parent) : QObject(parent) {
+        manager = p_manager;
+        connect(manager, &SpaceManager::SpacesChanged, this, &ReservationStore::Rebuild);
+        Rebuild();
+    }
+    ReservationStore::~ReservationStore() {
+        // No snapshot may outlive the store
+        Untrack();
+        delete current.loadAcquire();
+        for (ReservationLayout* layout: retired) delete layout;
+    }
+    ReservationSnapshot ReservationStore::Open() const {
+        // The epoch and layout are read together, a Rebuild swaps both under the same lock
+        QMutexLocker locker(&pinLock);
+        const quint64 epoch = committed.loadAcquire();
+        pins[epoch]++;
+        return ReservationSnapshot(this, current.loadAcquire(), epoch);
+    }
+    void ReservationStore::Release(quint64 p_epoch) const {
+        QMutexLocker locker(&pinLock);
+        QMap<quint64, int>::iterator pin = pins.find(p_epoch);
+        if (--pin.value() == 0) pins.erase(pin);
+    }
+    quint64 ReservationStore::Floor() const {
+        // .. Snapshots opened after this return pin the committed epoch or a later one
+        QMutexLocker locker(&pinLock);
+        return pins.isEmpty() ? committed.loadAcquire() : pins.firstKey();
+    }
+
+    ReservationPage* ReservationStore::CopyPage(const QVector<unsigned long long>& p_words, int p_page) {
+        ReservationPage* page = new ReservationPage();
+        const int begin = p_page * ReservationPage::Words;
+        const int end = qMin(begin + (int)ReservationPage::Words, p_words.size());
+        for (int j = begin; j < end; j++) {
+            page->words[j - begin] = p_words[j];
+            page->booked += qPopulationCount((quint64)p_words[j]);
+        }
+        return page;
+    }
+    ReservationVersion* ReservationStore::FromSpace(const Space& p_space, quint64 p_epoch) {
+        const Time& timer = p_space.GetTimer();
+        const QVector<unsigned long long>& words = timer.GetWords();
+        ReservationVersion* version = new ReservationVersion();
+        version->epoch = p_epoch;
+        version->ID = p_space.GetID();
+        version->dirhamsPerHour = timer.GetDirhamsPerHour();
+        version->words = words.size();
+        const int pages = (words.size() + ReservationPage::Words - 1) / ReservationPage::Words;
+        version->pages.reserve(pages);
+        for (int p = 0; p < pages; p++) version->pages.append(QSharedPointer<const ReservationPage>(CopyPage(words, p)));
+        return version;
+    }
+
+    void ReservationStore::Track() {
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        tracked.reserve(spaces.size());
+        for (int i = 0; i < spaces.size(); i++) {
+            space::Space* space_ptr = spaces[i];
+            tracked.append(space_ptr);
+            // Everything a ReservationVersion reads
+            connect(&space_ptr->GetTimer(), &Time::WordsChanged, this, [this, i](int p_first, int p_last) {
+                Touch(i, p_first, p_last);
+            });
+            connect(&space_ptr->GetTimer(), &Time::DirhamsPerHourChanged, this, [this, i]() { Touch(i, -1, -1); });
+            connect(space_ptr, &Space::IDChanged, this, [this, i]() { Touch(i, -1, -1); });
+        }
+    }
+    void ReservationStore::Untrack() {
+        for (const QPointer<space::Space>& space_ptr: tracked) {
+            // .. Deleted spaces are disconnected already
+            if (!space_ptr) continue;
+            disconnect(space_ptr, nullptr, this, nullptr);
+            disconnect(&space_ptr->GetTimer(), nullptr, this, nullptr);
+        }
+        tracked.clear();
+    }
+    void ReservationStore::Touch(int p_index, int p_first, int p_last) {
+        Pending& touched = pending[p_index];
+        if (p_first >= 0) {
+            touched.first = touched.first < 0 ? p_first : qMin(touched.first, p_first);
+            touched.last = qMax(touched.last, p_last);
+        }
+        if (touched.queued) return;
+        touched.queued = true;
+        dirty.append(p_index);
+        // Coalesce the bookings of one tick into one epoch
+        if (!commitQueued) {
+            commitQueued = true;
+            QTimer::singleShot(0, this, &ReservationStore::Commit);
+        }
+    }
+
+    void ReservationStore::Rebuild() {
+        QMutexLocker locker(&writeLock);
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        const quint64 epoch = committed.load() + 1;
+        ReservationLayout* layout = new ReservationLayout();
+        layout->epoch = epoch;
+        layout->chains.reserve(spaces.size());
+        for (space::Space* space_ptr: spaces) {
+            ReservationLayout::Chain* chain = new ReservationLayout::Chain();
+            chain->originTime = space_ptr->GetTimer().GetOriginTime();
+            chain->head.store(FromSpace(*space_ptr, epoch));
+            layout->chains.append(chain);
+        }
+        // Old spaces may be gone, start tracking from scratch
+        Untrack();
+        pending.fill(Pending(), spaces.size());
+        dirty.clear();
+        versioned.clear();
+        isVersioned.fill(false, spaces.size());
+        Track();
+        {
+            QMutexLocker pinned(&pinLock);
+            ReservationLayout* previous = current.load();
+            current.storeRelease(layout);
+            committed.storeRelease(epoch);
+            if (previous) {
+                previous->retiredAt = epoch;
+                retired.append(previous);
+            }
+        }
+        locker.unlock();
+        Collect();
+        emit Committed(epoch);
+    }
+    void ReservationStore::Commit() {
+        QMutexLocker locker(&writeLock);
+        commitQueued = false;
+        if (dirty.isEmpty()) return;
+        EVIES_TIME_SCOPE(ReservationCommitTimer);
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        ReservationLayout* layout = current.load();
+        const quint64 epoch = committed.load() + 1;
+        for (int index: dirty) {
+            Pending& touched = pending[index];
+            ReservationLayout::Chain* chain = layout->chains[index];
+            ReservationVersion* previous = chain->head.load();
+            const Time& timer = spaces[index]->GetTimer();
+            const QVector<unsigned long long>& words = timer.GetWords();
+            ReservationVersion* next = new ReservationVersion();
+            next->epoch = epoch;
+            next->ID = spaces[index]->GetID();
+            next->dirhamsPerHour = timer.GetDirhamsPerHour();
+            next->words = words.size();
+            // Copy-on-write: share every page, then replace the touched ones
+            // .. and every page from the old end on if the bitmap grew or shrank
+            const int pages = (words.size() + ReservationPage::Words - 1) / ReservationPage::Words;
+            next->pages = previous->pages;
+            next->pages.resize(pages);
+            int first = touched.first < 0 ? pages : touched.first / ReservationPage::Words;
+            int last = touched.last < 0 ? -1 : qMin(touched.last / (int)ReservationPage::Words, pages - 1);
+            if (words.size() != previous->words) {
+                first = qMin(first, qMin(words.size(), previous->words) / ReservationPage::Words);
+                last = pages - 1;
+            }
+            for (int p = first; p <= last; p++) next->pages[p].reset(CopyPage(words, p));
+            next->older.store(previous);
+            chain->head.storeRelease(next);
+            touched = Pending();
+            if (!isVersioned[index]) {
+                isVersioned[index] = true;
+                versioned.append(index);
+            }
+        }
+        dirty.clear();
+        // .. Snapshots opened from here on see every head above
+        committed.storeRelease(epoch);
+        if (!collectQueued) {
+            collectQueued = true;
+            QTimer::singleShot(0, this, &ReservationStore::Collect);
+        }
+        locker.unlock();
+        emit Committed(epoch);
+    }
+    void ReservationStore::Collect() {
+        QMutexLocker locker(&writeLock);
+        collectQueued = false;
+        const quint64 floor = Floor();
+        ReservationLayout* layout = current.load();
+        for (int i = versioned.size() - 1; i >= 0; i--) {
+            const int index = versioned[i];
+            ReservationLayout::Chain* chain = layout->chains[index];
+            // Keep the newest version at or before the floor, and everything above it
+            ReservationVersion* keep = chain->head.load();
+            while (keep->epoch > floor && keep->older.load()) keep = keep->older.load();
+            ReservationVersion* garbage = keep->older.fetchAndStoreOrdered(nullptr);
+            while (garbage) {
+                ReservationVersion* older = garbage->older.load();
+                delete garbage;
+                garbage = older;
+            }
+            if (!chain->head.load()->older.load()) {
+                isVersioned[index] = false;
+                versioned[i] = versioned.last();
+                versioned.removeLast();
+            }
+        }
+        for (int i = retired.size() - 1; i >= 0; i--) {
+            if (retired[i]->retiredAt <= floor) {
+                delete retired[i];
+                retired.remove(i);
+            }
+        }
+        // Snapshots still hold old versions, retry later
+        if ((!versioned.isEmpty() || !retired.isEmpty()) && !collectQueued) {
+            collectQueued = true;
+            QTimer::singleShot(100, this, &ReservationStore::Collect);
+        }
+    }
+    int ReservationStore::GetNumberOfVersions() const {
+        int count = 0;
+        const ReservationLayout* layout = current.loadAcquire();
+        for (const ReservationLayout::Chain* chain: layout->chains)
+            for (const ReservationVersion* version = chain->head.load(); version; version = version->older.load()) count++;
+        return count;
+    }
+}
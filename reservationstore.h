@@ -0,0 +1,178 @@
+#ifndef RESERVATIONSTORE_H
+#define RESERVATIONSTORE_H
+
+#include <QObject>
+#include <QVector>
+#include <QMap>
+#include <QSharedPointer>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QPointer>
+
+// User libraries
+#include "space.h"
+#include <ctime>
+#include <utility>
+
+namespace space {
+    // Fixed-size run of bitmap words, shared between versions until a commit touches it
+    struct ReservationPage {
+        enum { Words = 16 };
+        unsigned long long words[Words];
+        // Booked hours in the page, whole pages are counted without reading their words
+        unsigned int booked;
+    };
+
+    // Reservation state of one space as of one commit epoch
+    // .. Versions of a space are chained newest first, the collector cuts the tail
+    struct ReservationVersion {
+        quint64 epoch = 0;
+        unsigned int ID = 0;
+        double dirhamsPerHour = 0;
+        int words = 0;
+        QVector<QSharedPointer<const ReservationPage>> pages;
+        QAtomicPointer<ReservationVersion> older;
+    };
+
+    // Read-only view of one space in a snapshot, cheap to copy
+    // .. Same hour arithmetic as the live Time, O(pages) per count instead of O(log n)
+    class ReservationView {
+        friend class ReservationSnapshot;
+    public:
+        bool IsNull() const { return version == nullptr; }
+        unsigned int GetID() const { return version->ID; }
+        double GetDirhamsPerHour() const { return version->dirhamsPerHour; }
+        time_t GetOriginTime() const { return originTime; }
+        int GetNumberOfWords() const { return version->words; }
+        unsigned long long Word(int p_word) const;
+
+        long HourOf(const time_t& p_time) const;
+        // Hours are inclusive on both ends, as in Time::CountBooked
+        unsigned int CountBooked(unsigned long p_startHour, unsigned long p_endHour) const;
+        unsigned int CountBookedBetween(const time_t& p_from, const time_t& p_to) const;
+        unsigned int CountBookable(const time_t& p_from, const time_t& p_to) const;
+        bool IsFree(const time_t& p_from, const time_t& p_to) const;
+    private:
+        ReservationView(const ReservationVersion* p_version, time_t p_originTime) : version(p_version), originTime(p_originTime) {}
+        const ReservationVersion* version;
+        time_t originTime;
+    };
+
+    // Spaces of the store at one layout, the version chains live as long as it does
+    struct ReservationLayout {
+        struct Chain {
+            time_t originTime = 0;
+            QAtomicPointer<ReservationVersion> head;
+        };
+        // First epoch seen through this layout, and the epoch of the one replacing it
+        quint64 epoch = 0, retiredAt = 0;
+        QVector<Chain*> chains;
+        ~ReservationLayout();
+    };
+
+    class ReservationStore;
+
+    // Point-in-time reader handle over every space
+    // .. Versions committed after the epoch stay invisible, the ones it sees stay alive
+    // .. Any thread, reads never lock; opening and closing touch a short pin mutex
+    class ReservationSnapshot {
+        friend class ReservationStore;
+    public:
+        ReservationSnapshot() : store(nullptr), layout(nullptr), epoch(0) {}
+        ReservationSnapshot(const ReservationSnapshot& p_other);
+        ReservationSnapshot(ReservationSnapshot&& p_other) : store(p_other.store), layout(p_other.layout), epoch(p_other.epoch) {
+            p_other.store = nullptr;
+            p_other.layout = nullptr;
+        }
+        ReservationSnapshot& operator=(ReservationSnapshot p_other) {
+            std::swap(store, p_other.store);
+            std::swap(layout, p_other.layout);
+            std::swap(epoch, p_other.epoch);
+            return *this;
+        }
+        ~ReservationSnapshot();
+
+        bool IsNull() const { return layout == nullptr; }
+        quint64 GetEpoch() const { return epoch; }
+        // Same indexes as the manager's spaces when the snapshot was opened
+        int GetSize() const { return layout ? layout->chains.size() : 0; }
+        ReservationView At(int p_index) const;
+    private:
+        // Takes over a pin already counted by the store
+        ReservationSnapshot(const ReservationStore* p_store, const ReservationLayout* p_layout, quint64 p_epoch)
+            : store(p_store), layout(p_layout), epoch(p_epoch) {}
+        const ReservationStore* store;
+        const ReservationLayout* layout;
+        quint64 epoch;
+    };
+
+    // Multi-version reservation state of a SpaceManager's spaces (MVCC)
+    // .. Bitmaps are split into pages of ReservationPage::Words words; a commit copies the
+    // .. pages its bookings touched, shares the rest, and prepends a version to each changed
+    // .. space under one global epoch
+    // .. Bookings gathered during an event-loop tick commit together, so a group booking over
+    // .. several spaces is seen whole or not at all
+    // .. Readers open a snapshot at the committed epoch and scan it without locks while
+    // .. bookings keep committing; versions no snapshot can reach are freed by the writer side
+    class ReservationStore : public QObject {
+        Q_OBJECT
+        friend class ReservationSnapshot;
+    signals:
+        void Committed(quint64 epoch);
+    private:
+        // Touched words of a space since the last commit, -1 when only the price or ID changed
+        struct Pending {
+            int first = -1, last = -1;
+            bool queued = false;
+        };
+        SpaceManager* manager;
+        QAtomicPointer<ReservationLayout> current;
+        QAtomicInteger<quint64> committed;
+        // Epochs pinned by open snapshots, with their count
+        // .. Also orders opening against layout swaps and collection
+        mutable QMutex pinLock;
+        mutable QMap<quint64, int> pins;
+        QVector<ReservationLayout*> retired;
+        // Spaces whose signals feed Touch
+        QVector<QPointer<space::Space>> tracked;
+        // Indexes of the current layout with versions older than their head
+        QVector<int> versioned;
+        QVector<bool> isVersioned;
+        // Serializes writers, never taken by readers
+        QMutex writeLock;
+        QVector<Pending> pending;
+        QVector<int> dirty;
+        bool commitQueued = false;
+        bool collectQueued = false;
+
+        static ReservationPage* CopyPage(const QVector<unsigned long long>& p_words, int p_page);
+        static ReservationVersion* FromSpace(const Space& p_space, quint64 p_epoch);
+        void Track();
+        void Untrack();
+        void Touch(int p_index, int p_first, int p_last);
+        // Oldest epoch a snapshot may still read, the committed one if none is open
+        quint64 Floor() const;
+        void Release(quint64 p_epoch) const;
+    public:
+        explicit ReservationStore(SpaceManager* p_manager, QObject* parent = nullptr);
+        virtual ~ReservationStore();
+
+        // Readers, any thread
+        ReservationSnapshot Open() const;
+        quint64 GetEpoch() const { return committed.loadAcquire(); }
+
+        // Writers
+        // .. Rebuild after the manager replaces its spaces, snapshots opened before keep the old ones
+        // .. Commit publishes the bookings gathered so far, queued automatically once per tick
+        void Rebuild();
+        void Commit();
+        // Free versions and layouts no open snapshot can reach
+        void Collect();
+        // Versions in the current layout, writer side
+        int GetNumberOfVersions() const;
+        int GetRetiredCount() const { return retired.size(); }
+    };
+}
+
+#endif // RESERVATIONSTORE_H
@@ -0,0 +1,335 @@
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QPair>
+
+// User libraries
+#include "searchindex.h"
+#include "metrics.h"
+#include <algorithm>
+
+namespace space {
+    // Matches inside words stop after this many terms, a text found in most
+    // .. names is too unselective to rank within a keystroke
+    static const int infixCandidates = 4096;
+
+    static quint64 TrigramAt(const QVector<ushort>& p_text, int p_at) {
+        return ((quint64)p_text[p_at] << 32) | ((quint64)p_text[p_at + 1] << 16) | p_text[p_at + 2];
+    }
+
+    SearchIndex::SearchIndex(CatalogStore* p_catalog, QObject* parent) : QObject(parent) {
+        catalog = p_catalog;
+        connect(catalog, &CatalogStore::Rebuilt, this, &SearchIndex::Reload);
+        connect(catalog, &CatalogStore::RecordsChanged, this, [this](quint64, const QVector<int>& p_indexes) { Update(p_indexes); });
+        Reload();
+    }
+
+    // Terms
+    QVector<ushort> SearchIndex::Fold(const QString& p_text) {
+        // .. Lower case, words separated by single spaces, '#' kept for tags
+        QVector<ushort> folded;
+        folded.reserve(p_text.size());
+        for (int i = 0; i < p_text.size(); i++) {
+            const QChar character = p_text.at(i);
+            if (character.isLetterOrNumber() || character == QChar('#')) folded.append(character.toLower().unicode());
+            else if (!folded.isEmpty() && folded.last() != ' ') folded.append(' ');
+        }
+        if (!folded.isEmpty() && folded.last() == ' ') folded.removeLast();
+        return folded;
+    }
+    QVector<QVector<ushort>> SearchIndex::TermsOf(const SpaceRecord& p_record) {
+        QVector<QVector<ushort>> terms;
+        auto add = [&terms](const QVector<ushort>& p_term) {
+            if (!p_term.isEmpty() && !terms.contains(p_term)) terms.append(p_term);
+        };
+        const QVector<ushort> name = Fold(p_record.name);
+        QVector<ushort> word;
+        for (ushort character: name) {
+            if (character != ' ') {
+                word.append(character);
+            } else {
+                add(word);
+                word.clear();
+            }
+        }
+        // .. The whole name too, so "nyuad at" completes "NYUAD Atrium"
+        if (!terms.isEmpty()) add(name);
+        add(word);
+        const QVector<ushort> tags = Fold(p_record.GetTags());
+        word.clear();
+        for (ushort character: tags) {
+            if (character != ' ') {
+                word.append(character);
+            } else {
+                add(word);
+                word.clear();
+            }
+        }
+        add(word);
+        return terms;
+    }
+
+    // Trie
+    int SearchIndex::Child(int p_node, ushort p_character) const {
+        for (int child = nodes[p_node].firstChild; child >= 0; child = nodes[child].nextSibling)
+            if (nodes[child].character == p_character) return child;
+        return -1;
+    }
+    int SearchIndex::Insert(const QVector<ushort>& p_term) {
+        int node = 0;
+        for (ushort character: p_term) {
+            int child = Child(node, character);
+            if (child < 0) {
+                child = nodes.size();
+                Node added;
+                added.parent = node;
+                added.character = character;
+                added.nextSibling = nodes[node].firstChild;
+                nodes.append(added);
+                nodes[node].firstChild = child;
+            }
+            node = child;
+        }
+        return node;
+    }
+    int SearchIndex::Find(const QVector<ushort>& p_text) const {
+        int node = 0;
+        for (int i = 0; i < p_text.size() && node >= 0; i++) node = Child(node, p_text[i]);
+        return node;
+    }
+    void SearchIndex::TermOf(int p_node, QVector<ushort>& p_term) const {
+        p_term.clear();
+        for (int node = p_node; node > 0; node = nodes[node].parent) p_term.append(nodes[node].character);
+        std::reverse(p_term.begin(), p_term.end());
+    }
+    int SearchIndex::Term(const QVector<ushort>& p_term) {
+        const int node = Insert(p_term);
+        // .. A node joins the trigram lists once, the first time a term ends on it
+        if (!nodes[node].trigrams) {
+            nodes[node].trigrams = true;
+            for (int i = 0; i + 3 <= p_term.size(); i++) {
+                QVector<int>& holders = trigrams[TrigramAt(p_term, i)];
+                QVector<int>::iterator at = std::lower_bound(holders.begin(), holders.end(), node);
+                if (at == holders.end() || *at != node) holders.insert(at, node);
+            }
+        }
+        return node;
+    }
+    void SearchIndex::Link(int p_index, int p_node) {
+        QVector<int>& spaces = nodes[p_node].spaces;
+        spaces.insert(std::lower_bound(spaces.begin(), spaces.end(), p_index), p_index);
+        for (int up = p_node; up >= 0; up = nodes[up].parent) nodes[up].count++;
+    }
+    void SearchIndex::Unlink(int p_index, int p_node) {
+        // .. Emptied nodes stay in the trie and the trigram lists, they no longer match
+        QVector<int>& spaces = nodes[p_node].spaces;
+        spaces.erase(std::lower_bound(spaces.begin(), spaces.end(), p_index));
+        for (int up = p_node; up >= 0; up = nodes[up].parent) nodes[up].count--;
+    }
+    void SearchIndex::Index(int p_index, const SpaceRecord& p_record) {
+        scores[p_index] = p_record.GetRank();
+        popularity[p_index] = p_record.numberOfReviews;
+        QVector<int> next;
+        for (const QVector<ushort>& term: TermsOf(p_record)) next.append(Term(term));
+        // Only the terms that came or went touch the node lists, a tag shared by most spaces
+        // .. is not rewritten for a rename
+        const QVector<int>& previous = terms[p_index];
+        for (int node: previous) {
+            if (next.contains(node)) continue;
+            Unlink(p_index, node);
+            Invalidate(node);
+        }
+        for (int node: next) {
+            if (!previous.contains(node)) Link(p_index, node);
+            // .. Its rank may have moved within every list it is on
+            Invalidate(node);
+        }
+        terms[p_index] = next;
+    }
+    void SearchIndex::Invalidate(int p_node) {
+        if (best[ByScore].isEmpty() && best[ByPopularity].isEmpty()) return;
+        for (int up = p_node; up >= 0; up = nodes[up].parent) {
+            best[ByScore].remove(up);
+            best[ByPopularity].remove(up);
+        }
+    }
+
+    // Ranking
+    bool SearchIndex::Before(int a, int b, Order p_order) const {
+        if (p_order == ByPopularity && popularity[a] != popularity[b]) return popularity[a] > popularity[b];
+        if (scores[a] != scores[b]) return scores[a] > scores[b];
+        if (popularity[a] != popularity[b]) return popularity[a] > popularity[b];
+        return a < b;
+    }
+    template <typename Before> static QVector<int> Rank(QVector<int> p_spaces, int p_limit, Before p_before) {
+        // .. A space reached through several terms counts once
+        std::sort(p_spaces.begin(), p_spaces.end());
+        p_spaces.erase(std::unique(p_spaces.begin(), p_spaces.end()), p_spaces.end());
+        const int kept = qMin(p_limit, p_spaces.size());
+        std::partial_sort(p_spaces.begin(), p_spaces.begin() + kept, p_spaces.end(), p_before);
+        p_spaces.resize(kept);
+        return p_spaces;
+    }
+    QVector<int> SearchIndex::Best(int p_node, Order p_order) const {
+        auto before = [this, p_order](int a, int b) { return Before(a, b, p_order); };
+        QVector<int> spaces;
+        // Small subtrees are walked, large ones merge the best of their children
+        // .. The best of a union is within the union of each part's best
+        if (nodes[p_node].count < CacheThreshold) {
+            Collect(p_node, spaces);
+            return Rank(spaces, MaxResults, before);
+        }
+        QHash<int, QVector<int>>::const_iterator cached = best[p_order].constFind(p_node);
+        if (cached != best[p_order].constEnd()) return *cached;
+        spaces = nodes[p_node].spaces;
+        for (int child = nodes[p_node].firstChild; child >= 0; child = nodes[child].nextSibling)
+            if (nodes[child].count > 0) spaces += Best(child, p_order);
+        spaces = Rank(spaces, MaxResults, before);
+        best[p_order].insert(p_node, spaces);
+        return spaces;
+    }
+    void SearchIndex::Collect(int p_node, QVector<int>& p_spaces) const {
+        QVector<int> stack(1, p_node);
+        while (!stack.isEmpty()) {
+            const int node = stack.last();
+            stack.removeLast();
+            p_spaces += nodes[node].spaces;
+            for (int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+                if (nodes[child].count > 0) stack.append(child);
+        }
+    }
+
+    // Matching
+    void SearchIndex::Fuzzy(const QVector<ushort>& p_text, int p_maxEdits, QVector<int>& p_nodes) const {
+        // Edit distance between the text and each trie path, one row per depth (Damerau, adjacent swaps cost one)
+        // .. Depth-first, so the rows of a node's ancestors are still in place when it is reached
+        // .. The first character is taken as typed, which keeps the walk to one branch of the root
+        // .. A path within p_maxEdits matches with its whole subtree, deeper paths are not walked
+        // .. A row whose every cell is past p_maxEdits cannot come back, its subtree is skipped
+        const int first = Child(0, p_text[0]);
+        if (first < 0 || nodes[first].count == 0) return;
+        const int width = p_text.size() + 1;
+        QVector<int> rows(width * 16);
+        for (int j = 0; j < width; j++) rows[j] = j;
+        QVector<QPair<int, int>> stack;
+        stack.append(qMakePair(first, 1));
+        while (!stack.isEmpty()) {
+            const int node = stack.last().first, depth = stack.last().second;
+            stack.removeLast();
+            if (rows.size() < (depth + 1) * width) rows.resize(rows.size() * 2);
+            const ushort character = nodes[node].character, parentCharacter = nodes[nodes[node].parent].character;
+            const int* above = rows.constData() + (depth - 1) * width;
+            const int* twoAbove = depth >= 2 ? above - width : nullptr;
+            int* row = rows.data() + depth * width;
+            row[0] = depth;
+            int lowest = depth;
+            for (int j = 1; j < width; j++) {
+                row[j] = qMin(qMin(above[j] + 1, row[j - 1] + 1), above[j - 1] + (p_text[j - 1] != character));
+                if (twoAbove && j > 1 && p_text[j - 1] == parentCharacter && p_text[j - 2] == character)
+                    row[j] = qMin(row[j], twoAbove[j - 2] + 1);
+                lowest = qMin(lowest, row[j]);
+            }
+            if (row[width - 1] <= p_maxEdits) {
+                p_nodes.append(node);
+                continue;
+            }
+            if (lowest > p_maxEdits) continue;
+            for (int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+                if (nodes[child].count > 0) stack.append(qMakePair(child, depth + 1));
+        }
+    }
+    void SearchIndex::Infix(const QVector<ushort>& p_text, QVector<int>& p_nodes) const {
+        // Terms on the rarest trigram of the text, checked for the whole text
+        // .. A missing trigram ends the search before any term is looked at
+        const QVector<int>* rarest = nullptr;
+        for (int i = 0; i + 3 <= p_text.size(); i++) {
+            QHash<quint64, QVector<int>>::const_iterator holders = trigrams.constFind(TrigramAt(p_text, i));
+            if (holders == trigrams.constEnd()) return;
+            if (!rarest || holders->size() < rarest->size()) rarest = &*holders;
+        }
+        QVector<ushort> term;
+        for (int node: *rarest) {
+            if (nodes[node].spaces.isEmpty()) continue;
+            TermOf(node, term);
+            if (std::search(term.begin(), term.end(), p_text.begin(), p_text.end()) == term.end()) continue;
+            p_nodes.append(node);
+            if (p_nodes.size() == infixCandidates) break;
+        }
+    }
+    QVector<SearchIndex::Match> SearchIndex::Complete(const QString& p_text, int p_limit, Order p_order) const {
+        EVIES_TIME_SCOPE(SearchCompleteTimer);
+        QVector<Match> matches;
+        const int limit = qMin(p_limit, (int)MaxResults);
+        const QVector<ushort> text = Fold(p_text);
+        if (limit <= 0 || text.isEmpty()) return matches;
+        auto before = [this, p_order](int a, int b) { return Before(a, b, p_order); };
+        auto take = [&matches, limit](const QVector<int>& p_spaces, MatchKind p_kind) {
+            for (int index: p_spaces) {
+                if (matches.size() == limit) return;
+                bool seen = false;
+                for (const Match& match: matches) seen |= match.index == index;
+                if (!seen) matches.append(Match{index, p_kind});
+            }
+        };
+
+        const int node = Find(text);
+        if (node >= 0 && nodes[node].count > 0) take(Best(node, p_order), PrefixMatch);
+        // .. One typo before two, the wider walk only runs if the narrow one fell short
+        const int maxEdits = text.size() >= TwoTyposLength ? 2 : text.size() >= OneTypoLength ? 1 : 0;
+        for (int edits = 1; edits <= maxEdits && matches.size() < limit; edits++) {
+            QVector<int> found;
+            Fuzzy(text, edits, found);
+            QVector<int> spaces;
+            for (int match: found) spaces += Best(match, p_order);
+            take(Rank(spaces, limit + matches.size(), before), FuzzyMatch);
+        }
+        if (matches.size() < limit && text.size() >= 3) {
+            QVector<int> found;
+            Infix(text, found);
+            QVector<int> spaces;
+            for (int match: found) spaces += nodes[match].spaces;
+            // .. Enough for the free slots after dropping the spaces already listed
+            take(Rank(spaces, limit + matches.size(), before), InfixMatch);
+        }
+        return matches;
+    }
+    QVariantList SearchIndex::Suggest(const QString& p_text, int p_limit, int p_order) const {
+        QVariantList summaries;
+        for (const Match& match: Complete(p_text, p_limit, p_order == ByPopularity ? ByPopularity : ByScore))
+            summaries.append(QVariant::fromValue(SpaceSummary::FromRecord(pin->At(match.index))));
+        return summaries;
+    }
+
+    // Catalog
+    void SearchIndex::Reload() {
+        pin = catalog->Pin();
+        const int size = pin->GetSize();
+        nodes.clear();
+        nodes.append(Node());
+        trigrams.clear();
+        best[ByScore].clear();
+        best[ByPopularity].clear();
+        terms.fill(QVector<int>(), size);
+        scores.fill(0, size);
+        popularity.fill(0, size);
+        for (int i = 0; i < size; i++) Index(i, pin->At(i));
+        // .. Every large node ranked now rather than on the first keystroke
+        Best(0, ByScore);
+        Best(0, ByPopularity);
+    }
+    void SearchIndex::Update(const QVector<int>& p_indexes) {
+        const CatalogPin previous = pin;
+        pin = catalog->Pin();
+        for (int index: p_indexes) {
+            if (index >= terms.size()) continue;
+            const SpaceRecord& before = previous->At(index);
+            const SpaceRecord& record = pin->At(index);
+            // .. Bookings change neither terms nor ranking
+            if (before.name == record.name && before.flags == record.flags
+                && before.GetRank() == record.GetRank() && before.numberOfReviews == record.numberOfReviews) continue;
+            Index(index, record);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QVariantList>
+
+// User libraries
+#include "catalogstore.h"
+#include "spacesummary.h"
+
+namespace space {
+    // Type-ahead over space names and tags
+    // .. Terms are the lower-cased words of each name, the whole name when it has several,
+    // .. and the "#tag" of each flag; they live in a character trie whose nodes count the
+    // .. terms below them, and in a trigram index for matches inside a word
+    // .. Nodes with many terms below keep their best MaxResults spaces per order, so a
+    // .. prefix is answered by walking its characters and reading one cached list
+    // .. A keystroke looks up, in turn: prefixes, prefixes within a few typos (Levenshtein
+    // .. rows along the trie, pruned past the limit) and words containing the text
+    // .. Follows a CatalogStore, a changed name, tag or score updates only its own terms
+    class SearchIndex : public QObject {
+        Q_OBJECT
+    public:
+        enum Order { ByScore, ByPopularity };
+        Q_ENUM(Order)
+        enum MatchKind { PrefixMatch, FuzzyMatch, InfixMatch };
+        enum {
+            MaxResults = 32,
+            // Nodes with at least this many terms below keep their best spaces
+            CacheThreshold = 64,
+            // Shortest text with one typo allowed, and with two
+            OneTypoLength = 4,
+            TwoTyposLength = 8
+        };
+        struct Match {
+            Match(int p_index = -1, MatchKind p_kind = PrefixMatch) : index(p_index), kind(p_kind) {}
+            // Catalog index
+            int index;
+            MatchKind kind;
+        };
+    private:
+        struct Node {
+            int parent = -1, firstChild = -1, nextSibling = -1;
+            ushort character = 0;
+            // Term endings in this subtree, one per (space, term)
+            int count = 0;
+            bool trigrams = false;
+            // Catalog indexes whose term ends here, ascending
+            QVector<int> spaces;
+        };
+        CatalogStore* catalog;
+        CatalogPin pin;
+        QVector<Node> nodes;
+        // Trigram of three folded characters to the term nodes holding it, ascending
+        QHash<quint64, QVector<int>> trigrams;
+        // Per catalog index: term nodes and ranking keys
+        QVector<QVector<int>> terms;
+        QVector<float> scores;
+        QVector<unsigned int> popularity;
+        // Best spaces of large nodes, per order, dropped along a term's path when it changes
+        mutable QHash<int, QVector<int>> best[2];
+
+        static QVector<ushort> Fold(const QString& p_text);
+        static QVector<QVector<ushort>> TermsOf(const SpaceRecord& p_record);
+        int Child(int p_node, ushort p_character) const;
+        int Insert(const QVector<ushort>& p_term);
+        int Find(const QVector<ushort>& p_text) const;
+        void TermOf(int p_node, QVector<ushort>& p_term) const;
+        // Trie node of p_term, added with its trigrams if new
+        int Term(const QVector<ushort>& p_term);
+        void Link(int p_index, int p_node);
+        void Unlink(int p_index, int p_node);
+        // Terms and ranking of p_index from p_record
+        void Index(int p_index, const SpaceRecord& p_record);
+        void Invalidate(int p_node);
+        bool Before(int a, int b, Order p_order) const;
+        // Best spaces below p_node, at most MaxResults, no repeats
+        QVector<int> Best(int p_node, Order p_order) const;
+        void Collect(int p_node, QVector<int>& p_spaces) const;
+        void Fuzzy(const QVector<ushort>& p_text, int p_maxEdits, QVector<int>& p_nodes) const;
+        void Infix(const QVector<ushort>& p_text, QVector<int>& p_nodes) const;
+
+        void Reload();
+        void Update(const QVector<int>& p_indexes);
+    public:
+        explicit SearchIndex(CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~SearchIndex() {}
+
+        // C++ side, best first, prefix matches before typos before infixes
+        QVector<Match> Complete(const QString& p_text, int p_limit = 10, Order p_order = ByScore) const;
+        // QML side, one SpaceSummary per match
+        Q_INVOKABLE QVariantList Suggest(const QString& p_text, int p_limit = 10, int p_order = ByScore) const;
+
+        int GetNumberOfNodes() const { return nodes.size(); }
+        int GetNumberOfTrigrams() const { return trigrams.size(); }
+    };
+}
+
+#endif // SEARCHINDEX_H
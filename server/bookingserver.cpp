@@ -0,0 +1,234 @@
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTimer>
+
+// User libraries
+#include "bookingserver.h"
+#include <ctime>
+
+namespace space {
+    // Constructors & destructors
+    BookingServer::BookingServer(SpaceManager* p_manager, CatalogStore* p_catalog, QObject* parent) : QObject(parent) {
+        manager = p_manager;
+        catalog = p_catalog;
+        connect(manager, &SpaceManager::SpacesChanged, this, &BookingServer::Reindex);
+        Reindex();
+        connect(&localServer, &QLocalServer::newConnection, this, [this]() {
+            while (QLocalSocket* socket = localServer.nextPendingConnection()) {
+                connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { Drop(connections.value(socket)); });
+                Accept(socket);
+            }
+        });
+        connect(&tcpServer, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket* socket = tcpServer.nextPendingConnection()) {
+                // Replies are already batched, do not wait for Nagle
+                socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+                connect(socket, &QAbstractSocket::disconnected, this, [this, socket]() { Drop(connections.value(socket)); });
+                Accept(socket);
+            }
+        });
+    }
+    BookingServer::~BookingServer() {
+        // .. Sockets are children of the servers
+        for (Connection* connection: connections) delete connection;
+    }
+
+    bool BookingServer::ListenLocal(const QString& p_name) {
+        // Clear a stale socket file left by a crashed daemon
+        QLocalServer::removeServer(p_name);
+        return localServer.listen(p_name);
+    }
+    bool BookingServer::ListenTcp(quint16 p_port) {
+        return tcpServer.listen(QHostAddress::LocalHost, p_port);
+    }
+
+    // Connections
+    void BookingServer::Accept(QIODevice* p_socket) {
+        Connection* connection = new Connection();
+        connection->socket = p_socket;
+        connections.insert(p_socket, connection);
+        // Bound what Qt buffers, unread requests then stay in the kernel and throttle the client
+        if (QLocalSocket* local = qobject_cast<QLocalSocket*>(p_socket)) local->setReadBufferSize(1 << 20);
+        if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(p_socket)) tcp->setReadBufferSize(1 << 20);
+        connect(p_socket, &QIODevice::readyRead, this, [this, connection]() { Serve(connection); });
+        connect(p_socket, &QIODevice::bytesWritten, this, [this, connection]() {
+            if (connection->paused && connection->socket->bytesToWrite() < lowWatermark) {
+                connection->paused = false;
+                Queue(connection);
+            }
+        });
+        Serve(connection);
+    }
+    void BookingServer::Queue(Connection* p_connection) {
+        if (p_connection->queued) return;
+        p_connection->queued = true;
+        // Look the connection up again, it may be gone by then
+        QIODevice* socket = p_connection->socket;
+        QTimer::singleShot(0, this, [this, socket]() {
+            Connection* connection = connections.value(socket);
+            if (!connection) return;
+            connection->queued = false;
+            Serve(connection);
+        });
+    }
+    void BookingServer::Drop(Connection* p_connection) {
+        if (!p_connection) return;
+        connections.remove(p_connection->socket);
+        // No more callbacks into the connection we are about to free
+        disconnect(p_connection->socket, nullptr, this, nullptr);
+        p_connection->socket->deleteLater();
+        delete p_connection;
+    }
+    int BookingServer::BufferLimit(const Connection* p_connection) {
+        return qMax(1 << 20, BookingProtocol::FrameSize(p_connection->buffer));
+    }
+    void BookingServer::Serve(Connection* p_connection) {
+        if (p_connection->paused) return;
+        // Keep at most about a megabyte of unparsed requests per connection,
+        // .. or all of a larger frame at the head, which could not complete otherwise
+        if (p_connection->buffer.size() < BufferLimit(p_connection))
+            p_connection->buffer.append(p_connection->socket->readAll());
+        QByteArray out;
+        int offset = 0, frames = 0;
+        quint32 requestID;
+        quint8 code;
+        QByteArray payload;
+        bool error = false;
+        while (frames < framesPerPass
+               && BookingProtocol::TakeFrame(p_connection->buffer, offset, requestID, code, payload, error)) {
+            BookingWriter reply;
+            const quint8 status = Handle(code, payload, reply);
+            BookingProtocol::AppendFrame(out, requestID, status, reply.GetData());
+            frames++;
+        }
+        p_connection->buffer.remove(0, offset);
+        requestCount += frames;
+        // One write for the whole batch
+        if (!out.isEmpty()) p_connection->socket->write(out);
+        if (error) {
+            // Framing is lost, nothing after this point can be trusted
+            p_connection->socket->close();
+            return;
+        }
+        if (p_connection->socket->bytesToWrite() > highWatermark) {
+            p_connection->paused = true;
+            return;
+        }
+        // A full pass may have left work behind, yield to the other connections first
+        if (frames == framesPerPass || (p_connection->socket->bytesAvailable() > 0 && p_connection->buffer.size() < BufferLimit(p_connection)))
+            Queue(p_connection);
+    }
+
+    // Requests
+    void BookingServer::Reindex() {
+        indexOfID.clear();
+        const QVector<space::Space*>& spaces = manager->GetSpaces();
+        indexOfID.reserve(spaces.size());
+        for (int i = 0; i < spaces.size(); i++) indexOfID.insert(spaces[i]->GetID(), i);
+    }
+    Space* BookingServer::Find(unsigned int p_ID) const {
+        QHash<unsigned int, int>::const_iterator it = indexOfID.constFind(p_ID);
+        return it == indexOfID.constEnd() ? nullptr : manager->GetSpaces()[it.value()];
+    }
+    quint8 BookingServer::BookOne(unsigned int p_ID, qint64 p_start, qint64 p_end, double& p_price) {
+        p_price = 0;
+        Space* space_ptr = Find(p_ID);
+        if (!space_ptr) return BookingProtocol::NotFound;
+        Time& timer = space_ptr->GetTimer();
+        const time_t startTime = (time_t)p_start, endTime = (time_t)p_end;
+        if (!Time::IsBookable(timer.HourOf(startTime), timer.HourOf(endTime))) return BookingProtocol::Invalid;
+        return timer.AddReservation(startTime, endTime, p_price) ? BookingProtocol::Ok : BookingProtocol::Conflict;
+    }
+    quint8 BookingServer::Handle(quint8 p_opcode, const QByteArray& p_payload, BookingWriter& p_reply) {
+        BookingReader in(p_payload);
+        switch (p_opcode) {
+        case BookingProtocol::Ping:
+            return BookingProtocol::Ok;
+        case BookingProtocol::Info:
+            p_reply.U64(catalog->GetVersion()).U32(manager->GetSpaces().size());
+            return BookingProtocol::Ok;
+        case BookingProtocol::ListSpaces: {
+            const quint32 offset = in.U32(), limit = in.U32();
+            if (!in.IsOk()) return BookingProtocol::Invalid;
+            // Listing reads one consistent version
+            CatalogPin snapshot = catalog->Pin();
+            const quint32 size = snapshot->GetSize();
+            const quint32 begin = qMin(offset, size), end = begin + qMin(limit, size - begin);
+            p_reply.U32(end - begin);
+            for (quint32 i = begin; i < end; i++) {
+                const SpaceRecord& record = snapshot->At(i);
+                p_reply.U32(record.ID).Str(record.name).F64(record.dirhamsPerHour).F32(record.score);
+            }
+            return BookingProtocol::Ok;
+        }
+        case BookingProtocol::Book: {
+            const quint32 ID = in.U32();
+            const qint64 start = in.I64(), end = in.I64();
+            if (!in.IsOk()) return BookingProtocol::Invalid;
+            double price;
+            const quint8 status = BookOne(ID, start, end, price);
+            if (status == BookingProtocol::Ok) p_reply.F64(price);
+            return status;
+        }
+        case BookingProtocol::BookBatch: {
+            const quint32 count = in.U32();
+            // .. Each entry is 20 bytes, reject counts the payload cannot hold
+            if (!in.IsOk() || (qint64)count * 20 > p_payload.size()) return BookingProtocol::Invalid;
+            p_reply.U32(count);
+            for (quint32 i = 0; i < count; i++) {
+                const quint32 ID = in.U32();
+                const qint64 start = in.I64(), end = in.I64();
+                double price;
+                p_reply.U8(BookOne(ID, start, end, price)).F64(price);
+            }
+            return BookingProtocol::Ok;
+        }
+        case BookingProtocol::Cancel: {
+            const quint32 ID = in.U32();
+            const qint64 start = in.I64(), end = in.I64();
+            if (!in.IsOk()) return BookingProtocol::Invalid;
+            Space* space_ptr = Find(ID);
+            if (!space_ptr) return BookingProtocol::NotFound;
+            return space_ptr->GetTimer().RemoveReservation((time_t)start, (time_t)end) ? BookingProtocol::Ok : BookingProtocol::Invalid;
+        }
+        case BookingProtocol::GetTimes: {
+            const quint32 ID = in.U32();
+            if (!in.IsOk()) return BookingProtocol::Invalid;
+            Space* space_ptr = Find(ID);
+            if (!space_ptr) return BookingProtocol::NotFound;
+            const QVector<unsigned long long> times = space_ptr->GetTimer().GetTimes();
+            p_reply.I64(space_ptr->GetTimer().GetOriginTime()).U32(times.size());
+            for (unsigned long long word: times) p_reply.U64(word);
+            return BookingProtocol::Ok;
+        }
+        case BookingProtocol::AddReview: {
+            const quint32 ID = in.U32();
+            const QString review = in.Str();
+            const float score = in.F32();
+            // .. Scores are constrained to 0 to 5
+            if (!in.IsOk() || !(score >= 0 && score <= 5)) return BookingProtocol::Invalid;
+            Space* space_ptr = Find(ID);
+            if (!space_ptr) return BookingProtocol::NotFound;
+            space_ptr->GetReview().AddReview(review, score);
+            p_reply.F32(space_ptr->GetReview().GetReviewScore());
+            return BookingProtocol::Ok;
+        }
+        case BookingProtocol::GetReviews: {
+            const quint32 ID = in.U32();
+            if (!in.IsOk()) return BookingProtocol::Invalid;
+            Space* space_ptr = Find(ID);
+            if (!space_ptr) return BookingProtocol::NotFound;
+            const QVector<QString> reviews = space_ptr->GetReview().GetReviews();
+            p_reply.U32(reviews.size());
+            for (const QString& review: reviews) p_reply.Str(review);
+            return BookingProtocol::Ok;
+        }
+        default:
+            return BookingProtocol::Unknown;
+        }
+    }
+}
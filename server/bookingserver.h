@@ -0,0 +1,67 @@
+#ifndef BOOKINGSERVER_H
+#define BOOKINGSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QIODevice>
+#include <QLocalServer>
+#include <QTcpServer>
+
+// User libraries
+#include "space.h"
+#include "catalogstore.h"
+#include "bookingprotocol.h"
+
+namespace space {
+    // Headless booking daemon
+    // .. Serves SpaceManager, the reservation bitmaps and reviews over QLocalServer and loopback TCP
+    // .. Each readable pass handles a batch of frames and answers them with one write
+    // .. A connection whose replies pile up beyond the high watermark is not read
+    // .. until it drains below the low watermark, so clients are throttled by the socket
+    class BookingServer : public QObject {
+        Q_OBJECT
+    private:
+        struct Connection {
+            QIODevice* socket = nullptr;
+            QByteArray buffer;
+            bool paused = false;
+            bool queued = false;
+        };
+        SpaceManager* manager;
+        CatalogStore* catalog;
+        QLocalServer localServer;
+        QTcpServer tcpServer;
+        QHash<QIODevice*, Connection*> connections;
+        // ID -> position in the manager, rebuilt on SpacesChanged
+        QHash<unsigned int, int> indexOfID;
+        qint64 highWatermark = 4 << 20;
+        qint64 lowWatermark = 1 << 20;
+        int framesPerPass = 1024;
+        quint64 requestCount = 0;
+
+        void Accept(QIODevice* p_socket);
+        // Unparsed bytes to buffer before reading stops, at least the frame at the head
+        static int BufferLimit(const Connection* p_connection);
+        void Serve(Connection* p_connection);
+        void Queue(Connection* p_connection);
+        void Drop(Connection* p_connection);
+        void Reindex();
+        Space* Find(unsigned int p_ID) const;
+        quint8 BookOne(unsigned int p_ID, qint64 p_start, qint64 p_end, double& p_price);
+        quint8 Handle(quint8 p_opcode, const QByteArray& p_payload, BookingWriter& p_reply);
+    public:
+        explicit BookingServer(SpaceManager* p_manager, CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~BookingServer();
+
+        bool ListenLocal(const QString& p_name);
+        // Loopback only
+        bool ListenTcp(quint16 p_port);
+        void SetWatermarks(qint64 p_high, qint64 p_low) { highWatermark = p_high; lowWatermark = p_low; }
+        void SetFramesPerPass(int p_frames) { framesPerPass = p_frames; }
+        quint64 GetRequestCount() const { return requestCount; }
+        int GetConnectionCount() const { return connections.size(); }
+    };
+}
+
+#endif // BOOKINGSERVER_H
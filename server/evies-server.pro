@@ -0,0 +1,22 @@
+QT -= gui
+QT += core network concurrent
+CONFIG += c++11 console
+CONFIG -= app_bundle
+TARGET = evies-server
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# Shared catalog, reservation and protocol sources
+include(../space.pri)
+
+SOURCES += main.cpp \
+    bookingserver.cpp \
+    loadtest.cpp
+
+HEADERS += \
+    bookingserver.h \
+    loadtest.h
+
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,105 @@
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+// User libraries
+#include "loadtest.h"
+#include "bookingprotocol.h"
+#include <algorithm>
+#include <random>
+#include <ctime>
+
+namespace space {
+    // One connection, blocking socket calls on a pool thread
+    // .. Returns per-request latencies in nanoseconds, negative for conflicts
+    static QVector<qint64> RunConnection(QString p_address, int p_requests, int p_depth, unsigned int p_spaces, int p_seed) {
+        QVector<qint64> latencies;
+        QScopedPointer<QIODevice> device;
+        if (p_address.startsWith("tcp:")) {
+            QTcpSocket* tcp = new QTcpSocket();
+            device.reset(tcp);
+            tcp->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            tcp->connectToHost(QHostAddress::LocalHost, p_address.mid(4).toUShort());
+            if (!tcp->waitForConnected(5000)) return latencies;
+        } else {
+            QLocalSocket* local = new QLocalSocket();
+            device.reset(local);
+            local->connectToServer(p_address);
+            if (!local->waitForConnected(5000)) return latencies;
+        }
+        QLocalSocket* local = qobject_cast<QLocalSocket*>(device.data());
+        QTcpSocket* tcp = qobject_cast<QTcpSocket*>(device.data());
+        auto waitForReadyRead = [&]() { return local ? local->waitForReadyRead(5000) : tcp->waitForReadyRead(5000); };
+        auto flush = [&]() { if (local) local->flush(); else tcp->flush(); };
+
+        std::mt19937 random(p_seed);
+        // Book 1 to 3 hours somewhere in the next year, conflicts are part of the load
+        const qint64 now = time(NULL) + 3600;
+        QVector<qint64> sentAt(p_requests);
+        latencies.reserve(p_requests);
+        QElapsedTimer clock;
+        clock.start();
+        int sent = 0, received = 0;
+        QByteArray buffer;
+        while (received < p_requests) {
+            QByteArray out;
+            while (sent < p_requests && sent - received < p_depth) {
+                const qint64 start = now + (qint64)(random() % (365 * 24)) * 3600;
+                BookingProtocol::AppendFrame(out, sent, BookingProtocol::Book,
+                    BookingWriter().U32(random() % p_spaces).I64(start).I64(start + (random() % 3) * 3600).GetData());
+                sentAt[sent++] = clock.nsecsElapsed();
+            }
+            if (!out.isEmpty()) {
+                device->write(out);
+                flush();
+            }
+            if (!waitForReadyRead()) break;
+            buffer.append(device->readAll());
+            int offset = 0;
+            quint32 requestID;
+            quint8 status;
+            QByteArray payload;
+            bool error;
+            while (BookingProtocol::TakeFrame(buffer, offset, requestID, status, payload, error)) {
+                const qint64 latency = clock.nsecsElapsed() - sentAt[requestID];
+                latencies.append(status == BookingProtocol::Conflict ? -latency : latency);
+                received++;
+            }
+            buffer.remove(0, offset);
+            if (error) break;
+        }
+        return latencies;
+    }
+
+    LoadTest::Result LoadTest::Run(const QString& p_address, int p_connections, int p_requests, int p_depth, unsigned int p_spaces) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(p_connections);
+        QVector<QFuture<QVector<qint64>>> futures;
+        QElapsedTimer clock;
+        clock.start();
+        for (int c = 0; c < p_connections; c++)
+            futures.append(QtConcurrent::run(&pool, &RunConnection, p_address, p_requests, p_depth, qMax(1u, p_spaces), c + 1));
+        QVector<qint64> latencies;
+        Result result;
+        for (QFuture<QVector<qint64>>& future: futures) {
+            for (qint64 latency: future.result()) {
+                if (latency < 0) result.conflicts++;
+                latencies.append(latency < 0 ? -latency : latency);
+            }
+        }
+        result.seconds = clock.nsecsElapsed() / 1e9;
+        result.requests = latencies.size();
+        if (latencies.isEmpty()) return result;
+        std::sort(latencies.begin(), latencies.end());
+        result.p50 = latencies[latencies.size() / 2] / 1e3;
+        result.p99 = latencies[qMin(latencies.size() - 1, (int)(latencies.size() * 0.99))] / 1e3;
+        result.max = latencies.last() / 1e3;
+        return result;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef LOADTEST_H
+#define LOADTEST_H
+
+#include <QString>
+
+namespace space {
+    // Load generator for the booking daemon
+    // .. Each connection keeps p_depth Book requests in flight over its own socket
+    // .. Prints requests per second and latency percentiles
+    class LoadTest {
+    public:
+        struct Result {
+            quint64 requests = 0;
+            quint64 conflicts = 0;
+            double seconds = 0;
+            double p50 = 0, p99 = 0, max = 0;   // microseconds
+        };
+        static Result Run(const QString& p_address, int p_connections, int p_requests, int p_depth, unsigned int p_spaces);
+    };
+}
+
+#endif // LOADTEST_H
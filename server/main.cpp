@@ -0,0 +1,117 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QObject>
+#include <QString>
+#include <QFile>
+
+// User libraries
+#include "space.h"
+#include "catalogstore.h"
+#include "bookingserver.h"
+#include "loadtest.h"
+#include "workload.h"
+#include "metrics.h"
+#include "memoryusage.h"
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("evies-server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless booking daemon for the evies catalog");
+    parser.addHelpOption();
+    QCommandLineOption nameOption("name", "Local socket name to listen on.", "name", "evies");
+    QCommandLineOption portOption("port", "Also listen on loopback TCP at this port.", "port");
+    QCommandLineOption spacesOption("spaces", "Number of generated spaces to host.", "count", "1000");
+    QCommandLineOption loadOption("load", "Run the load generator against <address> instead of serving.", "address");
+    QCommandLineOption connectionsOption("connections", "Load generator connections.", "count", "4");
+    QCommandLineOption requestsOption("requests", "Load generator requests per connection.", "count", "100000");
+    QCommandLineOption depthOption("depth", "Load generator requests in flight per connection.", "count", "64");
+    QCommandLineOption seedOption("seed", "Seed of the generated catalog and trace.", "seed", "1");
+    QCommandLineOption makeTraceOption("make-trace", "Write a generated booking trace to <file> and exit.", "file");
+    QCommandLineOption eventsOption("events", "Events in a generated trace.", "count", "100000");
+    QCommandLineOption replayOption("replay", "Replay the trace in <file> against the generated catalog and exit.", "file");
+    QCommandLineOption rateOption("rate", "Replay rate in events per second, 0 for flat out.", "rate", "0");
+    QCommandLineOption traceOption("trace", "Write a Chrome trace of the replay to <file>.", "file");
+    QCommandLineOption memoryOption("memory", "Print the memory report of the generated catalog.");
+    parser.addOptions({ nameOption, portOption, spacesOption, loadOption, connectionsOption, requestsOption, depthOption,
+                        seedOption, makeTraceOption, eventsOption, replayOption, rateOption, traceOption, memoryOption });
+    parser.process(app);
+
+    // Client mode: measure throughput and latency of a running daemon
+    if (parser.isSet(loadOption)) {
+        space::LoadTest::Result result = space::LoadTest::Run(
+            parser.value(loadOption),
+            parser.value(connectionsOption).toInt(),
+            parser.value(requestsOption).toInt(),
+            parser.value(depthOption).toInt(),
+            parser.value(spacesOption).toUInt());
+        std::cout << "requests: " << result.requests << "\nconflicts: " << result.conflicts
+                  << "\nseconds: " << result.seconds
+                  << "\nrequests/s: " << (result.seconds > 0 ? result.requests / result.seconds : 0)
+                  << "\np50 us: " << result.p50 << "\np99 us: " << result.p99 << "\nmax us: " << result.max << std::endl;
+        return result.requests ? 0 : 1;
+    }
+
+    const quint64 seed = parser.value(seedOption).toULongLong();
+
+    // Trace mode: same seed and sizes, same trace
+    if (parser.isSet(makeTraceOption)) {
+        QFile file(parser.value(makeTraceOption));
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Cannot write " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+        space::Workload::TraceSpec spec;
+        spec.events = parser.value(eventsOption).toInt();
+        space::Workload::WriteTrace(space::Workload::MakeTrace(parser.value(spacesOption).toInt(), seed, spec), file);
+        return 0;
+    }
+
+    space::SpaceManager manager;
+    manager.GetRandomizedSpaces(parser.value(spacesOption).toInt(), seed);
+
+    // Replay mode: drive the catalog in process, no sockets involved
+    if (parser.isSet(replayOption)) {
+        QFile file(parser.value(replayOption));
+        space::Trace trace;
+        if (!file.open(QIODevice::ReadOnly) || !space::Workload::ReadTrace(file, trace)) {
+            std::cerr << "Cannot read trace " << file.fileName().toStdString() << std::endl;
+            return 1;
+        }
+        if (parser.isSet(traceOption)) space::Metrics::StartCapture();
+        space::TraceReplay::Result result = space::TraceReplay::Run(manager, trace, parser.value(rateOption).toDouble());
+        space::Metrics::StopCapture();
+        std::cout << "events: " << result.events << "\nbooked: " << result.booked << "\nconflicts: " << result.conflicts
+                  << "\ncancelled: " << result.cancelled << "\nskipped cancels: " << result.skipped << "\nreviews: " << result.reviews
+                  << "\nseconds: " << result.seconds
+                  << "\nevents/s: " << (result.seconds > 0 ? result.events / result.seconds : 0)
+                  << "\np50 us: " << result.p50 << "\np99 us: " << result.p99 << "\nmax us: " << result.max << std::endl;
+        std::cout << space::Metrics::Report().toStdString() << std::endl;
+        if (parser.isSet(traceOption)) {
+            QFile traceFile(parser.value(traceOption));
+            if (!traceFile.open(QIODevice::WriteOnly)) {
+                std::cerr << "Cannot write " << traceFile.fileName().toStdString() << std::endl;
+                return 1;
+            }
+            space::Metrics::WriteChromeTrace(traceFile);
+        }
+        return result.events ? 0 : 1;
+    }
+    space::CatalogStore catalog(&manager);
+    if (parser.isSet(memoryOption))
+        std::cout << space::MemoryMonitor(&manager, &catalog).Collect().Report().toStdString() << std::endl;
+    space::BookingServer server(&manager, &catalog);
+    if (!server.ListenLocal(parser.value(nameOption))) {
+        std::cerr << "Cannot listen on " << parser.value(nameOption).toStdString() << std::endl;
+        return 1;
+    }
+    if (parser.isSet(portOption) && !server.ListenTcp(parser.value(portOption).toUShort())) {
+        std::cerr << "Cannot listen on port " << parser.value(portOption).toStdString() << std::endl;
+        return 1;
+    }
+    std::cout << "Serving " << manager.GetSpaces().size() << " spaces on " << parser.value(nameOption).toStdString() << std::endl;
+    return app.exec();
+}
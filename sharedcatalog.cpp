@@ -0,0 +1,323 @@
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QDebug>
+
+// User libraries
+#include "sharedcatalog.h"
+#include <cstring>
+
+namespace space {
+    static const char magic[8] = {'E', 'V', 'I', 'E', 'S', 'S', 'H', 'M'};
+    static_assert(sizeof(SharedCatalogHeader) % 8 == 0 && sizeof(SharedCatalogRecord) % 8 == 0,
+                  "records and word pools must stay 8-byte aligned");
+
+    // Room left after each name and bitmap, a rename or about six weeks of new
+    // .. bookings are written in place without a new layout
+    static quint32 NameCapacity(int p_bytes) { return p_bytes + 16; }
+    static quint32 TimesCapacity(int p_words) { return p_words + 16; }
+    static quint64 Align(quint64 p_offset) { return (p_offset + 7) & ~7ULL; }
+
+    // View
+    SharedCatalogView::SharedCatalogView(const uchar* p_data, qint64 p_size) : data(p_data), size(p_size) {
+        header = p_size >= (qint64)sizeof(SharedCatalogHeader) ? reinterpret_cast<const SharedCatalogHeader*>(p_data) : nullptr;
+    }
+    const char* SharedCatalogView::Bytes(quint64 p_offset, quint64 p_length) const {
+        if (p_offset > (quint64)size || p_length > (quint64)size - p_offset) return nullptr;
+        return reinterpret_cast<const char*>(data) + p_offset;
+    }
+    int SharedCatalogView::GetSize() const {
+        if (!header) return 0;
+        const quint64 offset = header->recordsOffset;
+        if (offset > (quint64)size) return 0;
+        return (int)qMin<quint64>(header->count, ((quint64)size - offset) / sizeof(SharedCatalogRecord));
+    }
+    const SharedCatalogRecord& SharedCatalogView::At(int p_index) const {
+        return reinterpret_cast<const SharedCatalogRecord*>(data + header->recordsOffset)[p_index];
+    }
+    QString SharedCatalogView::NameOf(int p_index) const {
+        // .. One copy of the slot, offsets are checked and used from the same read
+        const SharedCatalogRecord record = At(p_index);
+        const char* name = Bytes(header->namesOffset + record.nameOffset, record.nameLength);
+        return name ? QString::fromUtf8(name, record.nameLength) : QString();
+    }
+    bool SharedCatalogView::IsFree(int p_index, time_t p_from, time_t p_to) const {
+        const SharedCatalogRecord record = At(p_index);
+        // Clip to the bookable range, same hour arithmetic as SpaceRecord::IsFree
+        if (p_from < record.originTime) p_from = record.originTime;
+        if (p_to <= p_from) return true;
+        const char* words = Bytes(header->timesOffset + (quint64)record.timesOffset * 8, (quint64)record.timesLength * 8);
+        if (!words) return true;
+        unsigned long startHour = (unsigned long)((p_from - record.originTime) / 3600);
+        unsigned long endHour = (unsigned long)((p_to - record.originTime + 3599) / 3600) - 1;
+        return !Time::AnyHours(reinterpret_cast<const unsigned long long*>(words), record.timesLength, startHour, endHour);
+    }
+    SpaceRecord SharedCatalogView::ToRecord(int p_index) const {
+        const SharedCatalogRecord slot = At(p_index);
+        SpaceRecord record;
+        record.ID = slot.ID;
+        record.name = NameOf(p_index);
+        record.area = slot.area;
+        record.numberOfPeople = slot.numberOfPeople;
+        record.numberOfSeats = slot.numberOfSeats;
+        record.dirhamsPerHour = slot.dirhamsPerHour;
+        record.score = slot.score;
+        record.numberOfReviews = slot.numberOfReviews;
+        record.flags = slot.flags;
+        record.originTime = (time_t)slot.originTime;
+        const char* words = Bytes(header->timesOffset + (quint64)slot.timesOffset * 8, (quint64)slot.timesLength * 8);
+        if (words) {
+            record.times.resize(slot.timesLength);
+            memcpy(record.times.data(), words, (size_t)slot.timesLength * 8);
+        }
+        return record;
+    }
+
+    // Writer
+    SharedCatalogWriter::SharedCatalogWriter(CatalogStore* p_catalog, QObject* parent) : QObject(parent) {
+        catalog = p_catalog;
+    }
+    SharedCatalogWriter::~SharedCatalogWriter() {
+        Close();
+    }
+    bool SharedCatalogWriter::Open(const QString& p_path) {
+        Close();
+        file = new QFile(p_path);
+        if (!file->open(QIODevice::ReadWrite) || !Reserve(qMax(file->size(), (qint64)sizeof(SharedCatalogHeader)))) {
+            qWarning() << "Cannot map shared catalog" << p_path;
+            Close();
+            return false;
+        }
+        SharedCatalogHeader* header = Header();
+        if (memcmp(header->magic, magic, sizeof(magic)) != 0 || header->layout != SharedCatalogHeader::Layout) {
+            memset(header, 0, sizeof(SharedCatalogHeader));
+            memcpy(header->magic, magic, sizeof(magic));
+            header->layout = SharedCatalogHeader::Layout;
+        } else if (header->sequence.load() & 1) {
+            // .. A previous writer stopped inside a write, the layout below replaces whatever it left
+            header->sequence.fetchAndAddRelease(1);
+        }
+        connect(catalog, &CatalogStore::Rebuilt, this, &SharedCatalogWriter::Layout);
+        connect(catalog, &CatalogStore::RecordsChanged, this, [this](quint64, const QVector<int>& p_indexes) { Patch(p_indexes); });
+        Layout();
+        return IsOpen();
+    }
+    void SharedCatalogWriter::Close() {
+        disconnect(catalog, nullptr, this, nullptr);
+        if (file) {
+            if (data) file->unmap(data);
+            file->close();
+            delete file;
+        }
+        file = nullptr;
+        data = nullptr;
+        mapped = 0;
+    }
+    bool SharedCatalogWriter::Reserve(qint64 p_size) {
+        if (p_size <= mapped) return true;
+        // .. Doubling, a catalog growing a few records at a time does not remap every time
+        const qint64 size = qMax(qMax(p_size, mapped * 2), file->size());
+        if (data) file->unmap(data);
+        data = nullptr;
+        mapped = 0;
+        if (file->size() < size && !file->resize(size)) return false;
+        data = file->map(0, size);
+        if (data) mapped = size;
+        return data != nullptr;
+    }
+    void SharedCatalogWriter::BeginWrite() {
+        Header()->sequence.fetchAndAddRelaxed(1);
+        // Readers must see the odd sequence before any of the writes that follow
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void SharedCatalogWriter::EndWrite() {
+        Header()->sequence.fetchAndAddRelease(1);
+    }
+    void SharedCatalogWriter::Write(SharedCatalogRecord& p_slot, const SpaceRecord& p_record, const QByteArray& p_name) {
+        const SharedCatalogHeader* header = Header();
+        // .. The even value EndWrite leaves, readers synced before it see the record as changed
+        p_slot.sequence = header->sequence.load() + 1;
+        p_slot.originTime = p_record.originTime;
+        p_slot.dirhamsPerHour = p_record.dirhamsPerHour;
+        p_slot.ID = p_record.ID;
+        p_slot.numberOfPeople = p_record.numberOfPeople;
+        p_slot.numberOfSeats = p_record.numberOfSeats;
+        p_slot.numberOfReviews = p_record.numberOfReviews;
+        p_slot.flags = p_record.flags;
+        p_slot.area = p_record.area;
+        p_slot.score = p_record.score;
+        p_slot.nameLength = p_name.size();
+        memcpy(data + header->namesOffset + p_slot.nameOffset, p_name.constData(), p_name.size());
+        p_slot.timesLength = p_record.times.size();
+        memcpy(data + header->timesOffset + (quint64)p_slot.timesOffset * 8, p_record.times.constData(), (size_t)p_record.times.size() * 8);
+    }
+    void SharedCatalogWriter::Layout() {
+        if (!data) return;
+        const CatalogPin pin = catalog->Pin();
+        const int count = pin->GetSize();
+        QVector<QByteArray> names(count);
+        quint64 nameBytes = 0, timeWords = 0;
+        for (int i = 0; i < count; i++) {
+            names[i] = pin->At(i).name.toUtf8();
+            nameBytes += NameCapacity(names[i].size());
+            timeWords += TimesCapacity(pin->At(i).times.size());
+        }
+        const quint64 recordsOffset = Align(sizeof(SharedCatalogHeader));
+        const quint64 namesOffset = recordsOffset + (quint64)count * sizeof(SharedCatalogRecord);
+        const quint64 timesOffset = Align(namesOffset + nameBytes);
+        const quint64 size = timesOffset + timeWords * 8;
+        if (!Reserve((qint64)size)) {
+            qWarning() << "Cannot grow shared catalog to" << size << "bytes";
+            Close();
+            return;
+        }
+
+        BeginWrite();
+        SharedCatalogHeader* header = Header();
+        header->generation++;
+        header->version = pin->GetVersion();
+        header->size = size;
+        header->count = count;
+        header->recordsOffset = recordsOffset;
+        header->namesOffset = namesOffset;
+        header->timesOffset = timesOffset;
+        SharedCatalogRecord* records = Records();
+        quint32 nameAt = 0, timesAt = 0;
+        for (int i = 0; i < count; i++) {
+            SharedCatalogRecord& slot = records[i];
+            memset(&slot, 0, sizeof(SharedCatalogRecord));
+            slot.nameOffset = nameAt;
+            slot.nameCapacity = NameCapacity(names[i].size());
+            slot.timesOffset = timesAt;
+            slot.timesCapacity = TimesCapacity(pin->At(i).times.size());
+            nameAt += slot.nameCapacity;
+            timesAt += slot.timesCapacity;
+            Write(slot, pin->At(i), names[i]);
+        }
+        EndWrite();
+    }
+    void SharedCatalogWriter::Patch(const QVector<int>& p_indexes) {
+        if (!data) return;
+        const CatalogPin pin = catalog->Pin();
+        if ((int)Header()->count != pin->GetSize()) {
+            Layout();
+            return;
+        }
+        // Everything fits its slot or nothing is written in place
+        QVector<QByteArray> names;
+        names.reserve(p_indexes.size());
+        const SharedCatalogRecord* records = Records();
+        for (int index: p_indexes) {
+            names.append(pin->At(index).name.toUtf8());
+            if ((quint32)names.last().size() > records[index].nameCapacity
+                || (quint32)pin->At(index).times.size() > records[index].timesCapacity) {
+                Layout();
+                return;
+            }
+        }
+        BeginWrite();
+        for (int i = 0; i < p_indexes.size(); i++) Write(Records()[p_indexes[i]], pin->At(p_indexes[i]), names[i]);
+        Header()->version = pin->GetVersion();
+        EndWrite();
+    }
+
+    // Reader
+    SharedCatalogReader::SharedCatalogReader(QObject* parent) : QObject(parent) {
+        connect(&poller, &QTimer::timeout, this, &SharedCatalogReader::Poll);
+    }
+    SharedCatalogReader::~SharedCatalogReader() {
+        Unmap();
+    }
+    bool SharedCatalogReader::Attach(const QString& p_path) {
+        Unmap();
+        path = p_path;
+        synced = false;
+        file = new QFile(path);
+        if (!file->open(QIODevice::ReadOnly) || file->size() < (qint64)sizeof(SharedCatalogHeader) || !Remap()
+            || memcmp(Header()->magic, magic, sizeof(magic)) != 0 || Header()->layout != SharedCatalogHeader::Layout) {
+            Unmap();
+            return false;
+        }
+        return true;
+    }
+    void SharedCatalogReader::Detach() {
+        poller.stop();
+        Unmap();
+        path.clear();
+        mirror = nullptr;
+        synced = false;
+    }
+    void SharedCatalogReader::Unmap() {
+        if (file) {
+            if (data) file->unmap(const_cast<uchar*>(data));
+            file->close();
+            delete file;
+        }
+        file = nullptr;
+        data = nullptr;
+        mapped = 0;
+    }
+    bool SharedCatalogReader::Remap() {
+        if (data) file->unmap(const_cast<uchar*>(data));
+        data = nullptr;
+        mapped = 0;
+        // .. The whole file, the writer only ever grows it
+        const qint64 size = file->size();
+        data = file->map(0, size);
+        if (data) mapped = size;
+        return data != nullptr;
+    }
+    SpaceRecords SharedCatalogReader::ReadRecords() {
+        SpaceRecords records;
+        Read([&records](const SharedCatalogView& p_view) {
+            records.clear();
+            records.reserve(p_view.GetSize());
+            for (int i = 0; i < p_view.GetSize(); i++) records.append(p_view.ToRecord(i));
+        });
+        return records;
+    }
+    void SharedCatalogReader::Mirror(CatalogStore* p_catalog, int p_interval) {
+        mirror = p_catalog;
+        synced = false;
+        poller.start(p_interval);
+        Poll();
+    }
+    void SharedCatalogReader::Poll() {
+        if (!mirror || path.isEmpty()) return;
+        // .. The writer may not have created the file yet
+        if (!data && !Attach(path)) return;
+        if (synced && Header()->sequence.load() == lastSequence) return;
+        Sync();
+    }
+    void SharedCatalogReader::Sync() {
+        // Records written after the last sync, or all of them after a new layout
+        SpaceRecords records;
+        QVector<int> indexes;
+        quint32 sequence = 0;
+        quint64 version = 0, generation = 0;
+        bool full = false;
+        const bool consistent = Read([&](const SharedCatalogView& p_view) {
+            records.clear();
+            indexes.clear();
+            sequence = p_view.GetSequence();
+            version = p_view.GetVersion();
+            generation = p_view.GetGeneration();
+            full = !synced || generation != lastGeneration;
+            for (int i = 0; i < p_view.GetSize(); i++) {
+                if (!full && p_view.At(i).sequence <= lastSequence) continue;
+                if (!full) indexes.append(i);
+                records.append(p_view.ToRecord(i));
+            }
+        });
+        // .. A busy writer is caught up with on the next poll
+        if (!consistent) return;
+        if (full) mirror->Replace(records);
+        else mirror->Patch(indexes, records);
+        lastSequence = sequence;
+        lastGeneration = generation;
+        synced = true;
+        emit Updated(version);
+    }
+}
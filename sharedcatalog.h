@@ -0,0 +1,169 @@
+#ifndef SHAREDCATALOG_H
+#define SHAREDCATALOG_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QFile>
+#include <QTimer>
+#include <QThread>
+#include <QAtomicInteger>
+
+// User libraries
+#include "catalogstore.h"
+#include "metrics.h"
+#include <atomic>
+#include <ctime>
+
+namespace space {
+    // Catalog published by one process into a memory-mapped file, read in place by others
+    // .. [header][count records][names, UTF-8][times, u64 words], offsets in bytes from the start
+    // .. The writer bumps the header sequence to odd before touching anything and back to even
+    // .. after (seqlock), readers copy what they need and retry if the sequence moved meanwhile
+    // .. Names and bitmaps get headroom, a booking rewrites its record in place; a record that
+    // .. outgrew its room, or a catalog rebuild, lays the whole file out again (new generation)
+    // .. The file only grows, readers remap when the header reports more bytes than they hold
+    struct SharedCatalogHeader {
+        enum { Layout = 1 };
+        char magic[8];                      // "EVIESSHM"
+        quint32 layout;
+        QBasicAtomicInteger<quint32> sequence;
+        quint64 version;                    // Catalog version last written
+        quint64 generation;                 // Full layouts so far, offsets are only valid within one
+        quint64 size;                       // Bytes in use
+        quint32 count;
+        quint32 reserved;
+        quint64 recordsOffset, namesOffset, timesOffset;
+    };
+    struct SharedCatalogRecord {
+        quint64 sequence;                   // Header sequence after the write that last changed it
+        qint64 originTime;
+        double dirhamsPerHour;
+        quint32 ID, numberOfPeople, numberOfSeats, numberOfReviews, flags;
+        float area, score;
+        quint32 nameOffset, nameLength, nameCapacity;       // Bytes into the names
+        quint32 timesOffset, timesLength, timesCapacity;    // Words into the times
+        quint32 reserved;
+    };
+
+    // Bounds-checked access to a mapped catalog
+    // .. Only meaningful inside SharedCatalogReader::Read, where a torn read is retried;
+    // .. the checks keep a torn offset from reading outside the mapping
+    class SharedCatalogView {
+        friend class SharedCatalogReader;
+    public:
+        quint32 GetSequence() const { return header ? header->sequence.load() : 0; }
+        quint64 GetVersion() const { return header ? header->version : 0; }
+        quint64 GetGeneration() const { return header ? header->generation : 0; }
+        int GetSize() const;
+        // Fixed-size fields in place, p_index < GetSize()
+        const SharedCatalogRecord& At(int p_index) const;
+        QString NameOf(int p_index) const;
+        // True if no hour in [p_from, p_to) is booked, read off the mapped words
+        bool IsFree(int p_index, time_t p_from, time_t p_to) const;
+        SpaceRecord ToRecord(int p_index) const;
+    private:
+        SharedCatalogView(const uchar* p_data, qint64 p_size);
+        const uchar* data;
+        qint64 size;
+        const SharedCatalogHeader* header;
+        const char* Bytes(quint64 p_offset, quint64 p_length) const;
+    };
+
+    // Publishing side, follows a CatalogStore
+    class SharedCatalogWriter : public QObject {
+        Q_OBJECT
+    private:
+        CatalogStore* catalog;
+        QFile* file = nullptr;
+        uchar* data = nullptr;
+        qint64 mapped = 0;
+
+        SharedCatalogHeader* Header() const { return reinterpret_cast<SharedCatalogHeader*>(data); }
+        SharedCatalogRecord* Records() const { return reinterpret_cast<SharedCatalogRecord*>(data + Header()->recordsOffset); }
+        // Grows the file and the mapping to at least p_size bytes
+        bool Reserve(qint64 p_size);
+        void BeginWrite();
+        void EndWrite();
+        void Write(SharedCatalogRecord& p_slot, const SpaceRecord& p_record, const QByteArray& p_name);
+        void Layout();
+        void Patch(const QVector<int>& p_indexes);
+    public:
+        explicit SharedCatalogWriter(CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~SharedCatalogWriter();
+
+        // Creates p_path or takes it over, publishes the current catalog and then every new version
+        // .. Readers attached to an earlier writer of the same file carry on
+        bool Open(const QString& p_path);
+        void Close();
+        bool IsOpen() const { return data != nullptr; }
+        quint64 GetGeneration() const { return data ? Header()->generation : 0; }
+    };
+
+    // Attaching side, read-only, used from one thread
+    // .. Read hands out consistent views of the mapped catalog, Mirror keeps a local
+    // .. CatalogStore in step so models and queries work as in the publishing process
+    class SharedCatalogReader : public QObject {
+        Q_OBJECT
+    signals:
+        void Updated(quint64 version);
+    private:
+        enum { MaxRetries = 1000 };
+        QString path;
+        QFile* file = nullptr;
+        const uchar* data = nullptr;
+        qint64 mapped = 0;
+        CatalogStore* mirror = nullptr;
+        QTimer poller;
+        // Last state copied into the mirror
+        quint32 lastSequence = 0;
+        quint64 lastGeneration = 0;
+        bool synced = false;
+
+        const SharedCatalogHeader* Header() const { return reinterpret_cast<const SharedCatalogHeader*>(data); }
+        bool Remap();
+        void Unmap();
+        void Sync();
+    public:
+        explicit SharedCatalogReader(QObject* parent = nullptr);
+        virtual ~SharedCatalogReader();
+
+        // False if p_path is missing or not a shared catalog yet, Mirror retries on its own
+        // .. The path is kept either way, Attach it before Mirror
+        bool Attach(const QString& p_path);
+        void Detach();
+        bool IsAttached() const { return data != nullptr; }
+
+        // Calls p_read(const SharedCatalogView&) until it ran without a concurrent write
+        // .. p_read may run several times and must only keep what it read on the last run
+        // .. False if the writer stayed busy for MaxRetries runs
+        template <typename Reader> bool Read(Reader p_read);
+        SpaceRecords ReadRecords();
+
+        // Feeds p_catalog, a store without a manager, checking for new versions every p_interval ms
+        void Mirror(CatalogStore* p_catalog, int p_interval = 50);
+    public slots:
+        void Poll();
+    };
+
+    template <typename Reader> bool SharedCatalogReader::Read(Reader p_read) {
+        if (!data) return false;
+        for (int attempt = 0; attempt < MaxRetries; attempt++) {
+            if (attempt) EVIES_COUNT(SharedCatalogRetries);
+            const quint32 before = Header()->sequence.loadAcquire();
+            // .. Odd while the writer is inside
+            if (before & 1) {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            if (Header()->size > (quint64)mapped && !Remap()) return false;
+            p_read(SharedCatalogView(data, mapped));
+            // Keep the reads above from moving below the second load
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Header()->sequence.load() == before) return true;
+        }
+        return false;
+    }
+}
+
+#endif // SHAREDCATALOG_H
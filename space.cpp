@@ -1,22 +1,17 @@
 #include <QObject>
 #include <QVector>
 #include <QString>
-#include <qqml.h>
 
 // User libraries
 #include "space.h"
+#include "workload.h"
+#include "memoryusage.h"
 #include <string>
 #include <vector>
 #include <cmath>
+#include <limits>
 #include <ctime>
 
-// Bitwise helpers
-// https://stackoverflow.com/questions/62689/bitwise-indexing-in-c
-#define GetBit(var, bit) ((var & (1 << bit)) != 0) // Returns true / false if bit is set
-#define SetBit(var, bit) (var |= (1 << bit))
-#define ClearBit(var, bit) (var &= ~(1 << bit))
-#define FlipBit(var, bit) (var ^= (1 << bit))
-
 // Namespace for class objects
 namespace space {
     // Class for space dimensions
@@ -35,34 +30,41 @@ namespace space {
         height = p_height;
         UpdateAAR();
     }
+    // Change notifications
+    void Dimensions::Changed(unsigned int p_properties) {
+        if (changes.Defer(p_properties)) return;
+        if (p_properties & LengthProperty) emit LengthChanged();
+        if (p_properties & WidthProperty) emit WidthChanged();
+        if (p_properties & HeightProperty) emit HeightChanged();
+        if (p_properties & AreaProperty) emit AreaChanged();
+        if (p_properties & AspectRatioProperty) emit AspectRatioChanged();
+    }
+    bool Dimensions::EndUpdate() {
+        unsigned int properties = changes.End();
+        if (properties) Changed(properties);
+        return properties != 0;
+    }
     // Setters
     void Dimensions::SetLength(float p_length) {
         length = p_length;
         UpdateAAR();
-        emit LengthChanged();
-        emit AreaChanged();
-        emit AspectRatioChanged();
+        Changed(LengthProperty | AreaProperty | AspectRatioProperty);
     }
     void Dimensions::SetWidth(float p_width){
         width = p_width;
         UpdateAAR();
-        emit WidthChanged();
-        emit AreaChanged();
-        emit AspectRatioChanged();
+        Changed(WidthProperty | AreaProperty | AspectRatioProperty);
     }
     void Dimensions::SetHeight(float p_height) {
         height = p_height;
-        emit HeightChanged();
+        Changed(HeightProperty);
     }
     void Dimensions::SetDimensions(float p_length, float p_width, float p_height) {
         length = p_length;
         width = p_width;
         height = p_height;
-        emit LengthChanged();
-        emit WidthChanged();
-        emit HeightChanged();
-        emit AreaChanged();
-        emit AspectRatioChanged();
+        UpdateAAR();
+        Changed(LengthProperty | WidthProperty | HeightProperty | AreaProperty | AspectRatioProperty);
     }
 
     // Class for seatings
@@ -77,23 +79,36 @@ namespace space {
         surround = p_surround;
         comfy = p_comfy;
     }
+    // Change notifications
+    void Seating::Changed(unsigned int p_properties) {
+        if (changes.Defer(p_properties)) return;
+        if (p_properties & NumberOfSeatsProperty) emit NumberOfSeatsChanged();
+        if (p_properties & SlantedProperty) emit SlantedChanged();
+        if (p_properties & SurroundProperty) emit SurroundChanged();
+        if (p_properties & ComfyProperty) emit ComfyChanged();
+    }
+    bool Seating::EndUpdate() {
+        unsigned int properties = changes.End();
+        if (properties) Changed(properties);
+        return properties != 0;
+    }
     // Setters
     void Seating::SetNumberOfSeats(unsigned int p_numberOfSeats) {
         numberOfSeats = p_numberOfSeats;
-        emit NumberOfSeatsChanged();
+        Changed(NumberOfSeatsProperty);
     }
     // Setters using overload
     void Seating::IsSlanted(bool p_slanted) {
         slanted = p_slanted;
-        emit SlantedChanged();
+        Changed(SlantedProperty);
     }
     void Seating::IsSurround(bool p_surround) {
-       surround = p_surround;
-        emit SurroundChanged();
+        surround = p_surround;
+        Changed(SurroundProperty);
     }
     void Seating::IsComfy(bool p_comfy) {
         comfy = p_comfy;
-        emit SurroundChanged();
+        Changed(ComfyProperty);
     }
 
     // Class for available times
@@ -112,93 +127,434 @@ namespace space {
         originTime = p_originTime + (3600 - p_originTime % 3600);
         dirhamsPerHour = p_dirhamsPerHour;
     }
+    // Change notifications
+    void Time::Changed(unsigned int p_properties) {
+        if (changes.Defer(p_properties)) return;
+        if (p_properties & DirhamsPerHourProperty) emit DirhamsPerHourChanged();
+        if (p_properties & TimesProperty) {
+            int first = dirtyFirstWord, last = dirtyLastWord;
+            dirtyFirstWord = dirtyLastWord = -1;
+            if (first >= 0) emit WordsChanged(first, last);
+            emit TimesChanged();
+        }
+    }
+    void Time::TouchWords(int p_first, int p_last) {
+        if (dirtyFirstWord < 0 || p_first < dirtyFirstWord) dirtyFirstWord = p_first;
+        if (p_last > dirtyLastWord) dirtyLastWord = p_last;
+        // Occupancy index, point updates unless the bitmap grew or most of it changed
+        if (!occupancy.isEmpty()) {
+            if (occupancy.size() != times.size() + 1 || (p_last - p_first + 1) * 8 > times.size()) BuildOccupancy();
+            else {
+                for (int word = p_first; word <= p_last; word++) {
+                    const int delta = qPopulationCount((quint64)times[word]) - (WordPrefix(word + 1) - WordPrefix(word));
+                    if (!delta) continue;
+                    for (int i = word + 1; i < occupancy.size(); i += i & -i) occupancy[i] += delta;
+                }
+            }
+        }
+        Changed(TimesProperty);
+    }
+    bool Time::EndUpdate() {
+        unsigned int properties = changes.End();
+        if (properties) Changed(properties);
+        return properties != 0;
+    }
     // Setters
     void Time::SetDirhamsPerHour(double p_dirhamsPerHour) {
         dirhamsPerHour = p_dirhamsPerHour;
-        emit DirhamsPerHourChanged();
+        Changed(DirhamsPerHourProperty);
+    }
+    // Hour index helpers
+    long Time::HourOf(const time_t& p_time) const {
+        // .. Hour is tracked from beginning o'clock -> floor is used here
+        const double hours = std::floor(std::difftime(p_time, originTime) / (60 * 60));
+        // .. Out of range of long, the cast alone would be undefined
+        if (hours >= (double)std::numeric_limits<long>::max()) return std::numeric_limits<long>::max();
+        if (hours <= (double)std::numeric_limits<long>::min()) return std::numeric_limits<long>::min();
+        return (long)hours;
+    }
+    // Word-level range operations
+    // .. First and last words are masked, inner words are written whole
+    void Time::SetHours(QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour) {
+        unsigned long startWord = p_startHour / 64, endWord = p_endHour / 64;
+        if ((unsigned long)p_times.size() <= endWord) p_times.resize(endWord + 1);
+        if (startWord == endWord) {
+            p_times[startWord] |= WordMask(p_startHour % 64, p_endHour % 64);
+            return;
+        }
+        p_times[startWord] |= WordMask(p_startHour % 64, 63);
+        for (unsigned long j = startWord + 1; j < endWord; j++) p_times[j] = ~0ULL;
+        p_times[endWord] |= WordMask(0, p_endHour % 64);
+    }
+    void Time::ClearHours(QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour) {
+        unsigned long startWord = p_startHour / 64, endWord = p_endHour / 64;
+        // Nothing is booked past the last word
+        if ((unsigned long)p_times.size() <= startWord) return;
+        if ((unsigned long)p_times.size() <= endWord) {
+            endWord = p_times.size() - 1;
+            p_endHour = endWord * 64 + 63;
+        }
+        if (startWord == endWord) {
+            p_times[startWord] &= ~WordMask(p_startHour % 64, p_endHour % 64);
+            return;
+        }
+        p_times[startWord] &= ~WordMask(p_startHour % 64, 63);
+        for (unsigned long j = startWord + 1; j < endWord; j++) p_times[j] = 0;
+        p_times[endWord] &= ~WordMask(0, p_endHour % 64);
+    }
+    bool Time::AnyHours(const QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour) {
+        return AnyHours(p_times.constData(), p_times.size(), p_startHour, p_endHour);
+    }
+    bool Time::AnyHours(const unsigned long long* p_times, int p_words, unsigned long p_startHour, unsigned long p_endHour) {
+        unsigned long startWord = p_startHour / 64, endWord = p_endHour / 64;
+        if ((unsigned long)p_words <= startWord) return false;
+        if ((unsigned long)p_words <= endWord) {
+            endWord = p_words - 1;
+            p_endHour = endWord * 64 + 63;
+        }
+        if (startWord == endWord)
+            return (p_times[startWord] & WordMask(p_startHour % 64, p_endHour % 64)) != 0;
+        if (p_times[startWord] & WordMask(p_startHour % 64, 63)) return true;
+        for (unsigned long j = startWord + 1; j < endWord; j++)
+            if (p_times[j]) return true;
+        return (p_times[endWord] & WordMask(0, p_endHour % 64)) != 0;
+    }
+    unsigned int Time::CountHours(const QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour) {
+        unsigned long startWord = p_startHour / 64, endWord = p_endHour / 64;
+        if ((unsigned long)p_times.size() <= startWord) return 0;
+        if ((unsigned long)p_times.size() <= endWord) {
+            endWord = p_times.size() - 1;
+            p_endHour = endWord * 64 + 63;
+        }
+        if (startWord == endWord)
+            return qPopulationCount((quint64)(p_times[startWord] & WordMask(p_startHour % 64, p_endHour % 64)));
+        unsigned int count = qPopulationCount((quint64)(p_times[startWord] & WordMask(p_startHour % 64, 63)));
+        for (unsigned long j = startWord + 1; j < endWord; j++) count += qPopulationCount((quint64)p_times[j]);
+        return count + qPopulationCount((quint64)(p_times[endWord] & WordMask(0, p_endHour % 64)));
+    }
+    // Occupancy index
+    void Time::BuildOccupancy() const {
+        // .. Linear build: each node adds itself to its parent
+        occupancy.fill(0, times.size() + 1);
+        for (int i = 1; i < occupancy.size(); i++) {
+            occupancy[i] += qPopulationCount((quint64)times[i - 1]);
+            const int parent = i + (i & -i);
+            if (parent < occupancy.size()) occupancy[parent] += occupancy[i];
+        }
+    }
+    int Time::WordPrefix(int p_words) const {
+        int count = 0;
+        for (int i = p_words; i > 0; i -= i & -i) count += occupancy[i];
+        return count;
+    }
+    unsigned int Time::CountBooked(unsigned long p_startHour, unsigned long p_endHour) const {
+        if (p_endHour < p_startHour || p_startHour / 64 >= (unsigned long)times.size()) return 0;
+        if (occupancy.isEmpty()) BuildOccupancy();
+        const unsigned long lastHour = (unsigned long)times.size() * 64 - 1;
+        if (p_endHour > lastHour) p_endHour = lastHour;
+        const int startWord = p_startHour / 64, endWord = p_endHour / 64;
+        if (startWord == endWord)
+            return qPopulationCount((quint64)(times[startWord] & WordMask(p_startHour % 64, p_endHour % 64)));
+        // .. Whole words in between from the index, the two ends masked
+        return WordPrefix(endWord) - WordPrefix(startWord + 1)
+             + qPopulationCount((quint64)(times[startWord] & WordMask(p_startHour % 64, 63)))
+             + qPopulationCount((quint64)(times[endWord] & WordMask(0, p_endHour % 64)));
+    }
+    unsigned int Time::CountBookedBetween(const time_t& p_from, const time_t& p_to) const {
+        const long startHour = qMax(HourOf(p_from), 0L), endHour = HourOf(p_to - 1);
+        if (p_to <= p_from || endHour < startHour) return 0;
+        return CountBooked(startHour, endHour);
+    }
+    unsigned int Time::CountBookable(const time_t& p_from, const time_t& p_to) const {
+        const long startHour = qMax(HourOf(p_from), 0L), endHour = HourOf(p_to - 1);
+        if (p_to <= p_from || endHour < startHour) return 0;
+        return endHour - startHour + 1;
+    }
+    QVector<unsigned long long> Time::ShiftHours(const QVector<unsigned long long>& p_times, long p_hours) {
+        const long words = p_hours / 64;
+        const int bits = (int)(p_hours % 64);
+        QVector<unsigned long long> shifted;
+        if (p_hours >= 0) {
+            shifted.resize(p_times.size() + words + (bits ? 1 : 0));
+            for (int j = 0; j < p_times.size(); j++) {
+                if (!p_times[j]) continue;
+                shifted[j + words] |= p_times[j] << bits;
+                if (bits) shifted[j + words + 1] |= p_times[j] >> (64 - bits);
+            }
+        } else {
+            // .. Word j lands on j + words, its top bits reach one word further up
+            const int down = -bits;
+            for (int j = -words; j < p_times.size(); j++) {
+                if (!p_times[j]) continue;
+                const int target = j + words;
+                if (shifted.size() <= target) shifted.resize(target + 1);
+                shifted[target] |= p_times[j] >> down;
+                if (down && target > 0) shifted[target - 1] |= p_times[j] << (64 - down);
+            }
+        }
+        while (!shifted.isEmpty() && !shifted.last()) shifted.removeLast();
+        return shifted;
+    }
+    void Time::MergeTimes(const QVector<unsigned long long>& p_times) {
+        if (times.size() < p_times.size()) times.resize(p_times.size());
+        for (int j = 0; j < p_times.size(); j++) times[j] |= p_times[j];
+        if (!p_times.isEmpty()) TouchWords(0, p_times.size() - 1);
+    }
+    // Civil dates
+    // .. http://howardhinnant.github.io/date_algorithms.html
+    long Time::DaysFromCivil(long y, unsigned int m, unsigned int d) {
+        y -= m <= 2;
+        const long era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned long yoe = (unsigned long)(y - era * 400);
+        const unsigned long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + (long)doe - 719468;
+    }
+    void Time::CivilFromDays(long z, long& y, unsigned int& m, unsigned int& d) {
+        z += 719468;
+        const long era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned long doe = (unsigned long)(z - era * 146097);
+        const unsigned long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned long mp = (5 * doy + 2) / 153;
+        d = (unsigned int)(doy - (153 * mp + 2) / 5 + 1);
+        m = (unsigned int)(mp < 10 ? mp + 3 : mp - 9);
+        y = (long)yoe + era * 400 + (m <= 2);
+    }
+
+    // Recurring reservations
+    static void OrHours(QVector<unsigned long long>& p_times, const QVector<unsigned long long>& p_other) {
+        if (p_times.size() < p_other.size()) p_times.resize(p_other.size());
+        for (int j = 0; j < p_other.size(); j++) p_times[j] |= p_other[j];
+    }
+    // First and last non-zero words, false if none
+    static bool UsedWords(const QVector<unsigned long long>& p_times, int& p_first, int& p_last) {
+        p_first = 0;
+        p_last = p_times.size() - 1;
+        while (p_first <= p_last && !p_times[p_first]) p_first++;
+        while (p_last >= p_first && !p_times[p_last]) p_last--;
+        return p_first <= p_last;
+    }
+    QVector<unsigned long long> Time::SeriesHours(const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule) const {
+        QVector<unsigned long long> hours;
+        const long startHour = HourOf(p_startTime), endHour = HourOf(p_endTime);
+        if (endHour < startHour || startHour < 0 || p_rule.interval == 0 || (p_rule.count == 0 && p_rule.until == 0)) return hours;
+        const unsigned long span = endHour - startHour + 1;
+
+        if (p_rule.frequency != Recurrence::MonthlyByWeekday) {
+            // .. An interval past the limit could not repeat anyway, and would overflow the period
+            if (p_rule.interval > (unsigned int)MaxSeriesHours) return hours;
+            const unsigned long period = (p_rule.frequency == Recurrence::Daily ? 24 : 7 * 24) * (unsigned long)p_rule.interval;
+            if (span > period || period > (unsigned long)MaxSeriesHours) return hours;
+            unsigned long count = p_rule.count ? p_rule.count : ~0UL;
+            if (p_rule.until) {
+                if (p_rule.until < p_startTime) return hours;
+                count = qMin(count, (unsigned long)((p_rule.until - p_startTime) / ((time_t)period * 3600)) + 1);
+            }
+            // .. Divided rather than multiplied, count and interval are unbounded
+            if (startHour + span > (unsigned long)MaxSeriesHours
+                || count - 1 > ((unsigned long)MaxSeriesHours - startHour - span) / period) return hours;
+            // Binary doubling: block holds 2^k occurrences, added at the next
+            // .. free offset for each set bit of the count
+            QVector<unsigned long long> block;
+            SetHours(block, startHour, endHour);
+            unsigned long blockCount = 1, offset = 0;
+            for (unsigned long left = count; left; left >>= 1) {
+                if (left & 1) {
+                    OrHours(hours, ShiftHours(block, (long)(offset * period)));
+                    offset += blockCount;
+                }
+                if (left > 1) {
+                    OrHours(block, ShiftHours(block, (long)(blockCount * period)));
+                    blockCount *= 2;
+                }
+            }
+            return hours;
+        }
+
+        // Monthly: one occurrence per month, no fixed period in hours
+        // .. Occurrences longer than four weeks would run into each other
+        if (span > 28 * 24 || p_rule.ordinal == 0 || p_rule.ordinal < -1 || p_rule.ordinal > 5) return hours;
+        const long startDay = (long)std::floor(p_startTime / 86400.0);
+        const time_t timeOfDay = p_startTime - (time_t)startDay * 86400;
+        // .. 1970-01-01 was a Thursday, Sunday is 0
+        const int weekday = (int)(((startDay + 4) % 7 + 7) % 7);
+        long year;
+        unsigned int month, day;
+        CivilFromDays(startDay, year, month, day);
+        unsigned int occurrences = 0;
+        for (long months = 0; ; months += p_rule.interval) {
+            const long monthIndex = year * 12 + (month - 1) + months;
+            const long first = DaysFromCivil(monthIndex / 12, monthIndex % 12 + 1, 1);
+            const long next = DaysFromCivil((monthIndex + 1) / 12, (monthIndex + 1) % 12 + 1, 1);
+            long target;
+            if (HourOf((time_t)first * 86400) > (long)MaxSeriesHours) {
+                hours.clear();
+                break;
+            }
+            if (p_rule.ordinal > 0) {
+                target = first + ((weekday - (int)((first + 4) % 7) + 7) % 7) + 7 * (p_rule.ordinal - 1);
+                if (target >= next) continue;
+            } else {
+                const long last = next - 1;
+                target = last - (((int)((last + 4) % 7) - weekday + 7) % 7);
+            }
+            const time_t start = (time_t)target * 86400 + timeOfDay;
+            if (start < p_startTime) continue;
+            if (p_rule.until && start > p_rule.until) break;
+            const long hour = HourOf(start);
+            // .. Refused rather than cut short, like the periodic rules
+            if (hour + (long)span > (long)MaxSeriesHours) {
+                hours.clear();
+                break;
+            }
+            SetHours(hours, hour, hour + span - 1);
+            if (p_rule.count && ++occurrences == p_rule.count) break;
+        }
+        return hours;
+    }
+    unsigned int Time::AddSeries(const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule, double& price) {
+        EVIES_TIME_SCOPE(AddSeriesTimer);
+        price = 0;
+        const QVector<unsigned long long> hours = SeriesHours(p_startTime, p_endTime, p_rule);
+        int first, last;
+        if (!UsedWords(hours, first, last)) {
+            EVIES_COUNT(ReservationsInvalid);
+            return 0;
+        }
+        // All occurrences are checked before any is booked
+        for (int j = first; j <= qMin(last, times.size() - 1); j++) {
+            if (times[j] & hours[j]) {
+                EVIES_COUNT(ReservationConflicts);
+                return 0;
+            }
+        }
+        OrHours(times, hours);
+        TouchWords(first, last);
+        const unsigned int ID = nextSeries++;
+        series.insert(ID, hours);
+        price = dirhamsPerHour * CountHours(hours, 0, hours.size() * 64 - 1);
+        EVIES_COUNT(ReservationsBooked);
+        return ID;
+    }
+    bool Time::ModifySeries(unsigned int p_series, const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule, double& price) {
+        price = 0;
+        if (!series.contains(p_series)) return false;
+        const QVector<unsigned long long> old = series.value(p_series);
+        const QVector<unsigned long long> hours = SeriesHours(p_startTime, p_endTime, p_rule);
+        int first, last, oldFirst, oldLast;
+        if (!UsedWords(hours, first, last)) {
+            EVIES_COUNT(ReservationsInvalid);
+            return false;
+        }
+        // .. The series' own hours do not conflict with it
+        for (int j = first; j <= qMin(last, times.size() - 1); j++) {
+            if (times[j] & ~old.value(j) & hours[j]) {
+                EVIES_COUNT(ReservationConflicts);
+                return false;
+            }
+        }
+        for (int j = 0; j < old.size(); j++) times[j] &= ~old[j];
+        OrHours(times, hours);
+        if (UsedWords(old, oldFirst, oldLast)) TouchWords(qMin(first, oldFirst), qMax(last, oldLast));
+        else TouchWords(first, last);
+        series.insert(p_series, hours);
+        price = dirhamsPerHour * CountHours(hours, 0, hours.size() * 64 - 1);
+        return true;
+    }
+    bool Time::RemoveSeries(unsigned int p_series) {
+        if (!series.contains(p_series)) return false;
+        const QVector<unsigned long long> hours = series.take(p_series);
+        for (int j = 0; j < hours.size() && j < times.size(); j++) times[j] &= ~hours[j];
+        int first, last;
+        if (UsedWords(hours, first, last)) TouchWords(first, qMin(last, times.size() - 1));
+        EVIES_COUNT(ReservationsRemoved);
+        return true;
     }
     // Function to reserve
     // .. param price to return the price
     bool Time::AddReservation(const time_t& p_startTime, const time_t& p_endTime, double& price) {
+        EVIES_TIME_SCOPE(AddReservationTimer);
         // Initialize price
         price = 0;
-        // Get hours difference between startTime, endTime and originTime
-        // .. Hour is tracked from beginning o'clock -> floor is used here
-        unsigned long startHours = (unsigned long)std::floor(std::difftime(p_startTime, originTime) / (60 * 60));
-        unsigned long endHours = (unsigned long)std::floor(std::difftime(p_endTime, originTime) / (60 * 60));
+        long startHours = HourOf(p_startTime);
+        long endHours = HourOf(p_endTime);
         // Invalid reservation
-        if (endHours < startHours or startHours < 0) return false;
-        if (times.size() < endHours / 64)
-            while (times.size() <= endHours / 64) times.push_back(0);
+        if (!IsBookable(startHours, endHours)) {
+            EVIES_COUNT(ReservationsInvalid);
+            return false;
+        }
         // Check if any hour in the reservation is booked
-        if (startHours / 64 == endHours / 64) {
-            for (unsigned long i = startHours % 64; i <= endHours % 64; i++)
-                if GetBit(times[startHours / 64], i)
-                    // Time is occupied
-                    return false;
-        } else {
-            for (unsigned long i = startHours % 64; i < 64; i++)
-                if GetBit(times[startHours / 64], i)
-                    // Time is occupied
-                    return false;
-            unsigned long j = startHours / 64;
-            while (j != endHours / 64) {
-                for (unsigned long i = 0; i < 64; i++)
-                    if GetBit(times[startHours / 64], i)
-                        // Time is occupied
-                        return false;
-                j++;
-            }
-            for (unsigned long i = 0; i <= endHours % 64; i++)
-                if GetBit(times[endHours / 64], i)
-                    // Time is occupied
-                    return false;
+        if (!IsFree(startHours, endHours)) {
+            // Time is occupied
+            EVIES_COUNT(ReservationConflicts);
+            return false;
         }
         // If not, proceed to select the hours
-        if (startHours / 64 == endHours / 64) {
-            for (unsigned long i = startHours % 64; i <= endHours % 64; i++)
-                SetBit(times[startHours / 64], i);
-        } else {
-            for (unsigned long i = startHours % 64; i < 64; i++)
-                SetBit(times[startHours / 64], i);
-            unsigned long j = startHours / 64;
-            while (j != endHours / 64) {
-                times[startHours / 64] = ~0;
-                j++;
-            }
-            for (unsigned long i = 0; i <= endHours % 64; i++)
-                SetBit(times[endHours / 64], i);
-        }
+        SetHours(times, startHours, endHours);
         price = dirhamsPerHour * (endHours - startHours + 1);
-        emit TimesChanged();
+        TouchWords(startHours / 64, endHours / 64);
+        EVIES_COUNT(ReservationsBooked);
         return true;
     }
     // Function to remove reservations
     bool Time::RemoveReservation(const time_t& p_startTime, const time_t& p_endTime) {
-        // Get hours difference between startTime, endTime and originTime
-        // .. Hour is tracked from beginning o'clock -> floor is used here
-        unsigned long startHours = (unsigned long)std::floor(std::difftime(p_startTime, originTime) / (60 * 60));
-        unsigned long endHours = (unsigned long)std::floor(std::difftime(p_endTime, originTime) / (60 * 60));
+        EVIES_TIME_SCOPE(RemoveReservationTimer);
+        long startHours = HourOf(p_startTime);
+        long endHours = HourOf(p_endTime);
         // Invalid reservation
-        if (endHours < startHours or startHours < 0) return false;
-        if (times.size() < endHours / 64)
-            while (times.size() <= endHours / 64) times.push_back(0);
-        // Directly clear the hours
-        if (startHours / 64 == endHours / 64) {
-            for (unsigned long i = startHours % 64; i <= endHours % 64; i++)
-                ClearBit(times[startHours / 64], i);
-        } else {
-            for (unsigned long i = startHours % 64; i < 64; i++)
-                ClearBit(times[startHours / 64], i);
-            unsigned long j = startHours / 64;
-            while (j != endHours / 64) {
-                times[startHours / 64] = 0;
-                j++;
-            }
-            for (unsigned long i = 0; i <= endHours % 64; i++)
-                ClearBit(times[endHours / 64], i);
+        if (endHours < startHours or startHours < 0) {
+            EVIES_COUNT(ReservationsInvalid);
+            return false;
         }
-        emit TimesChanged();
+        // Directly clear the hours
+        ClearHours(times, startHours, endHours);
+        // .. Also from any series holding them, so cancelling it later leaves them alone
+        for (QVector<unsigned long long>& hours: series) ClearHours(hours, startHours, endHours);
+        // .. Words past the end were never booked
+        if (startHours / 64 < times.size()) TouchWords(startHours / 64, qMin(endHours / 64, (long)times.size() - 1));
+        EVIES_COUNT(ReservationsRemoved);
         return true;
     }
+
+    // Generated catalogs
+    void SpaceManager::GetRandomizedSpaces(int n, quint64 p_seed) {
+        SetSpaces(Workload::MakeSpaces(n, p_seed));
+    }
+    // Catalog lookups
+    space::Space* SpaceManager::FindSpace(unsigned int p_ID) const {
+        EVIES_TIME_SCOPE(FindSpaceTimer);
+        for (space::Space* space_ptr: spaces) {
+            if (space_ptr->GetID() == p_ID) return space_ptr;
+        }
+        return nullptr;
+    }
+
+    // Memory accounting
+    void Space::AccountMemory(MemoryUsage& p_usage) const {
+        p_usage.AddQObject(MemoryUsage::Objects, sizeof(Space));
+        p_usage.AddString(MemoryUsage::Strings, name);
+        p_usage.AddVector(MemoryUsage::Strings, tags);
+        for (const QString& tag: tags) p_usage.AddString(MemoryUsage::Strings, tag);
+        if (m_dims) p_usage.AddQObject(MemoryUsage::Objects, sizeof(Dimensions));
+        if (m_seats) p_usage.AddQObject(MemoryUsage::Objects, sizeof(Seating));
+        if (m_timer) {
+            p_usage.AddQObject(MemoryUsage::Objects, sizeof(Time));
+            p_usage.AddVector(MemoryUsage::Availability, m_timer->GetWords());
+            p_usage.AddVector(MemoryUsage::Availability, m_timer->GetOccupancyIndex());
+            for (unsigned int ID: m_timer->GetSeriesIDs()) p_usage.AddVector(MemoryUsage::Availability, m_timer->GetSeriesTimes(ID));
+        }
+        if (m_review) {
+            p_usage.AddQObject(MemoryUsage::Objects, sizeof(Review));
+            // .. The copy shares the list, the texts are counted once each
+            const QVector<QString> reviews = m_review->GetReviews();
+            p_usage.AddVector(MemoryUsage::Reviews, reviews);
+            for (const QString& review: reviews) p_usage.AddString(MemoryUsage::Reviews, review);
+        }
+    }
+    void SpaceManager::AccountMemory(MemoryUsage& p_usage) const {
+        p_usage.spaces += spaces.size();
+        p_usage.AddVector(MemoryUsage::Objects, spaces);
+        for (const space::Space* space_ptr: spaces) space_ptr->AccountMemory(p_usage);
+    }
 }
@@ -4,14 +4,52 @@
 #include <QObject>
 #include <QVector>
 #include <QString>
-#include <qqml.h>
+#include <QHash>
+#include <QThread>
 
 // User libraries
+#include "metrics.h"
 #include <string>
 #include <vector>
 #include <ctime>
 
 namespace space {
+    class MemoryUsage;
+
+    // Deferred, de-duplicated change notifications
+    // .. Between BeginUpdate and the matching EndUpdate, setters only record
+    // .. which properties changed, the outermost EndUpdate emits each signal once
+    class PendingChanges {
+    private:
+        int depth = 0;
+        unsigned int pending = 0;
+    public:
+        void Begin() { depth++; }
+        // True if the change was recorded instead of needing an emit now
+        bool Defer(unsigned int p_properties) {
+            if (depth == 0) return false;
+            pending |= p_properties;
+            return true;
+        }
+        // Properties to emit, non-zero only when the outermost update ends
+        unsigned int End() {
+            if (depth == 0 || --depth > 0) return 0;
+            unsigned int properties = pending;
+            pending = 0;
+            return properties;
+        }
+        bool IsUpdating() const { return depth > 0; }
+    };
+
+    // Scope guard for BeginUpdate / EndUpdate
+    template <typename T> class UpdateScope {
+    private:
+        T& target;
+    public:
+        explicit UpdateScope(T& p_target) : target(p_target) { target.BeginUpdate(); }
+        ~UpdateScope() { target.EndUpdate(); }
+    };
+
     // Class for space dimensions
     // .. Currently assume box-like spaces with length-width-height
     class Dimensions : public QObject {
@@ -31,6 +69,17 @@ namespace space {
         float length = 0, width = 0, height = 0;
         float area = 0, aspectRatio = 0;
         void UpdateAAR();
+
+        // Change notifications
+        enum Property : unsigned int {
+            LengthProperty      = 1 << 0,
+            WidthProperty       = 1 << 1,
+            HeightProperty      = 1 << 2,
+            AreaProperty        = 1 << 3,
+            AspectRatioProperty = 1 << 4
+        };
+        PendingChanges changes;
+        void Changed(unsigned int p_properties);
     public:
         // Constructors & destructors
         explicit Dimensions(QObject *parent = nullptr) {}
@@ -43,6 +92,11 @@ namespace space {
         void SetHeight(float p_height);
         void SetDimensions(float p_length, float p_width, float p_height);
 
+        // Transactions
+        // .. EndUpdate returns true if anything changed since BeginUpdate
+        void BeginUpdate() { changes.Begin(); }
+        bool EndUpdate();
+
         // Getters
         float GetLength() const { return length; }
         float GetWidth() const { return width; }
@@ -71,6 +125,16 @@ namespace space {
         bool surround = false;
         // For if the chairs are not cheap plastic
         bool comfy = true;
+
+        // Change notifications
+        enum Property : unsigned int {
+            NumberOfSeatsProperty = 1 << 0,
+            SlantedProperty       = 1 << 1,
+            SurroundProperty      = 1 << 2,
+            ComfyProperty         = 1 << 3
+        };
+        PendingChanges changes;
+        void Changed(unsigned int p_properties);
     public:
         // Constructors & destructors
         explicit Seating(QObject *parent = nullptr) : QObject(parent) {}
@@ -88,6 +152,10 @@ namespace space {
         void IsSurround(bool p_surround);
         void IsComfy(bool p_comfy);
 
+        // Transactions
+        void BeginUpdate() { changes.Begin(); }
+        bool EndUpdate();
+
         // Getters
         bool IsSlanted() const { return slanted; }
         bool IsSurround() const { return surround; }
@@ -95,6 +163,22 @@ namespace space {
         unsigned int GetNumberOfSeats() const { return numberOfSeats; }
     };
 
+    // Rule for a repeating reservation, see Time::AddSeries
+    // .. Times are UTC like the hour bitmaps
+    // .. Occurrences stop after count, or with the last one starting by until,
+    // .. whichever comes first, a rule needs at least one of the two
+    struct Recurrence {
+        enum Frequency { Daily, Weekly, MonthlyByWeekday };
+        Frequency frequency = Weekly;
+        // Every interval days, weeks or months
+        unsigned int interval = 1;
+        // MonthlyByWeekday: the ordinal-th of the first occurrence's weekday in
+        // .. the month, 1 to 5 (months without one are skipped) or -1 for the last
+        int ordinal = 1;
+        unsigned int count = 0;
+        time_t until = 0;
+    };
+
     // Class for available times
     // .. Assume accomodative spaces: working all day
     class Time : public QObject {
@@ -105,6 +189,8 @@ namespace space {
     signals:
         void DirhamsPerHourChanged();
         void TimesChanged();
+        // Words [first, last] of times changed, sent right before TimesChanged
+        void WordsChanged(int first, int last);
     private:
         time_t originTime;
         // Using a list of unsigned long long integers
@@ -115,6 +201,26 @@ namespace space {
         QVector<unsigned long long> times;
         // Price per hour
         double dirhamsPerHour = 0;
+        // Booked hours of each recurring reservation, by series ID
+        QHash<unsigned int, QVector<unsigned long long>> series;
+        unsigned int nextSeries = 1;
+        // Occupancy index: Fenwick tree over the popcount of each word, 1-based
+        // .. Built by the first CountBooked, then kept up to date by TouchWords
+        mutable QVector<int> occupancy;
+        void BuildOccupancy() const;
+        // Booked hours in words [0, p_words)
+        int WordPrefix(int p_words) const;
+
+        // Change notifications
+        enum Property : unsigned int {
+            DirhamsPerHourProperty = 1 << 0,
+            TimesProperty          = 1 << 1
+        };
+        PendingChanges changes;
+        void Changed(unsigned int p_properties);
+        // Words touched since the last TimesChanged
+        int dirtyFirstWord = -1, dirtyLastWord = -1;
+        void TouchWords(int p_first, int p_last);
     public:
         Time(QObject *parent = nullptr);
         Time(double p_dirhamsPerHour, QObject *parent = nullptr);
@@ -122,10 +228,80 @@ namespace space {
         virtual ~Time() {}
         // Setters
         void SetDirhamsPerHour(double p_dirhamsPerHour);
+        // Transactions
+        // .. Many reservations inside one update emit TimesChanged once
+        void BeginUpdate() { changes.Begin(); }
+        bool EndUpdate();
         // Getters
         double GetDirhamsPerHour() const { return dirhamsPerHour; }
         time_t GetOriginTime() const { return originTime; }
         QVector<unsigned long long> GetTimes() const { return times; }
+        // Direct read of the bitmap words without sharing them, same thread only
+        const QVector<unsigned long long>& GetWords() const { return times; }
+
+        // Hour index helpers
+        // .. Hour h covers [originTime + h * 3600, originTime + (h + 1) * 3600)
+        // .. Negative results are before the origin and cannot be booked, far times saturate
+        long HourOf(const time_t& p_time) const;
+        // Hours a single booking may cover: from the origin, in order, ending within MaxSeriesHours
+        // .. Keeps client-supplied ranges from growing the bitmap without bound
+        static bool IsBookable(long p_startHour, long p_endHour) {
+            return p_startHour >= 0 && p_endHour >= p_startHour && p_endHour <= (long)MaxSeriesHours;
+        }
+        time_t TimeOfHour(unsigned long p_hour) const { return originTime + (time_t)p_hour * 3600; }
+
+        // Word-level range operations on hour bitmaps
+        // .. Hours are inclusive on both ends, words are grown on demand
+        static unsigned long long WordMask(unsigned int p_low, unsigned int p_high) {
+            return (~0ULL >> (63 - p_high)) & (~0ULL << p_low);
+        }
+        static void SetHours(QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour);
+        static void ClearHours(QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour);
+        static bool AnyHours(const QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour);
+        // .. Same over p_words raw words, for bitmaps that are not in a QVector (shared catalog)
+        static bool AnyHours(const unsigned long long* p_times, int p_words, unsigned long p_startHour, unsigned long p_endHour);
+        static unsigned int CountHours(const QVector<unsigned long long>& p_times, unsigned long p_startHour, unsigned long p_endHour);
+        // Bitmap with every hour moved by p_hours, later if positive
+        // .. Hours moved before hour 0 are dropped
+        static QVector<unsigned long long> ShiftHours(const QVector<unsigned long long>& p_times, long p_hours);
+        bool IsFree(unsigned long p_startHour, unsigned long p_endHour) const { return !AnyHours(times, p_startHour, p_endHour); }
+        // Booked hours in [p_startHour, p_endHour] in O(log n) through the occupancy index
+        // .. The first call builds the index, do not count from another thread than the writer's
+        // .. unless PrepareCounts ran there first
+        unsigned int CountBooked(unsigned long p_startHour, unsigned long p_endHour) const;
+        // Builds the occupancy index now if no count has, later counts only read it
+        void PrepareCounts() const { if (occupancy.isEmpty()) BuildOccupancy(); }
+        // Booked hours in [p_from, p_to), hours before the origin are not bookable
+        unsigned int CountBookedBetween(const time_t& p_from, const time_t& p_to) const;
+        // Hours of [p_from, p_to) from the origin on
+        unsigned int CountBookable(const time_t& p_from, const time_t& p_to) const;
+        // Index words for memory accounting, empty until the first count
+        const QVector<int>& GetOccupancyIndex() const { return occupancy; }
+
+        // Merge a bitmap of booked hours in one pass
+        // .. Used by bulk importers, notifies TimesChanged once
+        void MergeTimes(const QVector<unsigned long long>& p_times);
+
+        // Civil date <-> days since 1970-01-01 (proleptic Gregorian)
+        static long DaysFromCivil(long y, unsigned int m, unsigned int d);
+        static void CivilFromDays(long z, long& y, unsigned int& m, unsigned int& d);
+
+        // Recurring reservations
+        // .. Series, like single bookings, end within this many hours of the origin
+        enum { MaxSeriesHours = 10 * 366 * 24 };
+        // Hours of every occurrence of p_rule, the first being [p_startTime, p_endTime]
+        // .. Daily and weekly rules are one occurrence copied by doubling shifts, word-wide
+        // .. Empty for an invalid rule, an endless one or occurrences overlapping each other
+        QVector<unsigned long long> SeriesHours(const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule) const;
+        // Books every occurrence or none, returns the series ID, 0 on a conflict or invalid rule
+        // .. param price to return the price of the whole series
+        unsigned int AddSeries(const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule, double& price);
+        // Replaces a series in place, the old hours stay booked if the new ones conflict
+        bool ModifySeries(unsigned int p_series, const time_t& p_startTime, const time_t& p_endTime, const Recurrence& p_rule, double& price);
+        bool RemoveSeries(unsigned int p_series);
+        // Hours still held by a series, occurrences removed one by one are not
+        QVector<unsigned long long> GetSeriesTimes(unsigned int p_series) const { return series.value(p_series); }
+        QList<unsigned int> GetSeriesIDs() const { return series.keys(); }
 
         // Function to reserve
         // .. param price to return the price
@@ -152,6 +328,22 @@ namespace space {
         unsigned int numberOfReviews = 0;
         bool reviewed = false;
         QVector<QString> reviews;
+
+        // Change notifications
+        enum Property : unsigned int {
+            ScoreProperty           = 1 << 0,
+            NumberOfReviewsProperty = 1 << 1,
+            ReviewedProperty        = 1 << 2,
+            ReviewsProperty         = 1 << 3
+        };
+        PendingChanges changes;
+        void Changed(unsigned int p_properties) {
+            if (changes.Defer(p_properties)) return;
+            if (p_properties & ScoreProperty) emit ScoreChanged();
+            if (p_properties & NumberOfReviewsProperty) emit NumberOfReviewsChanged();
+            if (p_properties & ReviewedProperty) emit ReviewedChanged();
+            if (p_properties & ReviewsProperty) emit ReviewsChanged();
+        }
     public:
         // Constructors & destructors
         explicit Review(float p_score = 0, QObject* parent = nullptr) : QObject(parent) {
@@ -162,11 +354,31 @@ namespace space {
         // Setters
         // Add a review
         Q_INVOKABLE void AddReview(const QString& p_review, float p_score) {
+            EVIES_TIME_SCOPE(AddReviewTimer);
+            EVIES_COUNT(ReviewsAdded);
             reviewed = true;
             reviews.push_back(p_review);
-            score = (score * numberOfReviews + p_score) / (++numberOfReviews);
-            emit ReviewsChanged();
-            emit ReviewedChanged();
+            score = (score * numberOfReviews + p_score) / (numberOfReviews + 1);
+            numberOfReviews++;
+            Changed(ScoreProperty | NumberOfReviewsProperty | ReviewedProperty | ReviewsProperty);
+        }
+
+        // Replace every review, e.g. when loading a saved catalog
+        // .. p_score is the stored average, individual scores are not kept
+        void SetReviews(const QVector<QString>& p_reviews, float p_score) {
+            reviews = p_reviews;
+            numberOfReviews = p_reviews.size();
+            reviewed = !p_reviews.isEmpty();
+            score = p_score;
+            Changed(ScoreProperty | NumberOfReviewsProperty | ReviewedProperty | ReviewsProperty);
+        }
+
+        // Transactions
+        void BeginUpdate() { changes.Begin(); }
+        bool EndUpdate() {
+            unsigned int properties = changes.End();
+            if (properties) Changed(properties);
+            return properties != 0;
         }
 
         // Getters
@@ -246,6 +458,34 @@ namespace space {
 
         // Miscellaneous tags
         QVector<QString> tags;
+
+        // Change notifications
+        enum Property : unsigned int {
+            IDProperty              = 1 << 0,
+            NameProperty            = 1 << 1,
+            NumberOfPeopleProperty  = 1 << 2,
+            OutdoorProperty         = 1 << 3,
+            CateringProperty        = 1 << 4,
+            NaturalLightProperty    = 1 << 5,
+            ArtificialLightProperty = 1 << 6,
+            ProjectorProperty       = 1 << 7,
+            SoundProperty           = 1 << 8,
+            CamerasProperty         = 1 << 9
+        };
+        PendingChanges changes;
+        void Changed(unsigned int p_properties) {
+            if (changes.Defer(p_properties)) return;
+            if (p_properties & IDProperty) emit IDChanged();
+            if (p_properties & NameProperty) emit NameChanged();
+            if (p_properties & NumberOfPeopleProperty) emit NumberOfPeopleChanged();
+            if (p_properties & OutdoorProperty) emit OutdoorChanged();
+            if (p_properties & CateringProperty) emit CateringChanged();
+            if (p_properties & NaturalLightProperty) emit NaturalLightChanged();
+            if (p_properties & ArtificialLightProperty) emit ArtificialLightChanged();
+            if (p_properties & ProjectorProperty) emit ProjectorChanged();
+            if (p_properties & SoundProperty) emit SoundChanged();
+            if (p_properties & CamerasProperty) emit CamerasChanged();
+        }
     public:
         // Needs to be pointers as QML takes ownership
 //        Dimensions* m_dims;
@@ -257,6 +497,7 @@ namespace space {
             m_dims = nullptr;
             m_seats = nullptr;
             m_timer = nullptr;
+            m_review = nullptr;
         }
         // Creating a new space
         Space(
@@ -311,49 +552,81 @@ namespace space {
             delete m_dims;
             delete m_seats;
             delete m_timer;
+            delete m_review;
+        }
+
+        // Transactions
+        // .. Also holds back the dimensions, seating, timer and review signals
+        void BeginUpdate() {
+            changes.Begin();
+            if (m_dims) m_dims->BeginUpdate();
+            if (m_seats) m_seats->BeginUpdate();
+            if (m_timer) m_timer->BeginUpdate();
+            if (m_review) m_review->BeginUpdate();
+        }
+        bool EndUpdate() {
+            unsigned int properties = changes.End();
+            bool changed = properties != 0;
+            if (m_dims) changed |= m_dims->EndUpdate();
+            if (m_seats) changed |= m_seats->EndUpdate();
+            if (m_timer) changed |= m_timer->EndUpdate();
+            if (m_review) changed |= m_review->EndUpdate();
+            if (properties) Changed(properties);
+            return changed;
+        }
+
+        // Threads
+        // .. The parts are not QObject children, they move along with the space
+        // .. Call from the thread the space currently lives in
+        void MoveToThread(QThread* p_thread) {
+            moveToThread(p_thread);
+            if (m_dims) m_dims->moveToThread(p_thread);
+            if (m_seats) m_seats->moveToThread(p_thread);
+            if (m_timer) m_timer->moveToThread(p_thread);
+            if (m_review) m_review->moveToThread(p_thread);
         }
 
         // Setters
         void Rename(const QString& p_name) {
             name = p_name;
-            emit NameChanged();
+            Changed(NameProperty);
         }
         void SetID(unsigned int p_ID) {
             ID = p_ID;
-            emit IDChanged();
+            Changed(IDProperty);
         }
         void SetNumberOfPeople(int p_numberOfPeople) {
             numberOfPeople = p_numberOfPeople;
-            emit NumberOfPeopleChanged();
+            Changed(NumberOfPeopleProperty);
         }
         // Setters using overload
         void IsOutdoor(bool p_outdoor) {
             outdoor = p_outdoor;
-            emit OutdoorChanged();
+            Changed(OutdoorProperty);
         }
         void IsCatering(bool p_catering) {
             catering = p_catering;
-            emit CateringChanged();
+            Changed(CateringProperty);
         }
         void IsNaturalLight(bool p_naturalLight) {
             naturalLight = p_naturalLight;
-            emit NaturalLightChanged();
+            Changed(NaturalLightProperty);
         }
         void IsArtificialLight(bool p_artificialLight) {
             artificialLight = p_artificialLight;
-            emit ArtificialLightChanged();
+            Changed(ArtificialLightProperty);
         }
         void IsProjector(bool p_projector) {
             projector = p_projector;
-            emit ProjectorChanged();
+            Changed(ProjectorProperty);
         }
         void IsSound(bool p_sound) {
             sound = p_sound;
-            emit SoundChanged();
+            Changed(SoundProperty);
         }
         void IsCameras(bool p_cameras) {
             cameras = p_cameras;
-            emit CamerasChanged();
+            Changed(CamerasProperty);
         }
 
         // Getters
@@ -372,58 +645,69 @@ namespace space {
         Seating& GetSeats() const { return *m_seats; }
         Time& GetTimer() const { return *m_timer; }
         Review& GetReview() const { return *m_review; }
+
+        // Memory accounting
+        // .. The space and its parts, name and tags, bitmap, reviews
+        void AccountMemory(MemoryUsage& p_usage) const;
     };
 
     // Class to manage spaces
     // (running backbone of the application)
     class SpaceManager : public QObject {
+        Q_OBJECT
+    signals:
+        // The spaces vector was replaced
+        void SpacesChanged();
+        // Spaces [first, last] changed during an update
+        // .. CatalogStore flushes on it, models get the whole update as one RecordsChanged
+        void SpacesUpdated(int first, int last);
     private:
         QVector<space::Space*> spaces;
+        int updateDepth = 0;
     public:
         // Constructors & destructors
         explicit SpaceManager(QObject* parent = nullptr) : QObject(parent) {}
         virtual ~SpaceManager(){}
 
-        // Testing purposes
-        void GetRandomizedSpaces(int n){
-            spaces = QVector<space::Space*>{};
-            std::srand(time(NULL));
-            for (int i = 0; i < n; i++) {
-                spaces.push_back(
-                    new space::Space{
-                        i,                                      // ID
-                        QString::fromStdString("Space"          // name
-                            + std::to_string(i)),
-
-                                                                // For dimensions
-                        rand() % 90 + 10,                       // length
-                        rand() % 45 + 5,                        // width
-                        rand() % 10 + 2,                        // height
-
-                        rand() % 990 + 10,                      // number of people
-
-                                                                // For seats
-                        rand() % 490 + 10,                      // number of seats
-                        (bool)(rand() % 2),                     // slanted?
-                        (bool)(rand() % 2),                     // surround?
-                        (bool)(rand() % 2),                     // comfy?
-
-                                                                // For timer
-                        rand() % 9900 + 100,                    // price
-
-                        (bool)(rand() % 2),                     // outdoor?
-                        (bool)(rand() % 2),                     // catering?
-                        (bool)(rand() % 2),                     // naturalLight?
-                        (bool)(rand() % 2),                     // artificialLight?
-                        (bool)(rand() % 2),                     // sound?
-                        (bool)(rand() % 2),                     // projector?
-                        (bool)(rand() % 2)                      // camera?
-                    }
-                );
-                spaces.back()->GetReview().AddReview("Very bad, not good", rand() % 5);
-                spaces.back()->GetReview().AddReview("Okay ish", rand() % 5);
+        // Getters
+        const QVector<space::Space*>& GetSpaces() const { return spaces; }
+        // Live space by ID for QML pages, nullptr if unknown
+        // .. Ownership stays with the manager
+        Q_INVOKABLE space::Space* FindSpace(unsigned int p_ID) const;
+        // Adds every space, see MemoryUsage
+        void AccountMemory(MemoryUsage& p_usage) const;
+
+        // Transactions
+        // .. Puts every space in an update, the outermost EndUpdate flushes their
+        // .. signals once per object and property, then emits one SpacesUpdated
+        // .. Do not replace the spaces while an update is open
+        void BeginUpdate() {
+            if (updateDepth++ > 0) return;
+            for (space::Space* space_ptr: spaces) space_ptr->BeginUpdate();
+        }
+        void EndUpdate() {
+            if (updateDepth == 0 || --updateDepth > 0) return;
+            EVIES_TIME_SCOPE(ManagerUpdateTimer);
+            int first = -1, last = -1;
+            for (int i = 0; i < spaces.size(); i++) {
+                if (spaces[i]->EndUpdate()) {
+                    if (first < 0) first = i;
+                    last = i;
+                }
             }
+            if (first >= 0) emit SpacesUpdated(first, last);
+        }
+
+        // Replace the spaces, e.g. with ones built on a loader thread
+        void SetSpaces(const QVector<space::Space*>& p_spaces) {
+            EVIES_TIME_SCOPE(SetSpacesTimer);
+            spaces = p_spaces;
+            emit SpacesChanged();
         }
+
+        // Testing purposes
+        // .. Seeded, the same seed gives the same catalog, see Workload::MakeSpaces
+        void GetRandomizedSpaces(int n, quint64 p_seed = 1);
     };
 }
 
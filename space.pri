@@ -0,0 +1,50 @@
+# Catalog, reservation and protocol sources shared by every target
+QT += concurrent
+# Instrumentation is compiled in by default, uncomment to strip it
+# DEFINES += EVIES_NO_METRICS
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/space.cpp \
+    $$PWD/metrics.cpp \
+    $$PWD/memoryusage.cpp \
+    $$PWD/ical.cpp \
+    $$PWD/spacequery.cpp \
+    $$PWD/spacesummary.cpp \
+    $$PWD/catalogstore.cpp \
+    $$PWD/reservationstore.cpp \
+    $$PWD/sharedcatalog.cpp \
+    $$PWD/spacelistmodel.cpp \
+    $$PWD/searchindex.cpp \
+    $$PWD/workload.cpp \
+    $$PWD/catalogfile.cpp \
+    $$PWD/superspace.cpp \
+    $$PWD/groupbooking.cpp \
+    $$PWD/waitlist.cpp \
+    $$PWD/availabilityfeed.cpp \
+    $$PWD/occupancy.cpp \
+    $$PWD/bookingprotocol.cpp
+
+HEADERS += \
+    $$PWD/space.h \
+    $$PWD/metrics.h \
+    $$PWD/parallel.h \
+    $$PWD/memoryusage.h \
+    $$PWD/ical.h \
+    $$PWD/spacequery.h \
+    $$PWD/recordschema.h \
+    $$PWD/spacesummary.h \
+    $$PWD/catalogstore.h \
+    $$PWD/reservationstore.h \
+    $$PWD/sharedcatalog.h \
+    $$PWD/spacelistmodel.h \
+    $$PWD/searchindex.h \
+    $$PWD/workload.h \
+    $$PWD/catalogfile.h \
+    $$PWD/superspace.h \
+    $$PWD/groupbooking.h \
+    $$PWD/waitlist.h \
+    $$PWD/availabilityfeed.h \
+    $$PWD/occupancy.h \
+    $$PWD/bookingprotocol.h
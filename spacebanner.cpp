@@ -0,0 +1,294 @@
+#include <QObject>
+#include <QString>
+#include <QFont>
+#include <QImage>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QMutexLocker>
+#include <QVector>
+#include <QSGSimpleRectNode>
+
+// User libraries
+#include "spacebanner.h"
+#include "memoryusage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace space {
+    // Label cache
+    QMutex BannerLabelCache::windowsLock;
+    QHash<QQuickWindow*, BannerLabelCache*> BannerLabelCache::windows;
+
+    BannerLabelCache* BannerLabelCache::ForWindow(QQuickWindow* p_window) {
+        QMutexLocker locker(&windowsLock);
+        BannerLabelCache* cache = windows.value(p_window);
+        if (!cache) {
+            cache = new BannerLabelCache(p_window);
+            windows.insert(p_window, cache);
+            // Textures belong to the scene graph, drop them with it (render thread)
+            QObject::connect(p_window, &QQuickWindow::sceneGraphInvalidated, [p_window]() {
+                QMutexLocker locker(&windowsLock);
+                delete windows.take(p_window);
+            });
+        }
+        return cache;
+    }
+    BannerLabelCache::~BannerLabelCache() {
+        for (Label* label: labels) Delete(label);
+    }
+    void BannerLabelCache::Delete(Label* p_label) {
+        MemoryUsage::TrackFacade(MemoryUsage::BannerLabelFacade, -1, -p_label->bytes);
+        delete p_label->texture;
+        delete p_label;
+    }
+    BannerLabelCache::Label* BannerLabelCache::Acquire(const QString& p_text, Style p_style) {
+        const QString key = QString::number(p_style) + QLatin1Char('\x1f') + p_text;
+        Label* label = labels.value(key);
+        if (!label) {
+            QFont font;
+            QColor color(0x21, 0x21, 0x21);
+            switch (p_style) {
+            case Title: font.setPointSize(20); font.setBold(true); break;
+            case Heading: font.setBold(true); break;
+            case Price: font.setPointSize(22); font.setBold(true); break;
+            case Light: font.setWeight(QFont::Light); color = QColor(0x61, 0x61, 0x61); break;
+            default: break;
+            }
+            label = new Label();
+            label->layout.setText(p_text);
+            label->layout.setTextFormat(Qt::PlainText);
+            label->layout.prepare(QTransform(), font);
+            label->size = label->layout.size();
+            // Rasterize at device resolution
+            const qreal ratio = window->effectiveDevicePixelRatio();
+            QImage image(qMax(1, (int)std::ceil(label->size.width() * ratio)),
+                         qMax(1, (int)std::ceil(label->size.height() * ratio)),
+                         QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(ratio);
+            image.fill(Qt::transparent);
+            QPainter painter(&image);
+            painter.setFont(font);
+            painter.setPen(color);
+            painter.drawStaticText(0, 0, label->layout);
+            painter.end();
+            label->texture = window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel);
+            // .. Texture pixels plus the label, the glyph layout is not counted
+            label->bytes = (qint64)image.width() * image.height() * 4 + sizeof(Label);
+            MemoryUsage::TrackFacade(MemoryUsage::BannerLabelFacade, 1, label->bytes);
+            labels.insert(key, label);
+        } else if (label->references == 0) {
+            unreferenced--;
+        }
+        label->references++;
+        label->lastUse = ++clock;
+        return label;
+    }
+    void BannerLabelCache::Release(Label* p_label) {
+        if (--p_label->references > 0) return;
+        if (++unreferenced > MaxUnreferenced) Evict();
+    }
+    void BannerLabelCache::Evict() {
+        // Keep the most recently used half of the unreferenced labels
+        QVector<quint64> uses;
+        for (Label* label: labels)
+            if (label->references == 0) uses.append(label->lastUse);
+        std::nth_element(uses.begin(), uses.begin() + uses.size() / 2, uses.end());
+        const quint64 cutoff = uses[uses.size() / 2];
+        for (QHash<QString, Label*>::iterator it = labels.begin(); it != labels.end();) {
+            Label* label = it.value();
+            if (label->references == 0 && label->lastUse < cutoff) {
+                Delete(label);
+                unreferenced--;
+                it = labels.erase(it);
+            } else ++it;
+        }
+    }
+
+    // Label nodes
+    QSizeF BannerLabelNode::SetLabel(const QString& p_text, BannerLabelCache::Style p_style) {
+        // Acquire first, the same text keeps its texture alive across the swap
+        BannerLabelCache::Label* next = cache->Acquire(p_text, p_style);
+        if (label) cache->Release(label);
+        label = next;
+        setTexture(label->texture);
+        return label->size;
+    }
+
+    // Banner
+    SpaceBanner::SpaceBanner(QQuickItem* parent) : QQuickItem(parent) {
+        setFlag(ItemHasContents, true);
+        setAcceptedMouseButtons(Qt::LeftButton);
+        setImplicitSize(600, 150);
+        MemoryUsage::TrackFacade(MemoryUsage::SpaceBannerFacade, 1, sizeof(SpaceBanner) + MemoryUsage::QQuickItemPrivateBytes);
+    }
+    SpaceBanner::~SpaceBanner() {
+        MemoryUsage::TrackFacade(MemoryUsage::SpaceBannerFacade, -1, -(qint64)(sizeof(SpaceBanner) + MemoryUsage::QQuickItemPrivateBytes));
+    }
+    // Setters
+    void SpaceBanner::SetName(const QString& p_name) {
+        if (name == p_name) return;
+        name = p_name;
+        Invalidate(1u << NameSlot);
+        emit NameChanged();
+    }
+    void SpaceBanner::SetPrimaryTag(const QString& p_primaryTag) {
+        if (primaryTag == p_primaryTag) return;
+        primaryTag = p_primaryTag;
+        Invalidate(1u << PrimaryTagSlot);
+        emit PrimaryTagChanged();
+    }
+    void SpaceBanner::SetSecondaryTags(const QString& p_secondaryTags) {
+        if (secondaryTags == p_secondaryTags) return;
+        secondaryTags = p_secondaryTags;
+        Invalidate(1u << SecondaryTagsSlot);
+        emit SecondaryTagsChanged();
+    }
+    void SpaceBanner::SetArea(float p_area) {
+        if (area == p_area) return;
+        area = p_area;
+        Invalidate(1u << AreaSlot);
+        emit AreaChanged();
+    }
+    void SpaceBanner::SetNumberOfSeats(unsigned int p_numberOfSeats) {
+        if (numberOfSeats == p_numberOfSeats) return;
+        numberOfSeats = p_numberOfSeats;
+        Invalidate(1u << SeatingSlot);
+        emit NumberOfSeatsChanged();
+    }
+    void SpaceBanner::SetNumberOfPeople(unsigned int p_numberOfPeople) {
+        if (numberOfPeople == p_numberOfPeople) return;
+        numberOfPeople = p_numberOfPeople;
+        Invalidate(1u << PeopleSlot);
+        emit NumberOfPeopleChanged();
+    }
+    void SpaceBanner::IsCatering(bool p_catering) {
+        if (catering == p_catering) return;
+        catering = p_catering;
+        Invalidate(1u << CateringSlot);
+        emit CateringChanged();
+    }
+    void SpaceBanner::SetDirhamsPerHour(double p_dirhamsPerHour) {
+        if (dirhamsPerHour == p_dirhamsPerHour) return;
+        dirhamsPerHour = p_dirhamsPerHour;
+        Invalidate(1u << PriceSlot);
+        emit DirhamsPerHourChanged();
+    }
+    void SpaceBanner::SetScore(float p_score) {
+        if (score == p_score) return;
+        score = p_score;
+        Invalidate(1u << ReviewSlot);
+        emit ScoreChanged();
+    }
+    void SpaceBanner::SetNumberOfReviews(unsigned int p_numberOfReviews) {
+        if (numberOfReviews == p_numberOfReviews) return;
+        numberOfReviews = p_numberOfReviews;
+        Invalidate(1u << ReviewSlot);
+        emit NumberOfReviewsChanged();
+    }
+    void SpaceBanner::SetSummary(const SpaceSummary& p_summary) {
+        if (summary == p_summary) return;
+        summary = p_summary;
+        // .. Each setter only redraws the slots whose text changed
+        SetName(summary.name);
+        SetSecondaryTags(summary.GetTags());
+        SetArea(summary.area);
+        SetNumberOfSeats(summary.numberOfSeats);
+        SetNumberOfPeople(summary.numberOfPeople);
+        IsCatering(summary.IsCatering());
+        SetDirhamsPerHour(summary.dirhamsPerHour);
+        SetScore(summary.score);
+        SetNumberOfReviews(summary.numberOfReviews);
+        emit SummaryChanged();
+    }
+
+    // Layout, mirrors TextBanner.qml
+    QString SpaceBanner::SlotText(int p_slot) const {
+        switch (p_slot) {
+        case NameSlot: return name;
+        case PrimaryTagSlot: return primaryTag;
+        case SecondaryTagsSlot: return secondaryTags;
+        case AreaHeadingSlot: return tr("Area");
+        case SeatingHeadingSlot: return tr("Seating");
+        case PeopleHeadingSlot: return tr("No. of Ppl.");
+        case CateringHeadingSlot: return tr("Catering");
+        case AreaSlot: return QString::number(qRound(area)) + QString::fromUtf8(" m²");
+        case SeatingSlot: return QString::number(numberOfSeats);
+        case PeopleSlot: return QString::number(numberOfPeople);
+        case CateringSlot: return catering ? tr("Yes") : tr("No");
+        case PriceSlot: return QString::number(dirhamsPerHour) + tr(" Dhs");
+        case PriceHeadingSlot: return tr("Price per hour");
+        case ReviewSlot: return tr("%1 / 5 - %2 reviews").arg(score, 0, 'f', 1).arg(numberOfReviews);
+        default: return QString();
+        }
+    }
+    BannerLabelCache::Style SpaceBanner::SlotStyle(int p_slot) {
+        switch (p_slot) {
+        case NameSlot: return BannerLabelCache::Title;
+        case AreaHeadingSlot: case SeatingHeadingSlot: case PeopleHeadingSlot: case CateringHeadingSlot:
+            return BannerLabelCache::Heading;
+        case PriceSlot: return BannerLabelCache::Price;
+        case ReviewSlot: return BannerLabelCache::Light;
+        default: return BannerLabelCache::Body;
+        }
+    }
+    QPointF SpaceBanner::SlotPosition(int p_slot, const QSizeF& p_size, qreal p_width) {
+        switch (p_slot) {
+        case NameSlot: return QPointF(20, 18);
+        case PrimaryTagSlot: return QPointF(30, 52);
+        case SecondaryTagsSlot: return QPointF(30, 72);
+        case AreaHeadingSlot: case SeatingHeadingSlot: case PeopleHeadingSlot: case CateringHeadingSlot:
+            return QPointF(20 + 90 * (p_slot - AreaHeadingSlot), 98);
+        case AreaSlot: case SeatingSlot: case PeopleSlot: case CateringSlot:
+            return QPointF(20 + 90 * (p_slot - AreaSlot), 116);
+        // .. Right column is right aligned
+        case PriceSlot: return QPointF(p_width - 12 - p_size.width(), 24);
+        case PriceHeadingSlot: return QPointF(p_width - 12 - p_size.width(), 62);
+        case ReviewSlot: return QPointF(p_width - 12 - p_size.width(), 82);
+        default: return QPointF();
+        }
+    }
+
+    // Scene graph
+    // .. Node tree: background, divider, then one label node per slot
+    QSGNode* SpaceBanner::updatePaintNode(QSGNode* p_oldNode, UpdatePaintNodeData* p_data) {
+        Q_UNUSED(p_data);
+        QSGNode* root = p_oldNode;
+        if (!root) {
+            BannerLabelCache* cache = BannerLabelCache::ForWindow(window());
+            root = new QSGNode();
+            root->appendChildNode(new QSGSimpleRectNode(QRectF(), Qt::white));
+            root->appendChildNode(new QSGSimpleRectNode(QRectF(), QColor(0xe0, 0xe0, 0xe0)));
+            for (int slot = 0; slot < SlotCount; slot++) root->appendChildNode(new BannerLabelNode(cache));
+            dirtySlots = ~0u;
+        }
+        const qreal w = width(), h = height();
+        QSGNode* child = root->firstChild();
+        static_cast<QSGSimpleRectNode*>(child)->setRect(0, 0, w, h);
+        child = child->nextSibling();
+        static_cast<QSGSimpleRectNode*>(child)->setRect(0, h - 1, w, 1);
+        child = child->nextSibling();
+        for (int slot = 0; slot < SlotCount; slot++, child = child->nextSibling()) {
+            BannerLabelNode* node = static_cast<BannerLabelNode*>(child);
+            // Only changed slots go back to the cache, the rest keep their texture
+            const QSizeF size = (dirtySlots & (1u << slot)) ? node->SetLabel(SlotText(slot), SlotStyle(slot)) : node->rect().size();
+            node->setRect(QRectF(SlotPosition(slot, size, w), size));
+        }
+        dirtySlots = 0;
+        return root;
+    }
+    void SpaceBanner::geometryChanged(const QRectF& p_newGeometry, const QRectF& p_oldGeometry) {
+        QQuickItem::geometryChanged(p_newGeometry, p_oldGeometry);
+        // Right column follows the width
+        if (p_newGeometry.size() != p_oldGeometry.size()) update();
+    }
+
+    // Input
+    void SpaceBanner::mousePressEvent(QMouseEvent* p_event) {
+        pressed = true;
+        p_event->accept();
+    }
+    void SpaceBanner::mouseReleaseEvent(QMouseEvent* p_event) {
+        if (pressed && contains(p_event->localPos())) emit Clicked();
+        pressed = false;
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef SPACEBANNER_H
+#define SPACEBANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QStaticText>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+
+// User libraries
+#include "spacesummary.h"
+
+namespace space {
+    // Rasterized labels shared by every banner of one window
+    // .. Keyed by style and text, a label is laid out and uploaded once
+    // .. and reused by every row that shows it, recycled rows reuse the pool
+    // .. Lives on the render thread, unreferenced labels are evicted least recently used first
+    class BannerLabelCache {
+    public:
+        enum Style { Title, Body, Heading, Price, Light, StyleCount };
+        struct Label {
+            // Glyph layout, prepared once per text and style
+            QStaticText layout;
+            QSGTexture* texture = nullptr;
+            QSizeF size;
+            int references = 0;
+            quint64 lastUse = 0;
+            // Estimated size, texture included
+            qint64 bytes = 0;
+        };
+        static BannerLabelCache* ForWindow(QQuickWindow* p_window);
+
+        // Returns a referenced label, Release it when the node lets go
+        Label* Acquire(const QString& p_text, Style p_style);
+        void Release(Label* p_label);
+    private:
+        explicit BannerLabelCache(QQuickWindow* p_window) : window(p_window) {}
+        ~BannerLabelCache();
+        void Evict();
+        void Delete(Label* p_label);
+
+        QQuickWindow* window;
+        QHash<QString, Label*> labels;
+        quint64 clock = 0;
+        int unreferenced = 0;
+        enum { MaxUnreferenced = 512 };
+
+        static QMutex windowsLock;
+        static QHash<QQuickWindow*, BannerLabelCache*> windows;
+    };
+
+    // Scene-graph node showing one cached label
+    class BannerLabelNode : public QSGSimpleTextureNode {
+    private:
+        BannerLabelCache* cache;
+        BannerLabelCache::Label* label = nullptr;
+    public:
+        explicit BannerLabelNode(BannerLabelCache* p_cache) : cache(p_cache) { setOwnsTexture(false); }
+        ~BannerLabelNode() { if (label) cache->Release(label); }
+        // Swap the shown label, returns its size
+        QSizeF SetLabel(const QString& p_text, BannerLabelCache::Style p_style);
+    };
+
+    // Native list row replacing TextBanner.qml
+    // .. Draws the banner straight into scene-graph nodes, no controls or layouts per row
+    class SpaceBanner : public QQuickItem {
+        Q_OBJECT
+        Q_PROPERTY(QString name READ GetName WRITE SetName NOTIFY NameChanged)
+        Q_PROPERTY(QString primaryTag READ GetPrimaryTag WRITE SetPrimaryTag NOTIFY PrimaryTagChanged)
+        Q_PROPERTY(QString secondaryTags READ GetSecondaryTags WRITE SetSecondaryTags NOTIFY SecondaryTagsChanged)
+        Q_PROPERTY(float area READ GetArea WRITE SetArea NOTIFY AreaChanged)
+        Q_PROPERTY(unsigned int numberOfSeats READ GetNumberOfSeats WRITE SetNumberOfSeats NOTIFY NumberOfSeatsChanged)
+        Q_PROPERTY(unsigned int numberOfPeople READ GetNumberOfPeople WRITE SetNumberOfPeople NOTIFY NumberOfPeopleChanged)
+        Q_PROPERTY(bool catering READ IsCatering WRITE IsCatering NOTIFY CateringChanged)
+        Q_PROPERTY(double dirhamsPerHour READ GetDirhamsPerHour WRITE SetDirhamsPerHour NOTIFY DirhamsPerHourChanged)
+        Q_PROPERTY(float score READ GetScore WRITE SetScore NOTIFY ScoreChanged)
+        Q_PROPERTY(unsigned int numberOfReviews READ GetNumberOfReviews WRITE SetNumberOfReviews NOTIFY NumberOfReviewsChanged)
+        // Every field above but primaryTag in one binding, see SpaceListModel's summary role
+        Q_PROPERTY(space::SpaceSummary summary READ GetSummary WRITE SetSummary NOTIFY SummaryChanged)
+    signals:
+        void NameChanged();
+        void PrimaryTagChanged();
+        void SecondaryTagsChanged();
+        void AreaChanged();
+        void NumberOfSeatsChanged();
+        void NumberOfPeopleChanged();
+        void CateringChanged();
+        void DirhamsPerHourChanged();
+        void ScoreChanged();
+        void NumberOfReviewsChanged();
+        void SummaryChanged();
+        void Clicked();
+    private:
+        // One node per slot, in drawing order
+        enum Slot {
+            NameSlot, PrimaryTagSlot, SecondaryTagsSlot,
+            AreaHeadingSlot, SeatingHeadingSlot, PeopleHeadingSlot, CateringHeadingSlot,
+            AreaSlot, SeatingSlot, PeopleSlot, CateringSlot,
+            PriceSlot, PriceHeadingSlot, ReviewSlot,
+            SlotCount
+        };
+        QString name, primaryTag, secondaryTags;
+        float area = 0;
+        unsigned int numberOfSeats = 0;
+        unsigned int numberOfPeople = 0;
+        bool catering = false;
+        double dirhamsPerHour = 0;
+        float score = 0;
+        unsigned int numberOfReviews = 0;
+        SpaceSummary summary;
+        // Slots whose text changed since the last sync
+        unsigned int dirtySlots = ~0u;
+        bool pressed = false;
+
+        void Invalidate(unsigned int p_slots) { dirtySlots |= p_slots; update(); }
+        QString SlotText(int p_slot) const;
+        static BannerLabelCache::Style SlotStyle(int p_slot);
+        static QPointF SlotPosition(int p_slot, const QSizeF& p_size, qreal p_width);
+    protected:
+        QSGNode* updatePaintNode(QSGNode* p_oldNode, UpdatePaintNodeData* p_data) override;
+        void geometryChanged(const QRectF& p_newGeometry, const QRectF& p_oldGeometry) override;
+        void mousePressEvent(QMouseEvent* p_event) override;
+        void mouseReleaseEvent(QMouseEvent* p_event) override;
+        void mouseUngrabEvent() override { pressed = false; }
+    public:
+        explicit SpaceBanner(QQuickItem* parent = nullptr);
+        virtual ~SpaceBanner();
+
+        // Setters
+        void SetName(const QString& p_name);
+        void SetPrimaryTag(const QString& p_primaryTag);
+        void SetSecondaryTags(const QString& p_secondaryTags);
+        void SetArea(float p_area);
+        void SetNumberOfSeats(unsigned int p_numberOfSeats);
+        void SetNumberOfPeople(unsigned int p_numberOfPeople);
+        void IsCatering(bool p_catering);
+        void SetDirhamsPerHour(double p_dirhamsPerHour);
+        void SetScore(float p_score);
+        void SetNumberOfReviews(unsigned int p_numberOfReviews);
+        void SetSummary(const SpaceSummary& p_summary);
+
+        // Getters
+        QString GetName() const { return name; }
+        QString GetPrimaryTag() const { return primaryTag; }
+        QString GetSecondaryTags() const { return secondaryTags; }
+        float GetArea() const { return area; }
+        unsigned int GetNumberOfSeats() const { return numberOfSeats; }
+        unsigned int GetNumberOfPeople() const { return numberOfPeople; }
+        bool IsCatering() const { return catering; }
+        double GetDirhamsPerHour() const { return dirhamsPerHour; }
+        float GetScore() const { return score; }
+        unsigned int GetNumberOfReviews() const { return numberOfReviews; }
+        SpaceSummary GetSummary() const { return summary; }
+    };
+}
+
+#endif // SPACEBANNER_H
@@ -0,0 +1,293 @@
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QModelIndexList>
+
+// User libraries
+#include "spacelistmodel.h"
+#include "memoryusage.h"
+#include <algorithm>
+
+namespace space {
+    SpaceListModel::SpaceListModel(CatalogStore* p_catalog, QObject* parent) : QAbstractListModel(parent) {
+        catalog = p_catalog;
+        connect(catalog, &CatalogStore::Rebuilt, this, &SpaceListModel::Reload);
+        connect(catalog, &CatalogStore::RecordsChanged, this, [this](quint64, const QVector<int>& p_indexes) { Update(p_indexes); });
+        Reload();
+    }
+
+    // Model
+    int SpaceListModel::rowCount(const QModelIndex& parent) const {
+        return parent.isValid() ? 0 : rows.size();
+    }
+    QVariant SpaceListModel::data(const QModelIndex& index, int role) const {
+        if (!index.isValid() || index.row() >= rows.size()) return QVariant();
+        const SpaceRecord& record = pin->At(rows[index.row()]);
+        if (role == SummaryRole) return QVariant::fromValue(SpaceSummary::FromRecord(record));
+        if (role == Qt::DisplayRole) role = FirstRole + RecordSchema::Column<fields::Name>::Value;
+        if (role < FirstRole || role >= FirstRole + RecordSchema::Count) return QVariant();
+        return RecordSchema::Read(record, role - FirstRole);
+    }
+    QHash<int, QByteArray> SpaceListModel::roleNames() const {
+        // .. Same names as SpaceRecord::ToVariantMap
+        QHash<int, QByteArray> names;
+        for (int column = 0; column < RecordSchema::Count; column++) names.insert(FirstRole + column, RecordSchema::NameOf(column));
+        names.insert(SummaryRole, "summary");
+        return names;
+    }
+
+    QVariantList SpaceListModel::GetSummaries(int p_first, int p_count) const {
+        QVariantList summaries;
+        const int first = qMax(p_first, 0), last = qMin(p_first + p_count, rows.size());
+        if (first >= last) return summaries;
+        summaries.reserve(last - first);
+        for (int row = first; row < last; row++) summaries.append(QVariant::fromValue(SpaceSummary::FromRecord(pin->At(rows[row]))));
+        return summaries;
+    }
+
+    // Query
+    void SpaceListModel::SetQuery(const SpaceQuery& p_query) {
+        const bool resort = p_query.sortKey != query.sortKey || p_query.descending != query.descending;
+        query = p_query;
+        if (resort) Resort();
+        Refilter();
+    }
+
+    // Ordering
+    SpaceListModel::SortValue SpaceListModel::KeyOf(const SpaceRecord& p_record) const {
+        SortValue value;
+        if (query.sortKey == SpaceQuery::Unsorted) return value;
+        const int column = SortColumnOf(query.sortKey);
+        if (RecordSchema::IsText(column)) value.text = RecordSchema::Read(p_record, column).toString();
+        else value.number = RecordSchema::NumberOf(p_record, column);
+        return value;
+    }
+    bool SpaceListModel::Less(int p_a, int p_b) const {
+        const SortValue& a = keys[p_a];
+        const SortValue& b = keys[p_b];
+        int order;
+        if (query.sortKey == SpaceQuery::ByName) order = RecordSchema::CompareText(a.text, b.text);
+        else order = a.number < b.number ? -1 : b.number < a.number ? 1 : 0;
+        if (query.descending) order = -order;
+        // Ties fall back to catalog order, so every index has one place
+        return order != 0 ? order < 0 : p_a < p_b;
+    }
+    int SpaceListModel::LowerBound(int p_index, int p_skipRow) const {
+        int low = 0, high = rows.size() - (p_skipRow >= 0 ? 1 : 0);
+        while (low < high) {
+            const int middle = (low + high) / 2;
+            const int row = (p_skipRow >= 0 && middle >= p_skipRow) ? middle + 1 : middle;
+            if (Less(rows[row], p_index)) low = middle + 1;
+            else high = middle;
+        }
+        return low;
+    }
+    void SpaceListModel::Renumber(int p_first, int p_last) {
+        for (int row = p_first; row <= p_last; row++) positions[rows[row]] = row;
+    }
+    int SpaceListModel::InsertRows(QVector<int> p_incoming) {
+        // Grouped by the row they land before, back to front so earlier targets hold
+        std::sort(p_incoming.begin(), p_incoming.end(), [this](int a, int b) { return Less(a, b); });
+        int firstRow = rows.size();
+        for (int last = p_incoming.size() - 1; last >= 0;) {
+            const int target = LowerBound(p_incoming[last]);
+            int first = last;
+            while (first > 0 && LowerBound(p_incoming[first - 1]) == target) first--;
+            beginInsertRows(QModelIndex(), target, target + last - first);
+            rows.insert(target, last - first + 1, 0);
+            for (int k = first; k <= last; k++) rows[target + k - first] = p_incoming[k];
+            endInsertRows();
+            firstRow = target;
+            last = first - 1;
+        }
+        return firstRow;
+    }
+
+    // Updates
+    void SpaceListModel::Reload() {
+        EVIES_TIME_SCOPE(ModelReloadTimer);
+        EVIES_COUNT(ModelResets);
+        beginResetModel();
+        pin = catalog->Pin();
+        const int n = pin->GetSize();
+        keys.resize(n);
+        matches.fill(false, n);
+        positions.fill(-1, n);
+        rows.clear();
+        for (int i = 0; i < n; i++) {
+            const SpaceRecord& record = pin->At(i);
+            keys[i] = KeyOf(record);
+            if (!query.Matches(record)) continue;
+            matches.setBit(i);
+            rows.append(i);
+        }
+        std::sort(rows.begin(), rows.end(), [this](int a, int b) { return Less(a, b); });
+        Renumber(0, rows.size() - 1);
+        endResetModel();
+        emit CountChanged();
+    }
+    // .. Per batch: O(log n) to place each changed record, one renumbering from the first row
+    // .. that came, went or moved, and one dataChanged per run of rows updated in place
+    void SpaceListModel::Update(const QVector<int>& p_indexes) {
+        EVIES_TIME_SCOPE(ModelUpdateTimer);
+        pin = catalog->Pin();
+        const int before = rows.size();
+        // Changed records already listed, by row
+        struct Listed {
+            int row, index;
+            bool match, stays;
+        };
+        QVector<Listed> listed;
+        QVector<int> incoming;
+        for (int index: p_indexes) {
+            if (index >= keys.size()) continue;
+            const SpaceRecord& record = pin->At(index);
+            const bool match = query.Matches(record);
+            keys[index] = KeyOf(record);
+            if (positions[index] >= 0) {
+                const Listed entry = {positions[index], index, match, match};
+                listed.append(entry);
+            } else if (match) {
+                // Newly matching
+                matches.setBit(index);
+                incoming.append(index);
+            }
+        }
+        std::sort(listed.begin(), listed.end(), [](const Listed& a, const Listed& b) { return a.row < b.row; });
+
+        // A matching row stays if it is in order against the nearest rows that stay
+        // .. Unchanged rows always stay, so only runs of changed rows are walked over
+        // .. Taking one out can leave its neighbour out of order, repeat until none goes
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (int i = 0; i < listed.size(); i++) {
+                if (!listed[i].stays) continue;
+                int j = i - 1, previous = listed[i].row - 1;
+                while (j >= 0 && listed[j].row == previous && !listed[j].stays) { j--; previous--; }
+                int k = i + 1, next = listed[i].row + 1;
+                while (k < listed.size() && listed[k].row == next && !listed[k].stays) { k++; next++; }
+                if ((previous >= 0 && !Less(rows[previous], listed[i].index))
+                    || (next < rows.size() && !Less(listed[i].index, rows[next]))) {
+                    listed[i].stays = false;
+                    changed = true;
+                }
+            }
+        }
+
+        // Rows no longer matching or out of order go out as contiguous ranges, back to front
+        // .. so earlier rows keep their numbers; moving ones come back with the newly matching
+        int firstChanged = rows.size();
+        QVector<int> moving;
+        for (int last = listed.size() - 1; last >= 0; last--) {
+            if (listed[last].stays) continue;
+            int first = last;
+            while (first > 0 && !listed[first - 1].stays && listed[first - 1].row == listed[first].row - 1) first--;
+            beginRemoveRows(QModelIndex(), listed[first].row, listed[last].row);
+            for (int k = first; k <= last; k++) {
+                positions[listed[k].index] = -1;
+                if (listed[k].match) moving.append(listed[k].index);
+                else matches.clearBit(listed[k].index);
+            }
+            rows.remove(listed[first].row, last - first + 1);
+            endRemoveRows();
+            firstChanged = listed[first].row;
+            last = first;
+        }
+        EVIES_COUNT_N(ModelRowsRemoved, before - rows.size() - moving.size());
+        EVIES_COUNT_N(ModelRowsMoved, moving.size());
+        EVIES_COUNT_N(ModelRowsInserted, incoming.size());
+        incoming += moving;
+        if (!incoming.isEmpty()) firstChanged = qMin(firstChanged, InsertRows(incoming));
+        if (firstChanged < rows.size()) Renumber(firstChanged, rows.size() - 1);
+
+        // Rows updated in place keep their order, one dataChanged per contiguous run
+        int runFirst = -1, runLast = -2;
+        for (const Listed& entry: listed) {
+            if (!entry.stays) continue;
+            const int row = positions[entry.index];
+            if (row != runLast + 1) {
+                if (runFirst >= 0) emit dataChanged(this->index(runFirst), this->index(runLast));
+                runFirst = row;
+            }
+            runLast = row;
+        }
+        if (runFirst >= 0) emit dataChanged(this->index(runFirst), this->index(runLast));
+        if (rows.size() != before) emit CountChanged();
+    }
+    void SpaceListModel::Resort() {
+        EVIES_TIME_SCOPE(ModelResortTimer);
+        emit layoutAboutToBeChanged();
+        const QModelIndexList persistent = persistentIndexList();
+        QVector<int> persistentIndexes;
+        persistentIndexes.reserve(persistent.size());
+        for (const QModelIndex& index: persistent) persistentIndexes.append(rows[index.row()]);
+        for (int i = 0; i < keys.size(); i++) keys[i] = KeyOf(pin->At(i));
+        std::sort(rows.begin(), rows.end(), [this](int a, int b) { return Less(a, b); });
+        Renumber(0, rows.size() - 1);
+        QModelIndexList moved;
+        moved.reserve(persistent.size());
+        for (int index: persistentIndexes) moved.append(this->index(positions[index]));
+        changePersistentIndexList(persistent, moved);
+        emit layoutChanged();
+    }
+    void SpaceListModel::Refilter() {
+        EVIES_TIME_SCOPE(ModelRefilterTimer);
+        const int n = keys.size();
+        QBitArray next(n);
+        for (int i = 0; i < n; i++)
+            if (query.Matches(pin->At(i))) next.setBit(i);
+        const QBitArray gone = matches & ~next;
+        const QBitArray come = next & ~matches;
+        const int changes = gone.count(true) + come.count(true);
+        if (changes == 0) return;
+        matches = next;
+        const int before = rows.size();
+
+        // A mostly different result is cheaper as one reset than as many ranges
+        if (changes > qMax(64, before / 2)) {
+            beginResetModel();
+            positions.fill(-1, n);
+            rows.clear();
+            for (int i = 0; i < n; i++)
+                if (matches.testBit(i)) rows.append(i);
+            std::sort(rows.begin(), rows.end(), [this](int a, int b) { return Less(a, b); });
+            Renumber(0, rows.size() - 1);
+            endResetModel();
+            EVIES_COUNT(ModelResets);
+            emit CountChanged();
+            return;
+        }
+
+        // Removals as contiguous ranges, back to front so earlier rows keep their numbers
+        for (int last = rows.size() - 1; last >= 0; last--) {
+            if (!gone.testBit(rows[last])) continue;
+            int first = last;
+            while (first > 0 && gone.testBit(rows[first - 1])) first--;
+            beginRemoveRows(QModelIndex(), first, last);
+            for (int row = first; row <= last; row++) positions[rows[row]] = -1;
+            rows.remove(first, last - first + 1);
+            endRemoveRows();
+            EVIES_COUNT_N(ModelRowsRemoved, last - first + 1);
+            last = first;
+        }
+
+        QVector<int> incoming;
+        for (int i = 0; i < n; i++)
+            if (come.testBit(i)) incoming.append(i);
+        EVIES_COUNT_N(ModelRowsInserted, incoming.size());
+        InsertRows(incoming);
+        Renumber(0, rows.size() - 1);
+        if (rows.size() != before) emit CountChanged();
+    }
+
+    // Memory accounting
+    void SpaceListModel::AccountMemory(MemoryUsage& p_usage) const {
+        p_usage.AddQObject(MemoryUsage::Models, sizeof(SpaceListModel));
+        p_usage.AddVector(MemoryUsage::Models, keys);
+        // .. Name keys share the record names
+        for (const SortValue& key: keys) p_usage.AddString(MemoryUsage::Strings, key.text);
+        p_usage.AddObject(MemoryUsage::Models, sizeof(QArrayData) + (matches.size() + 7) / 8 + 1);
+        p_usage.AddVector(MemoryUsage::Models, positions);
+        p_usage.AddVector(MemoryUsage::Models, rows);
+    }
+}
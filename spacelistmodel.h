@@ -0,0 +1,97 @@
+#ifndef SPACELISTMODEL_H
+#define SPACELISTMODEL_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QBitArray>
+#include <QAbstractListModel>
+
+// User libraries
+#include "spacequery.h"
+#include "catalogstore.h"
+#include "spacesummary.h"
+#include "recordschema.h"
+
+namespace space {
+    // Live, filtered and sorted list of the catalog for views
+    // .. Keeps a filter-match bit and a sort key per catalog index, and the
+    // .. visible indexes in order, so a changed record is re-filtered and
+    // .. placed by binary search instead of re-sorting the whole list
+    // .. A batch of changed records is applied as ranged removals and insertions,
+    // .. plus one dataChanged per run of rows that kept their place
+    // .. Changing the filter emits only the rows that came or went
+    // .. The query limit is not applied, views scroll instead
+    class SpaceListModel : public QAbstractListModel {
+        Q_OBJECT
+        Q_PROPERTY(int count READ GetCount NOTIFY CountChanged)
+    signals:
+        void CountChanged();
+    public:
+        // Role of each RecordSchema column, named after it, then the whole row
+        // .. as one SpaceSummary for delegates that bind a single value
+        enum {
+            FirstRole = Qt::UserRole + 1,
+            SummaryRole = FirstRole + RecordSchema::Count
+        };
+    private:
+        CatalogStore* catalog;
+        // Version the rows were built from
+        CatalogPin pin;
+        SpaceQuery query;
+
+        // Sort key of one record as last positioned
+        struct SortValue {
+            double number = 0;
+            QString text;
+        };
+        // .. By catalog index
+        QVector<SortValue> keys;
+        QBitArray matches;
+        QVector<int> positions;
+        // Row to catalog index, ordered by keys then index
+        QVector<int> rows;
+
+        SortValue KeyOf(const SpaceRecord& p_record) const;
+        bool Less(int p_a, int p_b) const;
+        // Row p_index belongs at, optionally ignoring the row it is in now
+        int LowerBound(int p_index, int p_skipRow = -1) const;
+        void Renumber(int p_first, int p_last);
+        // Inserts records not listed yet in order, returns the first row taken
+        // .. Positions are left to the caller's Renumber
+        int InsertRows(QVector<int> p_incoming);
+
+        void Reload();
+        void Update(const QVector<int>& p_indexes);
+        void Resort();
+        void Refilter();
+    public:
+        explicit SpaceListModel(CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~SpaceListModel() {}
+
+        // Model
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+        QHash<int, QByteArray> roleNames() const override;
+
+        // Query
+        // .. A new sort key re-sorts once, filter changes are applied as a diff
+        void SetQuery(const SpaceQuery& p_query);
+        const SpaceQuery& GetQuery() const { return query; }
+        // .. QML side, same keys as SpaceQueryService::Query
+        Q_INVOKABLE void SetFilter(const QVariantMap& p_query) { SetQuery(SpaceQuery::FromVariantMap(p_query)); }
+
+        // Getters
+        int GetCount() const { return rows.size(); }
+        // Catalog index of a row, -1 if out of range
+        Q_INVOKABLE int GetIndex(int p_row) const { return p_row >= 0 && p_row < rows.size() ? rows[p_row] : -1; }
+        // Summaries of p_count rows from p_first, clipped to the list
+        Q_INVOKABLE QVariantList GetSummaries(int p_first, int p_count) const;
+
+        // Memory accounting
+        // .. Sort keys, match bits, positions and rows
+        void AccountMemory(MemoryUsage& p_usage) const;
+    };
+}
+
+#endif // SPACELISTMODEL_H
@@ -0,0 +1,169 @@
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QVariant>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+// User libraries
+#include "spacequery.h"
+#include "catalogstore.h"
+#include "recordschema.h"
+#include "spacesummary.h"
+#include <algorithm>
+#include <ctime>
+
+namespace space {
+    // Records
+    SpaceRecord SpaceRecord::FromSpace(const Space& p_space) {
+        SpaceRecord record;
+        record.ID = p_space.GetID();
+        record.name = p_space.GetName();
+        record.area = p_space.GetDims().GetArea();
+        record.numberOfPeople = p_space.GetNumberOfPeople();
+        record.numberOfSeats = p_space.GetSeats().GetNumberOfSeats();
+        record.dirhamsPerHour = p_space.GetTimer().GetDirhamsPerHour();
+        record.score = p_space.GetReview().GetReviewScore();
+        record.numberOfReviews = p_space.GetReview().GetNumberOfReviews();
+        record.flags = FlagsOf(p_space);
+        record.originTime = p_space.GetTimer().GetOriginTime();
+        record.times = p_space.GetTimer().GetTimes();
+        return record;
+    }
+    unsigned int SpaceRecord::FlagsOf(const Space& p_space) {
+        return (p_space.IsOutdoor() ? Outdoor : 0)
+             | (p_space.IsCatering() ? Catering : 0)
+             | (p_space.IsNaturalLight() ? NaturalLight : 0)
+             | (p_space.IsArtificialLight() ? ArtificialLight : 0)
+             | (p_space.IsProjector() ? Projector : 0)
+             | (p_space.IsSound() ? Sound : 0)
+             | (p_space.IsCameras() ? Cameras : 0)
+             | (p_space.GetSeats().IsSlanted() ? Slanted : 0)
+             | (p_space.GetSeats().IsSurround() ? Surround : 0)
+             | (p_space.GetSeats().IsComfy() ? Comfy : 0);
+    }
+    bool SpaceRecord::IsFree(time_t p_from, time_t p_to) const {
+        // Clip to the bookable range, same hour arithmetic as Time
+        if (p_from < originTime) p_from = originTime;
+        if (p_to <= p_from) return true;
+        unsigned long startHour = (unsigned long)((p_from - originTime) / 3600);
+        unsigned long endHour = (unsigned long)((p_to - originTime + 3599) / 3600) - 1;
+        return !Time::AnyHours(times, startHour, endHour);
+    }
+    QVariantMap SpaceRecord::ToVariantMap() const {
+        return RecordSchema::ToVariantMap(*this);
+    }
+    QString SpaceRecord::GetTags() const {
+        // .. Hashtags for the list rows, in flag order
+        static const char* const tagNames[] = {"#outdoor", "#catering", "#naturallight", "#artificiallight",
+                                               "#projector", "#sound", "#cameras", "#slanted", "#surround", "#comfy"};
+        QStringList tags;
+        for (int bit = 0; bit < 10; bit++)
+            if (flags & (1u << bit)) tags.append(QLatin1String(tagNames[bit]));
+        return tags.join(' ');
+    }
+
+    // Queries
+    SpaceQuery SpaceQuery::FromVariantMap(const QVariantMap& p_map) {
+        SpaceQuery query;
+        query.text = p_map.value("text").toString();
+        query.minPeople = p_map.value("minPeople").toUInt();
+        query.minSeats = p_map.value("minSeats").toUInt();
+        query.minArea = p_map.value("minArea").toFloat();
+        query.maxDirhamsPerHour = p_map.value("maxDirhamsPerHour").toDouble();
+        query.minScore = p_map.value("minScore").toFloat();
+        query.requiredFlags = p_map.value("requiredFlags").toUInt();
+        // .. Seconds since epoch, QML Date.getTime() / 1000
+        query.freeFrom = (time_t)p_map.value("freeFrom").toLongLong();
+        query.freeTo = (time_t)p_map.value("freeTo").toLongLong();
+        const QString sortKey = p_map.value("sortKey").toString();
+        if (sortKey == "name") query.sortKey = ByName;
+        else if (sortKey == "area") query.sortKey = ByArea;
+        else if (sortKey == "price") query.sortKey = ByPrice;
+        else if (sortKey == "score") query.sortKey = ByScore;
+        else if (sortKey == "rank") query.sortKey = ByRank;
+        query.descending = p_map.value("descending").toBool();
+        query.limit = p_map.value("limit").toInt();
+        return query;
+    }
+    bool SpaceQuery::Matches(const SpaceRecord& p_record) const {
+        if (p_record.numberOfPeople < minPeople) return false;
+        if (p_record.numberOfSeats < minSeats) return false;
+        if (p_record.area < minArea) return false;
+        if (maxDirhamsPerHour > 0 && p_record.dirhamsPerHour > maxDirhamsPerHour) return false;
+        if (p_record.score < minScore) return false;
+        if ((p_record.flags & requiredFlags) != requiredFlags) return false;
+        if (!text.isEmpty() && !p_record.name.contains(text, Qt::CaseInsensitive)) return false;
+        // .. Availability last, it is the only check that touches the bitmap
+        if (freeTo > freeFrom && !p_record.IsFree(freeFrom, freeTo)) return false;
+        return true;
+    }
+    static bool RecordLess(const SpaceRecord& a, const SpaceRecord& b, int p_column) {
+        return RecordSchema::Compare(a, b, p_column) < 0;
+    }
+
+    // Service
+    SpaceQueryService::SpaceQueryService(CatalogStore* p_catalog, QObject* parent) : QObject(parent) {
+        catalog = p_catalog;
+        // Leave one core to the GUI thread
+        pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    }
+    SpaceQueryService::~SpaceQueryService() {
+        // Cancel everything still running before the pool joins
+        for (auto it = generations.begin(); it != generations.end(); ++it)
+            it.value()->storeRelease(0);
+        pool.waitForDone();
+    }
+    SpaceRecords SpaceQueryService::Run(CatalogPin p_snapshot, SpaceQuery p_query,
+                                        QSharedPointer<QAtomicInt> p_generation, int p_ticket) {
+        SpaceRecords results;
+        for (int i = 0; i < p_snapshot->GetSize(); i++) {
+            // Poll for cancellation every 1024 records
+            if ((i & 1023) == 0 && p_generation->loadAcquire() != p_ticket) return SpaceRecords();
+            const SpaceRecord& record = p_snapshot->At(i);
+            if (p_query.Matches(record)) results.append(record);
+        }
+        if (p_generation->loadAcquire() != p_ticket) return SpaceRecords();
+        const SpaceQuery::SortKey key = p_query.sortKey;
+        const int column = SortColumnOf(key);
+        const bool descending = p_query.descending;
+        auto less = [column, descending](const SpaceRecord& a, const SpaceRecord& b) {
+            return descending ? RecordLess(b, a, column) : RecordLess(a, b, column);
+        };
+        // Only the first page needs to be ordered when a limit is given
+        if (p_query.limit > 0 && p_query.limit < results.size()) {
+            std::partial_sort(results.begin(), results.begin() + p_query.limit, results.end(), less);
+            results.resize(p_query.limit);
+        } else if (key != SpaceQuery::Unsorted || descending) {
+            std::stable_sort(results.begin(), results.end(), less);
+        }
+        return results;
+    }
+    QFuture<SpaceRecords> SpaceQueryService::Submit(const QString& p_view, const SpaceQuery& p_query) {
+        QSharedPointer<QAtomicInt>& generation = generations[p_view];
+        if (!generation) generation.reset(new QAtomicInt(0));
+        // Bumping the generation is what cancels older queries of this view
+        const int ticket = nextTicket++;
+        generation->storeRelease(ticket);
+        return QtConcurrent::run(&pool, &SpaceQueryService::Run, catalog->Pin(), p_query, generation, ticket);
+    }
+    int SpaceQueryService::Query(const QString& p_view, const QVariantMap& p_query) {
+        QFuture<SpaceRecords> future = Submit(p_view, SpaceQuery::FromVariantMap(p_query));
+        QSharedPointer<QAtomicInt> generation = generations.value(p_view);
+        const int ticket = generation->loadAcquire();
+        QFutureWatcher<SpaceRecords>* watcher = new QFutureWatcher<SpaceRecords>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, ticket, p_view]() {
+            watcher->deleteLater();
+            // Superseded while running
+            if (generation->loadAcquire() != ticket) return;
+            emit ResultsReady(p_view, ticket, SpaceSummary::FromRecords(watcher->result()));
+        });
+        watcher->setFuture(future);
+        return ticket;
+    }
+    void SpaceQueryService::Cancel(const QString& p_view) {
+        if (generations.contains(p_view)) generations.value(p_view)->storeRelease(0);
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef SPACEQUERY_H
+#define SPACEQUERY_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QHash>
+#include <QVariant>
+#include <QFuture>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+// User libraries
+#include "space.h"
+#include <ctime>
+
+namespace space {
+    // Compact, immutable copy of the fields queries look at
+    // .. Taken on the GUI thread, read on workers
+    // .. Strings and bitmaps are implicitly shared, not deep copied
+    struct SpaceRecord {
+        enum Flag {
+            Outdoor         = 1 << 0,
+            Catering        = 1 << 1,
+            NaturalLight    = 1 << 2,
+            ArtificialLight = 1 << 3,
+            Projector       = 1 << 4,
+            Sound           = 1 << 5,
+            Cameras         = 1 << 6,
+            Slanted         = 1 << 7,
+            Surround        = 1 << 8,
+            Comfy           = 1 << 9
+        };
+        unsigned int ID = 0;
+        QString name;
+        float area = 0;
+        unsigned int numberOfPeople = 0;
+        unsigned int numberOfSeats = 0;
+        double dirhamsPerHour = 0;
+        float score = 0;
+        unsigned int numberOfReviews = 0;
+        unsigned int flags = 0;
+        time_t originTime = 0;
+        QVector<unsigned long long> times;
+
+        static SpaceRecord FromSpace(const Space& p_space);
+        // Flag bits of a live space, without copying the rest
+        static unsigned int FlagsOf(const Space& p_space);
+        // Bayesian average of the score, used for ranking
+        // .. Few reviews are pulled towards a neutral 3
+        float GetRank() const { return (score * numberOfReviews + 3.0f * 5) / (numberOfReviews + 5); }
+        // True if no hour in [p_from, p_to) is booked
+        bool IsFree(time_t p_from, time_t p_to) const;
+        QVariantMap ToVariantMap() const;
+        // "#outdoor #catering ..." for the set flags
+        QString GetTags() const;
+    };
+    typedef QVector<SpaceRecord> SpaceRecords;
+
+    class CatalogStore;
+    class CatalogPin;
+
+    // Search, filter, sort, availability and ranking in one description
+    // .. Zero means "no constraint" for every limit
+    struct SpaceQuery {
+        enum SortKey { Unsorted, ByName, ByArea, ByPrice, ByScore, ByRank };
+        QString text;
+        unsigned int minPeople = 0;
+        unsigned int minSeats = 0;
+        float minArea = 0;
+        double maxDirhamsPerHour = 0;
+        float minScore = 0;
+        unsigned int requiredFlags = 0;
+        time_t freeFrom = 0, freeTo = 0;
+        SortKey sortKey = Unsorted;
+        bool descending = false;
+        int limit = 0;
+
+        // Keys match the field names above, sortKey is "name", "area", "price", "score" or "rank"
+        static SpaceQuery FromVariantMap(const QVariantMap& p_map);
+        bool Matches(const SpaceRecord& p_record) const;
+    };
+
+    // Runs catalog queries on a worker pool
+    // .. A newer query from the same view cancels older ones still running
+    // .. Results come back as shared, read-only record vectors
+    class SpaceQueryService : public QObject {
+        Q_OBJECT
+    signals:
+        // QML side, ticket is the value Query returned, one SpaceSummary per result
+        void ResultsReady(const QString& view, int ticket, const QVariantList& results);
+    private:
+        // Pinned per query, so results stay consistent while bookings land
+        CatalogStore* catalog;
+        QThreadPool pool;
+        // Latest ticket per view, workers compare against it to bail out
+        QHash<QString, QSharedPointer<QAtomicInt>> generations;
+        int nextTicket = 1;
+
+        static SpaceRecords Run(CatalogPin p_snapshot, SpaceQuery p_query,
+                                QSharedPointer<QAtomicInt> p_generation, int p_ticket);
+    public:
+        explicit SpaceQueryService(CatalogStore* p_catalog, QObject* parent = nullptr);
+        virtual ~SpaceQueryService();
+
+        // C++ side
+        // .. A cancelled query finishes early with an empty result
+        QFuture<SpaceRecords> Submit(const QString& p_view, const SpaceQuery& p_query);
+        // QML side, returns a ticket echoed by ResultsReady
+        // .. Stale tickets are dropped, only the latest per view is delivered
+        Q_INVOKABLE int Query(const QString& p_view, const QVariantMap& p_query);
+        Q_INVOKABLE void Cancel(const QString& p_view);
+    };
+}
+
+#endif // SPACEQUERY_H
@@ -0,0 +1,41 @@
+#include <QObject>
+#include <QString>
+#include <QVariant>
+
+// User libraries
+#include "spacesummary.h"
+
+namespace space {
+    QString SpaceSummary::GetTags() const {
+        // .. Same hashtags as the record
+        SpaceRecord record;
+        record.flags = flags;
+        return record.GetTags();
+    }
+    bool SpaceSummary::operator==(const SpaceSummary& p_other) const {
+        return ID == p_other.ID && name == p_other.name && area == p_other.area
+            && numberOfPeople == p_other.numberOfPeople && numberOfSeats == p_other.numberOfSeats
+            && dirhamsPerHour == p_other.dirhamsPerHour && score == p_other.score
+            && numberOfReviews == p_other.numberOfReviews && flags == p_other.flags;
+    }
+
+    SpaceSummary SpaceSummary::FromRecord(const SpaceRecord& p_record) {
+        SpaceSummary summary;
+        summary.ID = p_record.ID;
+        summary.name = p_record.name;
+        summary.area = p_record.area;
+        summary.numberOfPeople = p_record.numberOfPeople;
+        summary.numberOfSeats = p_record.numberOfSeats;
+        summary.dirhamsPerHour = p_record.dirhamsPerHour;
+        summary.score = p_record.score;
+        summary.numberOfReviews = p_record.numberOfReviews;
+        summary.flags = p_record.flags;
+        return summary;
+    }
+    QVariantList SpaceSummary::FromRecords(const SpaceRecords& p_records) {
+        QVariantList summaries;
+        summaries.reserve(p_records.size());
+        for (const SpaceRecord& record: p_records) summaries.append(QVariant::fromValue(FromRecord(record)));
+        return summaries;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef SPACESUMMARY_H
+#define SPACESUMMARY_H
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+#include <QMetaType>
+
+// User libraries
+#include "spacequery.h"
+
+namespace space {
+    // Read-only row of the space list, passed to delegates by value
+    // .. A gadget, no QObject, NOTIFY connection or ownership per row: a delegate
+    // .. binds one value and reads its fields without any lookup in the catalog
+    // .. The live Space is only fetched when a page opens it (FindSpace)
+    struct SpaceSummary {
+        Q_GADGET
+        Q_PROPERTY(unsigned int ID MEMBER ID)
+        Q_PROPERTY(QString name MEMBER name)
+        Q_PROPERTY(float area MEMBER area)
+        Q_PROPERTY(unsigned int numberOfPeople MEMBER numberOfPeople)
+        Q_PROPERTY(unsigned int numberOfSeats MEMBER numberOfSeats)
+        Q_PROPERTY(double dirhamsPerHour MEMBER dirhamsPerHour)
+        Q_PROPERTY(float score MEMBER score)
+        Q_PROPERTY(unsigned int numberOfReviews MEMBER numberOfReviews)
+        Q_PROPERTY(unsigned int flags MEMBER flags)
+        Q_PROPERTY(bool outdoor READ IsOutdoor)
+        Q_PROPERTY(bool catering READ IsCatering)
+        Q_PROPERTY(QString tags READ GetTags)
+    public:
+        unsigned int ID = 0;
+        // .. Shared with the catalog record, not copied
+        QString name;
+        float area = 0;
+        unsigned int numberOfPeople = 0;
+        unsigned int numberOfSeats = 0;
+        double dirhamsPerHour = 0;
+        float score = 0;
+        unsigned int numberOfReviews = 0;
+        // SpaceRecord::Flag bits
+        unsigned int flags = 0;
+
+        bool IsOutdoor() const { return flags & SpaceRecord::Outdoor; }
+        bool IsCatering() const { return flags & SpaceRecord::Catering; }
+        QString GetTags() const;
+        bool operator==(const SpaceSummary& p_other) const;
+        bool operator!=(const SpaceSummary& p_other) const { return !(*this == p_other); }
+
+        static SpaceSummary FromRecord(const SpaceRecord& p_record);
+        // One QVariant per record, in order
+        static QVariantList FromRecords(const SpaceRecords& p_records);
+    };
+}
+
+Q_DECLARE_METATYPE(space::SpaceSummary)
+
+#endif // SPACESUMMARY_H
@@ -0,0 +1,31 @@
+#include <QString>
+#include <QDebug>
+
+// User libraries
+#include "startuptimeline.h"
+
+namespace space {
+    StartupTimeline::StartupTimeline(const QStringList& p_awaited) : awaited(p_awaited) {
+        clock.start();
+        marks.append(qMakePair(QString("main"), (qint64)0));
+    }
+    void StartupTimeline::Mark(const QString& p_milestone) {
+        marks.append(qMakePair(p_milestone, clock.elapsed()));
+        if (awaited.removeAll(p_milestone) > 0 && awaited.isEmpty())
+            qInfo().noquote() << Report();
+    }
+    qint64 StartupTimeline::GetElapsed(const QString& p_milestone) const {
+        for (const QPair<QString, qint64>& mark: marks)
+            if (mark.first == p_milestone) return mark.second;
+        return -1;
+    }
+    QString StartupTimeline::Report() const {
+        QString report = "Startup timeline";
+        qint64 previous = 0;
+        for (const QPair<QString, qint64>& mark: marks) {
+            report += QString("\n  %1 ms  (+%2)  %3").arg(mark.second, 6).arg(mark.second - previous, 4).arg(mark.first);
+            previous = mark.second;
+        }
+        return report;
+    }
+}
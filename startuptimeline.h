@@ -0,0 +1,30 @@
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QElapsedTimer>
+
+namespace space {
+    // Milestones of application start, in milliseconds since main()
+    // .. Logged once every awaited milestone has been marked
+    // .. GUI thread only
+    class StartupTimeline {
+    private:
+        QElapsedTimer clock;
+        QVector<QPair<QString, qint64>> marks;
+        QStringList awaited;
+    public:
+        explicit StartupTimeline(const QStringList& p_awaited);
+
+        void Mark(const QString& p_milestone);
+        bool IsComplete() const { return awaited.isEmpty(); }
+        qint64 GetElapsed(const QString& p_milestone) const;
+        // One line per milestone with the gap to the previous one
+        QString Report() const;
+    };
+}
+
+#endif // STARTUPTIMELINE_H
@@ -0,0 +1,144 @@
+#include <QObject>
+#include <QVector>
+
+// User libraries
+#include "superspace.h"
+#include <cmath>
+
+namespace space {
+    SuperSpace::SuperSpace(unsigned int p_ID, const QString& p_name, double p_longitude, double p_latitude, QObject* parent) : QObject(parent) {
+        ID = p_ID;
+        name = p_name;
+        longitude = p_longitude;
+        latitude = p_latitude;
+    }
+
+    // Members
+    void SuperSpace::AddSpace(space::Space* p_space) {
+        if (!p_space || spaces.contains(p_space)) return;
+        if (spaces.isEmpty() && anyBooked.isEmpty()) originTime = p_space->GetTimer().GetOriginTime();
+        spaces.append(p_space);
+        memberTimes.append(QVector<unsigned long long>());
+        // .. Only the address is compared, the space is half destroyed by then
+        connect(p_space, &QObject::destroyed, this, [this, p_space]() { Forget(spaces.indexOf(p_space)); });
+        connect(&p_space->GetTimer(), &Time::WordsChanged, this, [this, p_space](int first, int last) {
+            MemberChanged(p_space, first, last);
+        });
+        // Whole bitmap, plus the hours before its origin when it starts after the venue
+        const Time& timer = p_space->GetTimer();
+        const long offset = HourOf(timer.GetOriginTime());
+        const long lastHour = (long)timer.GetWords().size() * 64 - 1 + offset;
+        if (lastHour >= 0) Refresh(spaces.size() - 1, 0, (int)(lastHour / 64));
+        // .. One more room, every word may stop being all booked
+        for (int word = 0; word < allBooked.size(); word++) RollUp(word);
+        emit SpacesChanged();
+        if (!anyBooked.isEmpty()) emit AvailabilityChanged(0, anyBooked.size() - 1);
+    }
+    void SuperSpace::RemoveSpace(space::Space* p_space) {
+        const int index = spaces.indexOf(p_space);
+        if (index < 0) return;
+        disconnect(p_space, &QObject::destroyed, this, nullptr);
+        disconnect(&p_space->GetTimer(), &Time::WordsChanged, this, nullptr);
+        Forget(index);
+    }
+    void SuperSpace::Forget(int p_index) {
+        if (p_index < 0) return;
+        // .. Not through the timer, a destroyed space has deleted it already
+        for (int word = 0; word < memberTimes[p_index].size(); word++) Apply(p_index, word, 0);
+        spaces.remove(p_index);
+        memberTimes.remove(p_index);
+        for (int word = 0; word < allBooked.size(); word++) RollUp(word);
+        emit SpacesChanged();
+        if (!anyBooked.isEmpty()) emit AvailabilityChanged(0, anyBooked.size() - 1);
+    }
+    unsigned int SuperSpace::GetMaxNumberOfPeople() const {
+        unsigned int people = 0;
+        for (const space::Space* space_ptr: spaces) people += space_ptr->GetNumberOfPeople();
+        return people;
+    }
+
+    // Rolled-up availability
+    long SuperSpace::HourOf(const time_t& p_time) const {
+        return (long)std::floor(std::difftime(p_time, originTime) / (60 * 60));
+    }
+    unsigned long long SuperSpace::MemberWord(int p_member, long p_word) const {
+        const Time& timer = spaces[p_member]->GetTimer();
+        const QVector<unsigned long long>& times = timer.GetWords();
+        // .. First hour of the venue word on the member's axis, split into word and bit
+        const long start = p_word * 64 - HourOf(timer.GetOriginTime());
+        const long word = start >= 0 ? start / 64 : -((63 - start) / 64);
+        const int bit = (int)(start - word * 64);
+        auto at = [&times](long p_index) -> unsigned long long {
+            if (p_index < 0) return ~0ULL;
+            return p_index < times.size() ? times[p_index] : 0;
+        };
+        if (!bit) return at(word);
+        return (at(word) >> bit) | (at(word + 1) << (64 - bit));
+    }
+    void SuperSpace::MemberChanged(space::Space* p_space, int p_first, int p_last) {
+        const int index = spaces.indexOf(p_space);
+        if (index < 0) return;
+        const long offset = HourOf(p_space->GetTimer().GetOriginTime());
+        const long firstHour = (long)p_first * 64 + offset, lastHour = (long)p_last * 64 + 63 + offset;
+        if (lastHour < 0) return;
+        const int first = (int)(qMax(firstHour, 0L) / 64), last = (int)(lastHour / 64);
+        Refresh(index, first, last);
+        emit AvailabilityChanged(first, last);
+    }
+    void SuperSpace::Refresh(int p_member, int p_first, int p_last) {
+        for (int word = p_first; word <= p_last; word++) Apply(p_member, word, MemberWord(p_member, word));
+    }
+    void SuperSpace::Apply(int p_member, int p_word, unsigned long long p_times) {
+        QVector<unsigned long long>& times = memberTimes[p_member];
+        if (times.size() <= p_word) {
+            if (!p_times) return;
+            times.resize(p_word + 1);
+        }
+        const unsigned long long previous = times[p_word];
+        if (previous == p_times) return;
+        times[p_word] = p_times;
+        if (anyBooked.size() <= p_word) {
+            bookedRooms.resize((p_word + 1) * 64);
+            anyBooked.resize(p_word + 1);
+            allBooked.resize(p_word + 1);
+        }
+        int* rooms = bookedRooms.data() + p_word * 64;
+        for (unsigned long long bits = p_times & ~previous; bits; bits &= bits - 1) rooms[qCountTrailingZeroBits(bits)]++;
+        for (unsigned long long bits = previous & ~p_times; bits; bits &= bits - 1) rooms[qCountTrailingZeroBits(bits)]--;
+        RollUp(p_word);
+    }
+    void SuperSpace::RollUp(int p_word) {
+        const int* rooms = bookedRooms.constData() + p_word * 64;
+        unsigned long long any = 0, all = 0;
+        for (int bit = 0; bit < 64; bit++) {
+            if (rooms[bit] > 0) any |= 1ULL << bit;
+            if (rooms[bit] > 0 && rooms[bit] == spaces.size()) all |= 1ULL << bit;
+        }
+        anyBooked[p_word] = any;
+        allBooked[p_word] = all;
+    }
+    bool SuperSpace::IsFullyFree(const time_t& p_from, const time_t& p_to) const {
+        if (p_to <= p_from) return true;
+        const long startHour = HourOf(p_from), endHour = HourOf(p_to - 1);
+        if (startHour < 0) return false;
+        return !Time::AnyHours(anyBooked, startHour, endHour);
+    }
+    bool SuperSpace::IsBoughtOut(const time_t& p_from, const time_t& p_to) const {
+        if (spaces.isEmpty() || p_to <= p_from) return false;
+        // .. Hours before the origin cannot be booked by anyone
+        const long startHour = qMax(HourOf(p_from), 0L), endHour = HourOf(p_to - 1);
+        if (endHour < startHour) return true;
+        return Time::CountHours(allBooked, startHour, endHour) == (unsigned long)(endHour - startHour + 1);
+    }
+    bool SuperSpace::HasFreeRoomEachHour(const time_t& p_from, const time_t& p_to) const {
+        if (spaces.isEmpty() || p_to <= p_from) return false;
+        const long startHour = HourOf(p_from), endHour = HourOf(p_to - 1);
+        if (startHour < 0) return false;
+        return !Time::AnyHours(allBooked, startHour, endHour);
+    }
+    int SuperSpace::GetFreeRooms(const time_t& p_time) const {
+        const long hour = HourOf(p_time);
+        if (hour < 0) return 0;
+        return spaces.size() - (hour < bookedRooms.size() ? bookedRooms[hour] : 0);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef SUPERSPACE_H
+#define SUPERSPACE_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+
+// User libraries
+#include "space.h"
+
+namespace space {
+    // Group of spaces at the same location (venue)
+    // .. Spaces stay owned by their manager, a superspace only refers to them
+    // .. and forgets a space when it is destroyed
+    // .. Availability is rolled up over the rooms and kept current from each
+    // .. timer's WordsChanged, venue questions never walk the rooms
+    class SuperSpace : public QObject {
+        Q_OBJECT
+        Q_PROPERTY(unsigned int ID READ GetID CONSTANT)
+        Q_PROPERTY(QString name READ GetName CONSTANT)
+        Q_PROPERTY(double longitude READ GetLongitude CONSTANT)
+        Q_PROPERTY(double latitude READ GetLatitude CONSTANT)
+        Q_PROPERTY(int numberOfSpaces READ GetNumberOfSpaces NOTIFY SpacesChanged)
+        Q_PROPERTY(unsigned int maxNumberOfPeople READ GetMaxNumberOfPeople NOTIFY SpacesChanged)
+    signals:
+        void SpacesChanged();
+        // Rolled-up availability changed in words [first, last] of the venue's axis
+        void AvailabilityChanged(int first, int last);
+    private:
+        unsigned int ID = 0;
+        QString name;
+        double longitude = 0, latitude = 0;
+        // Spaces available in superspace
+        QVector<space::Space*> spaces;
+
+        // Rolled-up availability, hour bitmaps on the venue's own axis from originTime
+        // .. Each member's bitmap is kept moved onto that axis, hours before a
+        // .. member's own origin count as booked as they cannot be booked
+        time_t originTime = 0;
+        QVector<QVector<unsigned long long>> memberTimes;
+        // Rooms booked per hour
+        QVector<int> bookedRooms;
+        // Some room booked (OR), every room booked (AND)
+        QVector<unsigned long long> anyBooked, allBooked;
+        // Word p_word of the venue's axis from member p_member's timer
+        unsigned long long MemberWord(int p_member, long p_word) const;
+        // Drops member p_index and its hours from the roll-ups
+        void Forget(int p_index);
+        // Words [p_first, p_last] of p_space's own timer changed
+        void MemberChanged(space::Space* p_space, int p_first, int p_last);
+        // Reads venue words [p_first, p_last] of member p_member again
+        void Refresh(int p_member, int p_first, int p_last);
+        void Apply(int p_member, int p_word, unsigned long long p_times);
+        void RollUp(int p_word);
+        long HourOf(const time_t& p_time) const;
+    public:
+        // Constructors & destructors
+        explicit SuperSpace(QObject* parent = nullptr) : QObject(parent) {}
+        SuperSpace(unsigned int p_ID, const QString& p_name, double p_longitude, double p_latitude, QObject* parent = nullptr);
+        virtual ~SuperSpace() {}
+
+        // Members
+        // .. Adding a member twice is a no-op
+        void AddSpace(space::Space* p_space);
+        void RemoveSpace(space::Space* p_space);
+
+        // Getters
+        unsigned int GetID() const { return ID; }
+        QString GetName() const { return name; }
+        double GetLongitude() const { return longitude; }
+        double GetLatitude() const { return latitude; }
+        const QVector<space::Space*>& GetSpaces() const { return spaces; }
+        int GetNumberOfSpaces() const { return spaces.size(); }
+        // All rooms together
+        unsigned int GetMaxNumberOfPeople() const;
+
+        // Venue availability in [p_from, p_to), O(words) whatever the number of rooms
+        // .. The axis starts at the first member's origin, earlier hours are not bookable
+        time_t GetOriginTime() const { return originTime; }
+        const QVector<unsigned long long>& GetAnyBooked() const { return anyBooked; }
+        const QVector<unsigned long long>& GetAllBooked() const { return allBooked; }
+        // No room booked at all, the whole venue can be hired
+        bool IsFullyFree(const time_t& p_from, const time_t& p_to) const;
+        // Every room booked every hour (buyout)
+        bool IsBoughtOut(const time_t& p_from, const time_t& p_to) const;
+        // Some room free in each hour, not necessarily the same one
+        // .. False rules the venue out for any booking of the whole window
+        bool HasFreeRoomEachHour(const time_t& p_from, const time_t& p_to) const;
+        int GetFreeRooms(const time_t& p_time) const;
+    };
+}
+
+#endif // SUPERSPACE_H
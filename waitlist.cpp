@@ -0,0 +1,154 @@
+#include <QObject>
+#include <QVector>
+#include <QDateTime>
+#include <QPair>
+
+// User libraries
+#include "waitlist.h"
+#include <algorithm>
+
+namespace space {
+    Waitlist::Waitlist(QObject* parent) : QObject(parent) {
+        expiry.setSingleShot(true);
+        connect(&expiry, &QTimer::timeout, this, [this]() {
+            ExpireBefore((time_t)(QDateTime::currentMSecsSinceEpoch() / 1000));
+        });
+    }
+
+    // Index
+    void Waitlist::Watch(space::Space* p_space) {
+        if (index.contains(p_space)) return;
+        index.insert(p_space, QHash<int, QVector<quint64>>());
+        connect(&p_space->GetTimer(), &Time::WordsChanged, this, [this, p_space](int first, int last) {
+            Released(p_space, first, last);
+        });
+        // .. Requests die with their space, without an Expired
+        connect(p_space, &QObject::destroyed, this, [this, p_space]() {
+            for (const QVector<quint64>& bucket: index.value(p_space))
+                for (quint64 ID: bucket) {
+                    expiries.remove(requests.value(ID).expires, ID);
+                    requests.remove(ID);
+                }
+            index.remove(p_space);
+            emit CountChanged();
+        });
+    }
+    void Waitlist::Index(const Pending& p_request, bool p_add) {
+        const Time& timer = p_request.space->GetTimer();
+        QHash<int, QVector<quint64>>& words = index[p_request.space];
+        const int first = (int)(timer.HourOf(p_request.start) / 64), last = (int)(timer.HourOf(p_request.end) / 64);
+        for (int word = first; word <= last; word++) {
+            if (p_add) {
+                words[word].append(p_request.ID);
+                continue;
+            }
+            QVector<quint64>& bucket = words[word];
+            bucket.removeOne(p_request.ID);
+            if (bucket.isEmpty()) words.remove(word);
+        }
+    }
+    void Waitlist::Drop(quint64 p_request) {
+        const Pending request = requests.take(p_request);
+        Index(request, false);
+        if (request.expires) expiries.remove(request.expires, p_request);
+    }
+
+    // Requests
+    quint64 Waitlist::Request(space::Space* p_space, qint64 p_start, qint64 p_end, int p_priority, qint64 p_expires) {
+        if (!p_space) return 0;
+        Time& timer = p_space->GetTimer();
+        const long startHour = timer.HourOf(p_start), endHour = timer.HourOf(p_end);
+        // .. Also bounds the word buckets Index builds
+        if (!Time::IsBookable(startHour, endHour)) return 0;
+        const quint64 ID = nextRequest++;
+        double price = 0;
+        // .. Only tried when free, a waiting request is not a conflict
+        if (timer.IsFree(startHour, endHour) && timer.AddReservation(p_start, p_end, price)) {
+            emit Granted(ID, p_space->GetID(), p_start, p_end, price);
+            return ID;
+        }
+        Watch(p_space);
+        Pending request;
+        request.ID = ID;
+        request.space = p_space;
+        request.start = p_start;
+        request.end = p_end;
+        request.priority = p_priority;
+        request.expires = p_expires;
+        requests.insert(ID, request);
+        Index(request, true);
+        if (p_expires) {
+            expiries.insert(p_expires, ID);
+            ScheduleExpiry();
+        }
+        emit CountChanged();
+        return ID;
+    }
+    bool Waitlist::Cancel(quint64 p_request) {
+        if (!requests.contains(p_request)) return false;
+        Drop(p_request);
+        emit CountChanged();
+        return true;
+    }
+
+    // Releases
+    void Waitlist::Released(space::Space* p_space, int p_first, int p_last) {
+        if (granting) return;
+        const QHash<int, QVector<quint64>>& words = index[p_space];
+        if (words.isEmpty()) return;
+        // Requests on the changed words, once each
+        QVector<quint64> IDs;
+        for (int word = p_first; word <= p_last; word++) {
+            QHash<int, QVector<quint64>>::const_iterator bucket = words.constFind(word);
+            if (bucket != words.constEnd()) IDs += *bucket;
+        }
+        if (IDs.isEmpty()) return;
+        std::sort(IDs.begin(), IDs.end());
+        IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
+        // .. IDs grow with arrival, so (priority, ID) is priority then FIFO
+        QVector<QPair<int, quint64>> candidates;
+        candidates.reserve(IDs.size());
+        for (quint64 ID: IDs) candidates.append(qMakePair(-requests.value(ID).priority, ID));
+        std::sort(candidates.begin(), candidates.end());
+        Time& timer = p_space->GetTimer();
+        int granted = 0;
+        granting = true;
+        for (const QPair<int, quint64>& candidate: candidates) {
+            const quint64 ID = candidate.second;
+            const Pending request = requests.value(ID);
+            if (!timer.IsFree(timer.HourOf(request.start), timer.HourOf(request.end))) continue;
+            double price = 0;
+            if (!timer.AddReservation(request.start, request.end, price)) continue;
+            Drop(ID);
+            granted++;
+            EVIES_COUNT(WaitlistGranted);
+            emit Granted(ID, p_space->GetID(), request.start, request.end, price);
+        }
+        granting = false;
+        if (granted) emit CountChanged();
+    }
+
+    // Expiry
+    void Waitlist::ExpireBefore(time_t p_now) {
+        int expired = 0;
+        while (!expiries.isEmpty() && expiries.firstKey() <= p_now) {
+            const quint64 ID = expiries.first();
+            const unsigned int spaceID = requests.value(ID).space->GetID();
+            Drop(ID);
+            expired++;
+            EVIES_COUNT(WaitlistExpired);
+            emit Expired(ID, spaceID);
+        }
+        if (expired) emit CountChanged();
+        ScheduleExpiry();
+    }
+    void Waitlist::ScheduleExpiry() {
+        if (expiries.isEmpty()) {
+            expiry.stop();
+            return;
+        }
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        // .. QTimer takes an int, far expiries are rescheduled on the way
+        expiry.start((int)qBound((qint64)0, (qint64)expiries.firstKey() * 1000 - now, (qint64)24 * 3600 * 1000));
+    }
+}
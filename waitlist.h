@@ -0,0 +1,69 @@
+#ifndef WAITLIST_H
+#define WAITLIST_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QMultiMap>
+#include <QTimer>
+
+// User libraries
+#include "space.h"
+#include <ctime>
+
+namespace space {
+    // Reservations waiting for their hours to be freed
+    // .. Waiting requests are indexed by space and by the bitmap words they cover,
+    // .. a change to words [first, last] of a timer only looks at the requests on them
+    // .. Candidates are tried highest priority first, then first come first served,
+    // .. each through AddReservation; a request that does not fit yet keeps waiting
+    // .. and does not hold back the ones behind it
+    class Waitlist : public QObject {
+        Q_OBJECT
+        Q_PROPERTY(int count READ GetCount NOTIFY CountChanged)
+    signals:
+        void Granted(quint64 request, unsigned int spaceID, qint64 start, qint64 end, double price);
+        void Expired(quint64 request, unsigned int spaceID);
+        void CountChanged();
+    private:
+        struct Pending {
+            quint64 ID = 0;
+            space::Space* space = nullptr;
+            // Inclusive, like AddReservation
+            time_t start = 0, end = 0;
+            int priority = 0;
+            // 0 waits until cancelled
+            time_t expires = 0;
+        };
+        QHash<quint64, Pending> requests;
+        // Waiting request IDs by space and word, in arrival order
+        QHash<space::Space*, QHash<int, QVector<quint64>>> index;
+        QMultiMap<time_t, quint64> expiries;
+        QTimer expiry;
+        quint64 nextRequest = 1;
+        // Grants book hours, they never free any, their own changes are ignored
+        bool granting = false;
+
+        void Watch(space::Space* p_space);
+        void Index(const Pending& p_request, bool p_add);
+        void Drop(quint64 p_request);
+        void Released(space::Space* p_space, int p_first, int p_last);
+        void ScheduleExpiry();
+    public:
+        explicit Waitlist(QObject* parent = nullptr);
+        virtual ~Waitlist() {}
+
+        // Books [p_start, p_end] now if free, or waits for it with p_priority until p_expires (0 for never)
+        // .. Returns the request ID, Granted follows either at once or on a release,
+        // .. 0 for an invalid range
+        Q_INVOKABLE quint64 Request(space::Space* p_space, qint64 p_start, qint64 p_end, int p_priority = 0, qint64 p_expires = 0);
+        Q_INVOKABLE bool Cancel(quint64 p_request);
+        // Expires every request due by p_now, driven by a timer otherwise
+        void ExpireBefore(time_t p_now);
+
+        int GetCount() const { return requests.size(); }
+        bool IsWaiting(quint64 p_request) const { return requests.contains(p_request); }
+    };
+}
+
+#endif // WAITLIST_H
@@ -0,0 +1,261 @@
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QSet>
+#include <QElapsedTimer>
+
+// User libraries
+#include "workload.h"
+#include "parallel.h"
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+namespace space {
+    // Random streams
+    // .. One engine per (seed, stream), seeded through SplitMix64
+    static std::mt19937_64 Stream(quint64 p_seed, quint64 p_stream) {
+        quint64 z = p_seed + (p_stream + 1) * 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return std::mt19937_64(z ^ (z >> 31));
+    }
+    static double Uniform(std::mt19937_64& p_engine) {
+        return (p_engine() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    static double Uniform(std::mt19937_64& p_engine, double p_low, double p_high) {
+        return p_low + (p_high - p_low) * Uniform(p_engine);
+    }
+    static bool Chance(std::mt19937_64& p_engine, double p_probability) {
+        return Uniform(p_engine) < p_probability;
+    }
+    // .. Box-Muller, one value per call is enough here
+    static double Normal(std::mt19937_64& p_engine, double p_mean, double p_deviation) {
+        const double u = 1.0 - Uniform(p_engine), v = Uniform(p_engine);
+        return p_mean + p_deviation * std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+    }
+    static double LogNormal(std::mt19937_64& p_engine, double p_median, double p_sigma) {
+        return p_median * std::exp(Normal(p_engine, 0, p_sigma));
+    }
+    static double Clamp(double p_value, double p_low, double p_high) {
+        return std::min(std::max(p_value, p_low), p_high);
+    }
+
+    // Catalogs
+    // .. Area is log-normal, capacity and price follow the area,
+    // .. each space has a quality its review scores scatter around
+    static Space* MakeSpace(unsigned int p_ID, std::mt19937_64& p_engine) {
+        const double area = Clamp(LogNormal(p_engine, 120, 0.8), 10, 5000);
+        const double aspect = Uniform(p_engine, 1, 2.5);
+        const double width = std::sqrt(area / aspect);
+        const unsigned int people = (unsigned int)std::max(2.0, area / Uniform(p_engine, 1.2, 2.5));
+        const unsigned int seats = (unsigned int)(people * Uniform(p_engine, 0.3, 1.0));
+        const double price = std::round(Clamp(LogNormal(p_engine, 500 * std::pow(area / 120, 0.6), 0.4), 50, 20000));
+        Space* space_ptr = new Space(
+            p_ID,
+            QString("Space%1").arg(p_ID),
+            (float)(area / width), (float)width, (float)Uniform(p_engine, 2.7, 8),
+            people,
+            seats, Chance(p_engine, 0.15), Chance(p_engine, 0.2), Chance(p_engine, 0.5),
+            price,
+            Chance(p_engine, 0.2),      // outdoor
+            Chance(p_engine, 0.45),     // catering
+            Chance(p_engine, 0.6),      // natural light
+            Chance(p_engine, 0.9),      // artificial light
+            Chance(p_engine, 0.5),      // projector
+            Chance(p_engine, 0.55),     // sound
+            Chance(p_engine, 0.3));     // cameras
+        const double quality = Clamp(Normal(p_engine, 3.8, 0.5), 1, 5);
+        const int reviews = (int)Clamp(LogNormal(p_engine, 6, 1), 0, 50);
+        // .. Implicitly shared, every review points at the same text
+        static const QString text("Generated review");
+        for (int i = 0; i < reviews; i++)
+            space_ptr->GetReview().AddReview(text, (float)Clamp(std::round(Normal(p_engine, quality, 0.8)), 0, 5));
+        return space_ptr;
+    }
+    QVector<Space*> Workload::MakeSpaces(int p_count, quint64 p_seed, QThread* p_thread) {
+        QThread* target = p_thread ? p_thread : QThread::currentThread();
+        QVector<Space*> spaces(p_count, nullptr);
+        Space** out = spaces.data();
+        // .. A chunk's stream depends on its position only, not on the thread running it
+        ForEachChunk(p_count, [out, p_seed, target](int p_begin, int p_end) {
+            std::mt19937_64 engine = Stream(p_seed, p_begin / ChunkSize);
+            for (int i = p_begin; i < p_end; i++) {
+                out[i] = MakeSpace(i, engine);
+                out[i]->MoveToThread(target);
+            }
+        }, ChunkSize);
+        return spaces;
+    }
+
+    // Traces
+    Trace Workload::MakeTrace(int p_spaces, quint64 p_seed, const TraceSpec& p_spec) {
+        Trace trace;
+        if (p_spaces <= 0) return trace;
+        std::mt19937_64 engine = Stream(p_seed, ~0ULL);
+        // Zipf over popularity ranks, ranks shuffled over the spaces
+        QVector<double> cdf(p_spaces);
+        double total = 0;
+        for (int rank = 0; rank < p_spaces; rank++) cdf[rank] = total += 1.0 / std::pow(rank + 1, p_spec.zipfExponent);
+        QVector<unsigned int> spaceOfRank(p_spaces);
+        for (int i = 0; i < p_spaces; i++) spaceOfRank[i] = i;
+        for (int i = p_spaces - 1; i > 0; i--) std::swap(spaceOfRank[i], spaceOfRank[engine() % (i + 1)]);
+        auto popular = [&]() {
+            const double u = Uniform(engine) * total;
+            const int rank = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+            return spaceOfRank[std::min(rank, p_spaces - 1)];
+        };
+        // Start hour weights over the day, quiet nights, peaks late morning and early evening
+        static const double diurnal[24] = {
+            0.2, 0.1, 0.1, 0.1, 0.1, 0.2, 0.5, 1.0, 2.0, 3.0, 3.5, 3.0,
+            2.0, 2.0, 2.5, 2.5, 3.0, 4.0, 4.5, 4.0, 2.5, 1.5, 0.8, 0.4 };
+        double diurnalCdf[24], diurnalTotal = 0;
+        for (int hour = 0; hour < 24; hour++) diurnalCdf[hour] = diurnalTotal += diurnal[hour];
+
+        // Bookings still open for cancellation
+        Trace open;
+        trace.reserve(p_spec.events);
+        for (int i = 0; i < p_spec.events; i++) {
+            TraceEvent event;
+            if (!open.isEmpty() && Chance(engine, p_spec.cancelRatio)) {
+                const int pick = engine() % open.size();
+                event = open[pick];
+                event.kind = TraceEvent::Cancel;
+                open[pick] = open.last();
+                open.removeLast();
+            } else if (Chance(engine, p_spec.reviewRatio)) {
+                event.kind = TraceEvent::Review;
+                event.space = popular();
+                event.score = (float)Clamp(std::round(Normal(engine, 3.8, 1.0)), 0, 5);
+            } else {
+                event.kind = TraceEvent::Book;
+                event.space = popular();
+                const double u = Uniform(engine) * diurnalTotal;
+                const int hourOfDay = std::lower_bound(diurnalCdf, diurnalCdf + 24, u) - diurnalCdf;
+                event.startHour = (engine() % p_spec.days) * 24 + std::min(hourOfDay, 23);
+                // .. Mostly short meetings, a few long events
+                event.hours = 1;
+                while (event.hours < 12 && Chance(engine, 0.45)) event.hours++;
+                open.append(event);
+            }
+            trace.append(event);
+        }
+        return trace;
+    }
+    void Workload::WriteTrace(const Trace& p_trace, QIODevice& p_device) {
+        QByteArray buffer;
+        buffer.reserve(1 << 16);
+        buffer += "# evies trace 1\n";
+        for (const TraceEvent& event: p_trace) {
+            switch (event.kind) {
+            case TraceEvent::Book: buffer += "b "; break;
+            case TraceEvent::Cancel: buffer += "c "; break;
+            case TraceEvent::Review: buffer += "r "; break;
+            }
+            buffer += QByteArray::number(event.space);
+            buffer += ' ';
+            if (event.kind == TraceEvent::Review) {
+                buffer += QByteArray::number(event.score, 'f', 1);
+            } else {
+                buffer += QByteArray::number(event.startHour);
+                buffer += ' ';
+                buffer += QByteArray::number(event.hours);
+            }
+            buffer += '\n';
+            if (buffer.size() >= (1 << 16) - 64) {
+                p_device.write(buffer);
+                buffer.clear();
+            }
+        }
+        p_device.write(buffer);
+    }
+    bool Workload::ReadTrace(QIODevice& p_device, Trace& p_trace) {
+        p_trace.clear();
+        while (!p_device.atEnd()) {
+            const QByteArray line = p_device.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#')) continue;
+            const QList<QByteArray> fields = line.split(' ');
+            TraceEvent event;
+            bool ok = fields.size() >= 3;
+            if (ok) event.space = fields[1].toUInt(&ok);
+            if (!ok || event.space >= (unsigned int)MaxTraceSpaces) return false;
+            if (fields[0] == "r") {
+                event.kind = TraceEvent::Review;
+                event.score = fields[2].toFloat(&ok);
+            } else if ((fields[0] == "b" || fields[0] == "c") && fields.size() >= 4) {
+                event.kind = fields[0] == "b" ? TraceEvent::Book : TraceEvent::Cancel;
+                event.startHour = fields[2].toUInt(&ok);
+                if (ok) event.hours = fields[3].toUInt(&ok);
+                // .. The last hour must stay bookable, which also keeps startHour + hours from wrapping
+                ok = ok && event.hours > 0 && event.startHour <= (unsigned int)Time::MaxSeriesHours
+                    && event.hours - 1 <= (unsigned int)Time::MaxSeriesHours - event.startHour;
+            } else {
+                ok = false;
+            }
+            if (!ok) return false;
+            p_trace.append(event);
+        }
+        return true;
+    }
+
+    // Replay
+    TraceReplay::Result TraceReplay::Run(SpaceManager& p_manager, const Trace& p_trace, double p_rate) {
+        Result result;
+        const QVector<Space*>& spaces = p_manager.GetSpaces();
+        if (spaces.isEmpty() || p_trace.isEmpty()) return result;
+        // Successful bookings, packed as space:24 | start hour:20 | hours:20
+        // .. Exact for every event ReadTrace accepts: spaces below 2^24, hours within MaxSeriesHours < 2^20
+        static_assert(Workload::MaxTraceSpaces <= (1 << 24) && Time::MaxSeriesHours < (1 << 20), "trace keys overlap");
+        QSet<quint64> booked;
+        auto key = [](const TraceEvent& p_event) {
+            return ((quint64)p_event.space << 40) | ((quint64)p_event.startHour << 20) | p_event.hours;
+        };
+        static const QString text("Replayed review");
+        QVector<qint64> latencies(p_trace.size());
+        QElapsedTimer clock;
+        clock.start();
+        for (int i = 0; i < p_trace.size(); i++) {
+            const TraceEvent& event = p_trace[i];
+            qint64 scheduled = clock.nsecsElapsed();
+            if (p_rate > 0) {
+                scheduled = (qint64)(i * 1e9 / p_rate);
+                // .. Sleep while far ahead, spin for the last stretch
+                qint64 ahead;
+                while ((ahead = scheduled - clock.nsecsElapsed()) > 0) {
+                    if (ahead > 2000000) QThread::usleep((unsigned long)(ahead / 2000));
+                }
+            }
+            Space* space_ptr = spaces[event.space % spaces.size()];
+            Time& timer = space_ptr->GetTimer();
+            switch (event.kind) {
+            case TraceEvent::Book: {
+                double price = 0;
+                if (timer.AddReservation(timer.TimeOfHour(event.startHour), timer.TimeOfHour(event.startHour + event.hours - 1), price)) {
+                    booked.insert(key(event));
+                    result.booked++;
+                } else result.conflicts++;
+                break;
+            }
+            case TraceEvent::Cancel:
+                if (booked.remove(key(event))) {
+                    timer.RemoveReservation(timer.TimeOfHour(event.startHour), timer.TimeOfHour(event.startHour + event.hours - 1));
+                    result.cancelled++;
+                } else result.skipped++;
+                break;
+            case TraceEvent::Review:
+                space_ptr->GetReview().AddReview(text, event.score);
+                result.reviews++;
+                break;
+            }
+            latencies[i] = clock.nsecsElapsed() - scheduled;
+        }
+        result.seconds = clock.nsecsElapsed() / 1e9;
+        result.events = p_trace.size();
+        std::sort(latencies.begin(), latencies.end());
+        result.p50 = latencies[latencies.size() / 2] / 1000.0;
+        result.p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] / 1000.0;
+        result.max = latencies.last() / 1000.0;
+        return result;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <QObject>
+#include <QVector>
+#include <QIODevice>
+#include <QThread>
+
+// User libraries
+#include "space.h"
+
+namespace space {
+    // One step of a booking trace
+    // .. Hours are indexes on the space's timer, a trace replays the same on any day
+    struct TraceEvent {
+        enum Kind : quint8 { Book, Cancel, Review };
+        Kind kind = Book;
+        // Index in the manager's spaces
+        unsigned int space = 0;
+        unsigned int startHour = 0;
+        unsigned int hours = 1;
+        float score = 0;
+    };
+    typedef QVector<TraceEvent> Trace;
+
+    // Seeded synthetic catalogs and booking traces
+    // .. Same seed, same output, whatever the thread count
+    // .. Only the engine's raw output is used, distributions are computed here
+    // .. so results do not depend on the standard library either
+    class Workload {
+    public:
+        struct TraceSpec {
+            int events = 100000;
+            // Bookings start within this many days of the origin
+            int days = 90;
+            // Space popularity follows Zipf with this exponent
+            double zipfExponent = 1.1;
+            // Share of events cancelling an earlier booking, and reviewing a space
+            double cancelRatio = 0.1;
+            double reviewRatio = 0.05;
+        };
+        enum { ChunkSize = 4096 };
+
+        // Catalog of p_count spaces, built in parallel chunks with one random stream each
+        // .. The spaces are moved to p_thread, the calling thread by default
+        static QVector<Space*> MakeSpaces(int p_count, quint64 p_seed, QThread* p_thread = nullptr);
+        // Bookings with Zipf-skewed popularity and diurnal start hours,
+        // .. plus cancellations of earlier bookings and reviews
+        static Trace MakeTrace(int p_spaces, quint64 p_seed, const TraceSpec& p_spec);
+        static Trace MakeTrace(int p_spaces, quint64 p_seed) { return MakeTrace(p_spaces, p_seed, TraceSpec()); }
+
+        // Text form, one event per line
+        // .. "b <space> <start hour> <hours>", "c <space> <start hour> <hours>", "r <space> <score>"
+        // .. Reading refuses spaces from MaxTraceSpaces and hours past Time::MaxSeriesHours
+        enum { MaxTraceSpaces = 1 << 24 };
+        static void WriteTrace(const Trace& p_trace, QIODevice& p_device);
+        static bool ReadTrace(QIODevice& p_device, Trace& p_trace);
+    };
+
+    // Drives a manager's spaces from a trace
+    class TraceReplay {
+    public:
+        struct Result {
+            quint64 events = 0;
+            quint64 booked = 0, conflicts = 0;
+            // Cancels of bookings that never went through are skipped
+            quint64 cancelled = 0, skipped = 0;
+            quint64 reviews = 0;
+            double seconds = 0;
+            double p50 = 0, p99 = 0, max = 0;   // microseconds
+        };
+        // p_rate is in events per second, 0 runs flat out
+        // .. Latency counts from each event's scheduled time, so falling behind shows up
+        static Result Run(SpaceManager& p_manager, const Trace& p_trace, double p_rate);
+    };
+}
+
+#endif // WORKLOAD_H